@@ -214,6 +214,13 @@ enum cfs_hash_tag {
          * change on hash table is non-blocking
          */
         CFS_HASH_NBLK_CHANGE    = 1 << 13,
+        /**
+         * items can be looked up under rcu_read_lock() without taking
+         * the bucket lock, see cfs_hash_bd_peek_rcu(). Items must not be
+         * freed before a RCU grace period has passed since removal, and
+         * rehash is not allowed.
+         */
+        CFS_HASH_RCU_LOOKUP     = 1 << 14,
         /** NB, we typed hs_flags as  __u16, please change it
          * if you need to extend >=16 flags */
 };
@@ -481,6 +488,13 @@ cfs_hash_with_nblk_change(cfs_hash_t *hs)
         return (hs->hs_flags & CFS_HASH_NBLK_CHANGE) != 0;
 }
 
+static inline int
+cfs_hash_with_rcu_lookup(cfs_hash_t *hs)
+{
+	/* readers can walk hlists of this hash-table w/o bucket lock */
+	return (hs->hs_flags & CFS_HASH_RCU_LOOKUP) != 0;
+}
+
 static inline int
 cfs_hash_is_exiting(cfs_hash_t *hs)
 {       /* cfs_hash_destroy is called */
@@ -689,6 +703,8 @@ cfs_hlist_node_t *cfs_hash_bd_lookup_locked(cfs_hash_t *hs,
                                             cfs_hash_bd_t *bd, const void *key);
 cfs_hlist_node_t *cfs_hash_bd_peek_locked(cfs_hash_t *hs,
 					  cfs_hash_bd_t *bd, const void *key);
+cfs_hlist_node_t *cfs_hash_bd_peek_rcu(cfs_hash_t *hs,
+				       cfs_hash_bd_t *bd, const void *key);
 cfs_hlist_node_t *cfs_hash_bd_findadd_locked(cfs_hash_t *hs,
                                              cfs_hash_bd_t *bd, const void *key,
                                              cfs_hlist_node_t *hnode,
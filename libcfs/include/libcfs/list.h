@@ -26,6 +26,7 @@
 #if defined (__linux__) && defined(__KERNEL__)
 
 #include <linux/list.h>
+#include <linux/rculist.h>
 
 typedef struct list_head cfs_list_t;
 
@@ -68,6 +69,12 @@ typedef struct list_head cfs_list_t;
 #define cfs_list_for_each_entry_continue(pos, head, member) \
         list_for_each_entry_continue(pos, head, member)
 
+#define cfs_list_add_rcu(entry, head)        list_add_rcu(entry, head)
+#define cfs_list_add_tail_rcu(entry, head)   list_add_tail_rcu(entry, head)
+#define cfs_list_del_rcu(entry)              list_del_rcu(entry)
+#define cfs_list_for_each_entry_rcu(pos, head, member) \
+	list_for_each_entry_rcu(pos, head, member)
+
 #define CFS_LIST_HEAD_INIT(n)		     LIST_HEAD_INIT(n)
 #define CFS_LIST_HEAD(n)		     LIST_HEAD(n)
 #define CFS_INIT_LIST_HEAD(p)		     INIT_LIST_HEAD(p)
@@ -87,10 +94,16 @@ typedef struct hlist_node cfs_hlist_node_t;
 #define cfs_hlist_add_before(n, next)      hlist_add_before(n, next)
 #define cfs_hlist_add_after(n, next)       hlist_add_after(n, next)
 
+#define cfs_hlist_add_head_rcu(n, h)       hlist_add_head_rcu(n, h)
+#define cfs_hlist_del_init_rcu(n)          hlist_del_init_rcu(n)
+
 #define cfs_hlist_entry(ptr, type, member) hlist_entry(ptr, type, member)
 #define cfs_hlist_for_each(pos, head)      hlist_for_each(pos, head)
 #define cfs_hlist_for_each_safe(pos, n, head) \
         hlist_for_each_safe(pos, n, head)
+#define cfs_hlist_for_each_rcu(pos, head)                                \
+	for (pos = rcu_dereference((head)->first); pos != NULL;          \
+	     pos = rcu_dereference(pos->next))
 #ifdef HAVE_HLIST_FOR_EACH_3ARG
 #define cfs_hlist_for_each_entry(tpos, pos, head, member) \
 	pos = NULL; hlist_for_each_entry(tpos, head, member)
@@ -468,6 +481,14 @@ static inline void cfs_hlist_add_after(cfs_hlist_node_t *n,
 		next->next->pprev  = &next->next;
 }
 
+/* no concurrent readers outside the kernel, plain list ops are enough */
+#define cfs_list_add_rcu(entry, head)      cfs_list_add(entry, head)
+#define cfs_list_add_tail_rcu(entry, head) cfs_list_add_tail(entry, head)
+#define cfs_list_del_rcu(entry)            cfs_list_del(entry)
+
+#define cfs_hlist_add_head_rcu(n, h)       cfs_hlist_add_head(n, h)
+#define cfs_hlist_del_init_rcu(n)          cfs_hlist_del_init(n)
+
 #define cfs_hlist_entry(ptr, type, member) container_of(ptr,type,member)
 
 #define cfs_hlist_for_each(pos, head) \
@@ -478,6 +499,8 @@ static inline void cfs_hlist_add_after(cfs_hlist_node_t *n,
 	for (pos = (head)->first; pos && (n = pos->next, 1); \
 	     pos = n)
 
+#define cfs_hlist_for_each_rcu(pos, head) cfs_hlist_for_each(pos, head)
+
 /**
  * Iterate over an hlist of given type
  * \param tpos	 the type * to use as a loop counter.
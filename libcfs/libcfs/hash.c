@@ -262,7 +262,10 @@ static int
 cfs_hash_hh_hnode_add(cfs_hash_t *hs, cfs_hash_bd_t *bd,
                       cfs_hlist_node_t *hnode)
 {
-        cfs_hlist_add_head(hnode, cfs_hash_hh_hhead(hs, bd));
+	if (cfs_hash_with_rcu_lookup(hs))
+		cfs_hlist_add_head_rcu(hnode, cfs_hash_hh_hhead(hs, bd));
+	else
+		cfs_hlist_add_head(hnode, cfs_hash_hh_hhead(hs, bd));
         return -1; /* unknown depth */
 }
 
@@ -270,7 +273,10 @@ static int
 cfs_hash_hh_hnode_del(cfs_hash_t *hs, cfs_hash_bd_t *bd,
                       cfs_hlist_node_t *hnode)
 {
-        cfs_hlist_del_init(hnode);
+	if (cfs_hash_with_rcu_lookup(hs))
+		cfs_hlist_del_init_rcu(hnode);
+	else
+		cfs_hlist_del_init(hnode);
         return -1; /* unknown depth */
 }
 
@@ -304,7 +310,10 @@ cfs_hash_hd_hnode_add(cfs_hash_t *hs, cfs_hash_bd_t *bd,
 {
         cfs_hash_head_dep_t *hh = container_of(cfs_hash_hd_hhead(hs, bd),
                                                cfs_hash_head_dep_t, hd_head);
-        cfs_hlist_add_head(hnode, &hh->hd_head);
+	if (cfs_hash_with_rcu_lookup(hs))
+		cfs_hlist_add_head_rcu(hnode, &hh->hd_head);
+	else
+		cfs_hlist_add_head(hnode, &hh->hd_head);
         return ++hh->hd_depth;
 }
 
@@ -314,7 +323,10 @@ cfs_hash_hd_hnode_del(cfs_hash_t *hs, cfs_hash_bd_t *bd,
 {
         cfs_hash_head_dep_t *hh = container_of(cfs_hash_hd_hhead(hs, bd),
                                                cfs_hash_head_dep_t, hd_head);
-        cfs_hlist_del_init(hnode);
+	if (cfs_hash_with_rcu_lookup(hs))
+		cfs_hlist_del_init_rcu(hnode);
+	else
+		cfs_hlist_del_init(hnode);
         return --hh->hd_depth;
 }
 
@@ -672,6 +684,30 @@ cfs_hash_bd_peek_locked(cfs_hash_t *hs, cfs_hash_bd_t *bd, const void *key)
 }
 EXPORT_SYMBOL(cfs_hash_bd_peek_locked);
 
+/**
+ * Lockless version of cfs_hash_bd_peek_locked() for hash-tables created
+ * with CFS_HASH_RCU_LOOKUP.
+ *
+ * Caller must hold rcu_read_lock(). The returned item has no reference
+ * and may be on its way out of the hash-table, so caller has to take a
+ * reference in a way that fails for dying items (e.g. atomic_inc_not_zero)
+ * before dropping rcu_read_lock().
+ */
+cfs_hlist_node_t *
+cfs_hash_bd_peek_rcu(cfs_hash_t *hs, cfs_hash_bd_t *bd, const void *key)
+{
+	cfs_hlist_node_t *ehnode;
+
+	LASSERT(cfs_hash_with_rcu_lookup(hs));
+
+	cfs_hlist_for_each_rcu(ehnode, cfs_hash_bd_hhead(hs, bd)) {
+		if (cfs_hash_keycmp(hs, key, ehnode))
+			return ehnode;
+	}
+	return NULL;
+}
+EXPORT_SYMBOL(cfs_hash_bd_peek_rcu);
+
 cfs_hlist_node_t *
 cfs_hash_bd_findadd_locked(cfs_hash_t *hs, cfs_hash_bd_t *bd,
                            const void *key, cfs_hlist_node_t *hnode,
@@ -1047,6 +1083,9 @@ cfs_hash_create(char *name, unsigned cur_bits, unsigned max_bits,
         LASSERT(ergo((flags & CFS_HASH_REHASH) == 0, cur_bits == max_bits));
         LASSERT(ergo((flags & CFS_HASH_REHASH) != 0,
                      (flags & CFS_HASH_NO_LOCK) == 0));
+	/* RCU readers rely on stable buckets and head-insertion */
+	LASSERT(ergo((flags & CFS_HASH_RCU_LOOKUP) != 0,
+		     (flags & (CFS_HASH_REHASH | CFS_HASH_ADD_TAIL)) == 0));
         LASSERT(ergo((flags & CFS_HASH_REHASH_KEY) != 0,
                       ops->hs_keycpy != NULL));
 
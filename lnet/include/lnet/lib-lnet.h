@@ -58,6 +58,9 @@
 
 extern lnet_t  the_lnet;                        /* THE network */
 
+/* LNet is allocated failure locations 0xe000 to 0xffff, the core has 0xe0XX */
+#define CFS_FAIL_LNET_SEND_RAIL		0xe001	/* fail_val: rail index */
+
 #if !defined(__KERNEL__) || defined(LNET_USE_LIB_FREELIST)
 /* 1 CPT, simplify implementation... */
 # define LNET_CPT_MAX_BITS      0
@@ -637,19 +640,20 @@ lnet_handle2me(lnet_handle_me_t *handle)
 static inline void
 lnet_peer_addref_locked(lnet_peer_t *lp)
 {
-        LASSERT (lp->lp_refcount > 0);
-        lp->lp_refcount++;
+	LASSERT(cfs_atomic_read(&lp->lp_refcount) > 0);
+	cfs_atomic_inc(&lp->lp_refcount);
 }
 
 extern void lnet_destroy_peer_locked(lnet_peer_t *lp);
 
+/* NB: the last reference is only dropped under lnet_net_lock(lp->lp_cpt),
+ * lnet_find_peer() never takes a reference on a peer without one */
 static inline void
 lnet_peer_decref_locked(lnet_peer_t *lp)
 {
-        LASSERT (lp->lp_refcount > 0);
-        lp->lp_refcount--;
-        if (lp->lp_refcount == 0)
-                lnet_destroy_peer_locked(lp);
+	LASSERT(cfs_atomic_read(&lp->lp_refcount) > 0);
+	if (cfs_atomic_dec_and_test(&lp->lp_refcount))
+		lnet_destroy_peer_locked(lp);
 }
 
 static inline int
@@ -767,6 +771,7 @@ void lnet_prep_send(lnet_msg_t *msg, int type, lnet_process_id_t target,
 int lnet_send(lnet_nid_t nid, lnet_msg_t *msg, lnet_nid_t rtr_nid);
 void lnet_return_tx_credits_locked(lnet_msg_t *msg);
 void lnet_return_rx_credits_locked(lnet_msg_t *msg);
+int lnet_post_routed_recv_locked(lnet_msg_t *msg, int do_recv);
 
 /* portals functions */
 /* portals attributes */
@@ -959,11 +964,21 @@ int lnet_parse_networks (cfs_list_t *nilist, char *networks);
 int lnet_nid2peer_locked(lnet_peer_t **lpp, lnet_nid_t nid, int cpt);
 lnet_peer_t *lnet_find_peer_locked(struct lnet_peer_table *ptable,
 				   lnet_nid_t nid);
+lnet_peer_t *lnet_find_peer(lnet_nid_t nid, int cpt);
 void lnet_peer_tables_cleanup(void);
 void lnet_peer_tables_destroy(void);
 int lnet_peer_tables_create(void);
 void lnet_debug_peer(lnet_nid_t nid);
 
+int lnet_health_value(struct lnet_health *health);
+void lnet_health_fail(struct lnet_health *health);
+int lnet_resend(lnet_msg_t *msg, int status);
+
+int lnet_rails_create(char *rails);
+void lnet_rails_destroy(void);
+struct lnet_peer_rail *lnet_rail_select(lnet_nid_t nid);
+lnet_nid_t lnet_rail_primary(lnet_nid_t nid);
+
 #ifndef __KERNEL__
 static inline int
 lnet_parse_int_tunable(int *value, char *name)
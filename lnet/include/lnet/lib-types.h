@@ -181,6 +181,7 @@ typedef struct {
 
 /* forward refs */
 struct lnet_libmd;
+struct lnet_peer_rail;
 
 typedef struct lnet_msg {
         cfs_list_t            msg_activelist;
@@ -217,9 +218,13 @@ typedef struct lnet_msg {
         unsigned int          msg_rtrcredit:1;    /* taken a globel router credit */
         unsigned int          msg_peerrtrcredit:1; /* taken a peer router credit */
         unsigned int          msg_onactivelist:1; /* on the activelist */
+	/* # times resent on another path */
+	unsigned int		msg_retry_count:4;
 
         struct lnet_peer     *msg_txpeer;         /* peer I'm sending to */
         struct lnet_peer     *msg_rxpeer;         /* peer I received from */
+	/* multi-rail peer NID this message is accounted to */
+	struct lnet_peer_rail	*msg_rail;
 
         void                 *msg_private;
         struct lnet_libmd    *msg_md;
@@ -402,6 +407,14 @@ typedef struct {
         __u32      ns_unused;
 } WIRE_ATTR lnet_ni_status_t;
 
+/* health of an NI or a peer NI, see lnet_health_value() */
+#define LNET_HEALTH_MAX		1000
+
+struct lnet_health {
+	int			lh_deficit;	/* LNET_HEALTH_MAX - health */
+	long			lh_stamp;	/* when it last degraded (sec) */
+};
+
 struct lnet_tx_queue {
 	int			tq_credits;	/* # tx credits free */
 	int			tq_credits_min;	/* lowest it's been */
@@ -409,6 +422,15 @@ struct lnet_tx_queue {
 	cfs_list_t		tq_delayed;	/* delayed TXs */
 };
 
+/* per-CPT traffic counters of an NI, protected by lnet_net_lock(cpt) */
+struct lnet_ni_stats {
+	__u64			nis_send_count;	/* # messages sent */
+	__u64			nis_send_length; /* # bytes sent */
+	__u64			nis_recv_count;	/* # messages received */
+	__u64			nis_recv_length; /* # bytes received */
+	__u64			nis_errors;	/* # failed messages */
+};
+
 #define LNET_MAX_INTERFACES   16
 
 typedef struct lnet_ni {
@@ -437,8 +459,10 @@ typedef struct lnet_ni {
 	lnd_t			*ni_lnd;	/* procedural interface */
 	struct lnet_tx_queue	**ni_tx_queues;	/* percpt TX queues */
 	int			**ni_refs;	/* percpt reference count */
+	struct lnet_ni_stats	**ni_stats;	/* percpt traffic counters */
 	long			ni_last_alive;	/* when I was last alive */
 	lnet_ni_status_t	*ni_status;	/* my health status */
+	struct lnet_health	ni_health;	/* protected by ni_lock */
 	/* equivalent interfaces to use */
 	char			*ni_interfaces[LNET_MAX_INTERFACES];
 } lnet_ni_t;
@@ -496,7 +520,7 @@ typedef struct lnet_peer {
         cfs_time_t        lp_last_query;        /* when lp_ni was queried last time */
         lnet_ni_t        *lp_ni;                /* interface peer is on */
         lnet_nid_t        lp_nid;               /* peer's NID */
-        int               lp_refcount;          /* # refs */
+	cfs_atomic_t		lp_refcount;	/* # refs */
 	int			lp_cpt;		/* CPT this peer attached on */
 	/* # refs from lnet_route_t::lr_gateway */
 	int			lp_rtr_refcount;
@@ -504,6 +528,7 @@ typedef struct lnet_peer {
 	unsigned int		lp_ping_feats;
 	cfs_list_t		lp_routes;	/* routers on this peer */
 	lnet_rc_data_t		*lp_rcd;	/* router checker state */
+	struct lnet_health	lp_health;	/* send health */
 } lnet_peer_t;
 
 /* peer hash size */
@@ -518,6 +543,36 @@ struct lnet_peer_table {
 	cfs_list_t		*pt_hash;	/* NID->peer hash */
 };
 
+/* max # NIDs of a multi-rail peer */
+#define LNET_MAX_RAILS		4
+
+/* One NID of a multi-rail peer. Rail sets are built from the "peer_rails"
+ * tunable at startup and never change until shutdown, so they are looked up
+ * without locking. Counters are updated under lnet_net_lock() of the CPT
+ * of pr_nid, and read racily to pick the least loaded rail. */
+struct lnet_peer_rail {
+	cfs_list_t		pr_hash;	/* chain on ln_rail_hash */
+	struct lnet_rail_set	*pr_set;	/* set I belong to */
+	lnet_nid_t		pr_nid;		/* peer NID of this rail */
+	lnet_nid_t		pr_ni_nid;	/* my NID on the same net */
+	struct lnet_ni		*pr_ni;		/* my NI on the same net */
+	struct lnet_health	pr_health;	/* send health */
+	int			pr_inflight;	/* # messages in flight */
+	unsigned int		pr_inflight_nob; /* # bytes in flight */
+	__u64			pr_send_count;	/* # messages sent */
+	__u64			pr_send_length;	/* # bytes sent */
+	__u64			pr_errors;	/* # failed sends */
+};
+
+/* all NIDs of a multi-rail peer, the first one is its primary NID */
+struct lnet_rail_set {
+	cfs_list_t		rs_list;	/* chain on ln_rail_sets */
+	int			rs_nrails;	/* # NIDs in rs_rails */
+	int			rs_self;	/* this node */
+	unsigned int		rs_rotor;	/* tie breaker */
+	struct lnet_peer_rail	rs_rails[LNET_MAX_RAILS];
+};
+
 /* peer aliveness is enabled only on routers for peers in a network where the
  * lnet_ni_t::ni_peertimeout has been set to a positive value */
 #define lnet_peer_aliveness_enabled(lp) (the_lnet.ln_routing != 0 && \
@@ -551,6 +606,11 @@ typedef struct {
         int        rbp_nbuffers;         /* # buffers */
         int        rbp_credits;          /* # free buffers / blocked messages */
         int        rbp_mincredits;       /* low water mark */
+	int	   rbp_nmin;		 /* rebalancer shrinks to no less */
+	int	   rbp_nmax;		 /* rebalancer grows to no more */
+	int	   rbp_lowcredits;	 /* low water mark since rebalance */
+	__u64	   rbp_nwaits;		 /* # messages blocked for a buffer */
+	__u64	   rbp_nwaits_seen;	 /* rbp_nwaits at last rebalance */
 } lnet_rtrbufpool_t;
 
 typedef struct {
@@ -746,6 +806,10 @@ typedef struct
 	struct lnet_peer_table		**ln_peer_tables;
 	/* failure simulation */
 	cfs_list_t			ln_test_peers;
+	/* multi-rail peers */
+	cfs_list_t			ln_rail_sets;
+	/* NID->rail hash, NULL if there is no multi-rail peer */
+	cfs_list_t			*ln_rail_hash;
 
 	cfs_list_t			ln_nis;		/* LND instances */
 	/* NIs bond on specific CPT(s) */
@@ -47,9 +47,11 @@
 
 #define LST_FEAT_NONE		(0)
 #define LST_FEAT_BULK_LEN	(1 << 0)	/* enable variable page size */
+#define LST_FEAT_LAT_HIST	(1 << 1)	/* RPC latency histograms */
 
 #define LST_FEATS_EMPTY		(LST_FEAT_NONE)
-#define LST_FEATS_MASK		(LST_FEAT_NONE | LST_FEAT_BULK_LEN)
+#define LST_FEATS_MASK		(LST_FEAT_NONE | LST_FEAT_BULK_LEN | \
+				 LST_FEAT_LAT_HIST)
 
 #define LST_NAME_SIZE           32              /* max name buffer length */
 
@@ -408,6 +410,7 @@ typedef struct {
         int                     lstio_sta_count;        /* IN: # of pid */
         lnet_process_id_t      *lstio_sta_idsp;         /* IN: pid */
         cfs_list_t             *lstio_sta_resultp;      /* OUT: list head of result buffer */
+	int			lstio_sta_lat;		/* IN: latency histograms? */
 } lstio_stat_args_t;
 
 typedef enum {
@@ -492,4 +495,14 @@ typedef struct {
         __u32 ping_errors;
 } WIRE_ATTR sfw_counters_t;
 
+/** # of log2 buckets of test RPC latency, the last one is open-ended */
+#define LST_LAT_NBUCKETS	26
+
+typedef struct {
+	/** sum of latencies of RPCs counted in buckets, in usecs */
+	__u64 lat_total_us;
+	/** # of test RPCs completed in [2^i, 2^(i+1)) usecs, [0, 2) for 0 */
+	__u32 lat_buckets[LST_LAT_NBUCKETS];
+} WIRE_ATTR sfw_lat_counters_t;
+
 #endif
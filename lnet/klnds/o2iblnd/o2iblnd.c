@@ -1542,6 +1542,7 @@ kiblnd_fail_fmr_poolset(kib_fmr_poolset_t *fps, cfs_list_t *zombies)
                 else
                         cfs_list_add(&fpo->fpo_list, &fps->fps_failed_pool_list);
         }
+	fps->fps_npools = 0;
 
 	spin_unlock(&fps->fps_lock);
 }
@@ -1549,7 +1550,20 @@ kiblnd_fail_fmr_poolset(kib_fmr_poolset_t *fps, cfs_list_t *zombies)
 static void
 kiblnd_fini_fmr_poolset(kib_fmr_poolset_t *fps)
 {
+	unsigned long	flags;
+
 	if (fps->fps_net != NULL) { /* initialized? */
+		/* connd mustn't grow it any more */
+		spin_lock_irqsave(&kiblnd_data.kib_connd_lock, flags);
+		cfs_list_del_init(&fps->fps_connd_list);
+		while (kiblnd_data.kib_connd_fmr_growing == fps) {
+			spin_unlock_irqrestore(&kiblnd_data.kib_connd_lock,
+					       flags);
+			cfs_pause(cfs_time_seconds(1) / 100);
+			spin_lock_irqsave(&kiblnd_data.kib_connd_lock, flags);
+		}
+		spin_unlock_irqrestore(&kiblnd_data.kib_connd_lock, flags);
+
 		kiblnd_destroy_fmr_pool_list(&fps->fps_failed_pool_list);
 		kiblnd_destroy_fmr_pool_list(&fps->fps_pool_list);
 	}
@@ -1571,10 +1585,13 @@ kiblnd_init_fmr_poolset(kib_fmr_poolset_t *fps, int cpt, kib_net_t *net,
 	spin_lock_init(&fps->fps_lock);
 	CFS_INIT_LIST_HEAD(&fps->fps_pool_list);
 	CFS_INIT_LIST_HEAD(&fps->fps_failed_pool_list);
+	CFS_INIT_LIST_HEAD(&fps->fps_connd_list);
 
-        rc = kiblnd_create_fmr_pool(fps, &fpo);
-        if (rc == 0)
-                cfs_list_add_tail(&fpo->fpo_list, &fps->fps_pool_list);
+	rc = kiblnd_create_fmr_pool(fps, &fpo);
+	if (rc == 0) {
+		cfs_list_add_tail(&fpo->fpo_list, &fps->fps_pool_list);
+		fps->fps_npools = 1;
+	}
 
         return rc;
 }
@@ -1612,6 +1629,7 @@ kiblnd_fmr_pool_unmap(kib_fmr_t *fmr, int status)
 
 	spin_lock(&fps->fps_lock);
         fpo->fpo_map_count --;  /* decref the pool */
+	fps->fps_nmapped--;
 
         cfs_list_for_each_entry_safe(fpo, tmp, &fps->fps_pool_list, fpo_list) {
                 /* the first pool is persistent */
@@ -1621,6 +1639,7 @@ kiblnd_fmr_pool_unmap(kib_fmr_t *fmr, int status)
                 if (kiblnd_fmr_pool_is_idle(fpo, now)) {
                         cfs_list_move(&fpo->fpo_list, &zombies);
                         fps->fps_version ++;
+			fps->fps_npools--;
                 }
         }
 	spin_unlock(&fps->fps_lock);
@@ -1629,14 +1648,78 @@ kiblnd_fmr_pool_unmap(kib_fmr_t *fmr, int status)
                 kiblnd_destroy_fmr_pool_list(&zombies);
 }
 
+/* Allocate a new pool for @fps, called holding fps_lock after setting
+ * fps_increasing, the lock is dropped while creating the pool */
+static int
+kiblnd_grow_fmr_poolset(kib_fmr_poolset_t *fps)
+{
+	kib_fmr_pool_t	*fpo;
+	ktime_t		 start = ktime_get();
+	__u64		 usecs;
+	int		 rc;
+
+	LASSERT(fps->fps_increasing);
+	spin_unlock(&fps->fps_lock);
+
+	CDEBUG(D_NET, "Allocate new FMR pool\n");
+	rc = kiblnd_create_fmr_pool(fps, &fpo);
+	usecs = ktime_to_us(ktime_sub(ktime_get(), start));
+
+	spin_lock(&fps->fps_lock);
+	fps->fps_increasing = 0;
+	if (rc == 0) {
+		fps->fps_version++;
+		fps->fps_npools++;
+		fps->fps_ngrows++;
+		fps->fps_grow_usecs += usecs;
+		if (usecs > fps->fps_grow_usecs_max)
+			fps->fps_grow_usecs_max = usecs;
+		cfs_list_add_tail(&fpo->fpo_list, &fps->fps_pool_list);
+	} else {
+		fps->fps_next_retry = cfs_time_shift(IBLND_POOL_RETRY);
+	}
+
+	return rc;
+}
+
+/* Should connd allocate a new pool before @fps runs out of FMRs?
+ * Called holding fps_lock */
+static int
+kiblnd_fmr_poolset_low(kib_fmr_poolset_t *fps)
+{
+	int	pct = *kiblnd_tunables.kib_fmr_prefetch;
+
+	if (pct <= 0 || fps->fps_prefetch || fps->fps_increasing ||
+	    cfs_time_before(cfs_time_current(), fps->fps_next_retry))
+		return 0;
+
+	return fps->fps_nmapped * 100 >=
+	       fps->fps_npools * fps->fps_pool_size * pct;
+}
+
+/* called by connd for pool-sets queued by kiblnd_fmr_pool_map() */
+void
+kiblnd_fmr_pool_prefetch(kib_fmr_poolset_t *fps)
+{
+	spin_lock(&fps->fps_lock);
+	fps->fps_prefetch = 0;
+	if (kiblnd_fmr_poolset_low(fps)) {
+		fps->fps_increasing = 1;
+		kiblnd_grow_fmr_poolset(fps);
+	}
+	spin_unlock(&fps->fps_lock);
+}
+
 int
 kiblnd_fmr_pool_map(kib_fmr_poolset_t *fps, __u64 *pages, int npages,
                     __u64 iov, kib_fmr_t *fmr)
 {
-        struct ib_pool_fmr *pfmr;
-        kib_fmr_pool_t     *fpo;
-        __u64               version;
-        int                 rc;
+	struct ib_pool_fmr *pfmr;
+	kib_fmr_pool_t     *fpo;
+	unsigned long	    flags;
+	__u64               version;
+	int		    prefetch;
+	int		    waited = 0;
 
  again:
 	spin_lock(&fps->fps_lock);
@@ -1644,8 +1727,29 @@ kiblnd_fmr_pool_map(kib_fmr_poolset_t *fps, __u64 *pages, int npages,
 	cfs_list_for_each_entry(fpo, &fps->fps_pool_list, fpo_list) {
 		fpo->fpo_deadline = cfs_time_shift(IBLND_POOL_DEADLINE);
 		fpo->fpo_map_count++;
+		fps->fps_nmapped++;
+		/* assume success, no need to relock to count it */
+		if (waited)
+			fps->fps_nmisses++;
+		else
+			fps->fps_nhits++;
+
+		prefetch = kiblnd_fmr_poolset_low(fps);
+		if (prefetch)
+			fps->fps_prefetch = 1;
 		spin_unlock(&fps->fps_lock);
 
+		if (prefetch) {
+			/* let connd allocate the next pool before this
+			 * pool-set runs out of FMRs */
+			spin_lock_irqsave(&kiblnd_data.kib_connd_lock, flags);
+			cfs_list_add_tail(&fps->fps_connd_list,
+					  &kiblnd_data.kib_connd_fmr_ps);
+			wake_up(&kiblnd_data.kib_connd_waitq);
+			spin_unlock_irqrestore(&kiblnd_data.kib_connd_lock,
+					       flags);
+		}
+
                 pfmr = ib_fmr_pool_map_phys(fpo->fpo_fmr_pool,
                                             pages, npages, iov);
                 if (likely(!IS_ERR(pfmr))) {
@@ -1656,6 +1760,11 @@ kiblnd_fmr_pool_map(kib_fmr_poolset_t *fps, __u64 *pages, int npages,
 
 		spin_lock(&fps->fps_lock);
 		fpo->fpo_map_count--;
+		fps->fps_nmapped--;
+		if (waited)
+			fps->fps_nmisses--;
+		else
+			fps->fps_nhits--;
 		if (PTR_ERR(pfmr) != -EAGAIN) {
 			spin_unlock(&fps->fps_lock);
 			return PTR_ERR(pfmr);
@@ -1668,6 +1777,8 @@ kiblnd_fmr_pool_map(kib_fmr_poolset_t *fps, __u64 *pages, int npages,
 		}
 	}
 
+	waited = 1;
+
 	if (fps->fps_increasing) {
 		spin_unlock(&fps->fps_lock);
 		CDEBUG(D_NET, "Another thread is allocating new "
@@ -1684,21 +1795,57 @@ kiblnd_fmr_pool_map(kib_fmr_poolset_t *fps, __u64 *pages, int npages,
 	}
 
 	fps->fps_increasing = 1;
+	kiblnd_grow_fmr_poolset(fps);
 	spin_unlock(&fps->fps_lock);
 
-	CDEBUG(D_NET, "Allocate new FMR pool\n");
-	rc = kiblnd_create_fmr_pool(fps, &fpo);
-	spin_lock(&fps->fps_lock);
-	fps->fps_increasing = 0;
-	if (rc == 0) {
-		fps->fps_version++;
-		cfs_list_add_tail(&fpo->fpo_list, &fps->fps_pool_list);
-	} else {
-		fps->fps_next_retry = cfs_time_shift(IBLND_POOL_RETRY);
+	goto again;
+}
+
+int
+kiblnd_fmr_pool_stats(char *str, int size)
+{
+	kib_fmr_poolset_t	*fps;
+	kib_dev_t		*dev;
+	kib_net_t		*net;
+	unsigned long		 flags;
+	char			*s = str;
+	int			 i;
+
+	s += snprintf(s, str + size - s, "dev cpt pools mapped hits misses "
+		      "grows grow_us grow_max_us\n");
+
+	read_lock_irqsave(&kiblnd_data.kib_global_lock, flags);
+	cfs_list_for_each_entry(dev, &kiblnd_data.kib_devs, ibd_list) {
+		cfs_list_for_each_entry(net, &dev->ibd_nets, ibn_list) {
+			/* pools are freed once it's shutting down */
+			if (net->ibn_shutdown || net->ibn_fmr_ps == NULL)
+				continue;
+
+			cfs_cpt_for_each(i, lnet_cpt_table()) {
+				if (str + size - s <= 0)
+					break;
+
+				fps = net->ibn_fmr_ps[i];
+				if (fps->fps_net == NULL) /* not on my CPTs */
+					continue;
+
+				spin_lock(&fps->fps_lock);
+				s += snprintf(s, str + size - s,
+					      "%s %d %d %d "LPU64" "LPU64" "
+					      LPU64" "LPU64" "LPU64"\n",
+					      dev->ibd_ifname, i,
+					      fps->fps_npools, fps->fps_nmapped,
+					      fps->fps_nhits, fps->fps_nmisses,
+					      fps->fps_ngrows,
+					      fps->fps_grow_usecs,
+					      fps->fps_grow_usecs_max);
+				spin_unlock(&fps->fps_lock);
+			}
+		}
 	}
-	spin_unlock(&fps->fps_lock);
+	read_unlock_irqrestore(&kiblnd_data.kib_global_lock, flags);
 
-	goto again;
+	return min_t(int, s - str, size);
 }
 
 static void
@@ -2977,6 +3124,7 @@ kiblnd_base_startup(void)
 	spin_lock_init(&kiblnd_data.kib_connd_lock);
 	CFS_INIT_LIST_HEAD(&kiblnd_data.kib_connd_conns);
 	CFS_INIT_LIST_HEAD(&kiblnd_data.kib_connd_zombies);
+	CFS_INIT_LIST_HEAD(&kiblnd_data.kib_connd_fmr_ps);
 	init_waitqueue_head(&kiblnd_data.kib_connd_waitq);
 	init_waitqueue_head(&kiblnd_data.kib_failover_waitq);
 
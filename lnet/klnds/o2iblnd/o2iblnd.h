@@ -115,6 +115,7 @@ typedef struct
 	int              *kib_fmr_pool_size;    /* # FMRs in pool */
 	int              *kib_fmr_flush_trigger; /* When to trigger FMR flush */
 	int              *kib_fmr_cache;        /* enable FMR pool cache? */
+	int		 *kib_fmr_prefetch;	/* % of FMRs mapped to grow pools ahead */
 #if defined(CONFIG_SYSCTL) && !CFS_SYSFS_MODULE_PARM
 	struct ctl_table_header *kib_sysctl;  /* sysctl interface */
 #endif
@@ -335,6 +336,17 @@ typedef struct
 	int			fps_increasing;
 	/* time stamp for retry if failed to allocate */
 	cfs_time_t		fps_next_retry;
+	/* queued for connd to allocate new pool in background */
+	int			fps_prefetch;
+	/* chain on kib_connd_fmr_ps */
+	cfs_list_t		fps_connd_list;
+	int			fps_npools;	/* # pools in fps_pool_list */
+	int			fps_nmapped;	/* # FMRs mapped */
+	__u64			fps_nhits;	/* # mapped without waiting */
+	__u64			fps_nmisses;	/* # waited for a new pool */
+	__u64			fps_ngrows;	/* # pools allocated */
+	__u64			fps_grow_usecs;	/* usecs allocating pools */
+	__u64			fps_grow_usecs_max; /* slowest pool allocation */
 } kib_fmr_poolset_t;
 
 typedef struct
@@ -414,6 +426,10 @@ typedef struct
 	/* connection daemon sleeps here */
 	wait_queue_head_t		kib_connd_waitq;
 	spinlock_t		kib_connd_lock;	/* serialise */
+	/* FMR pool-sets to grow ahead of demand */
+	cfs_list_t		kib_connd_fmr_ps;
+	/* FMR pool-set connd is growing */
+	kib_fmr_poolset_t	*kib_connd_fmr_growing;
 	struct ib_qp_attr	kib_error_qpa;	/* QP->ERROR */
 	/* percpt data for schedulers */
 	struct kib_sched_info	**kib_scheds;
@@ -1057,6 +1073,8 @@ cfs_list_t *kiblnd_pool_alloc_node(kib_poolset_t *ps);
 int  kiblnd_fmr_pool_map(kib_fmr_poolset_t *fps, __u64 *pages,
                          int npages, __u64 iov, kib_fmr_t *fmr);
 void kiblnd_fmr_pool_unmap(kib_fmr_t *fmr, int status);
+void kiblnd_fmr_pool_prefetch(kib_fmr_poolset_t *fps);
+int  kiblnd_fmr_pool_stats(char *str, int size);
 
 int  kiblnd_pmr_pool_map(kib_pmr_poolset_t *pps, kib_hca_dev_t *hdev,
                          kib_rdma_desc_t *rd, __u64 *iova, kib_phys_mr_t **pp_pmr);
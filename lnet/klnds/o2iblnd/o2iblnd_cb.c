@@ -3129,6 +3129,7 @@ kiblnd_connd (void *arg)
 	wait_queue_t     wait;
 	unsigned long      flags;
 	kib_conn_t        *conn;
+	kib_fmr_poolset_t *fps;
 	int                timeout;
 	int                i;
 	int                dropped_lock;
@@ -3176,6 +3177,23 @@ kiblnd_connd (void *arg)
 			spin_lock_irqsave(&kiblnd_data.kib_connd_lock, flags);
                 }
 
+		if (!cfs_list_empty(&kiblnd_data.kib_connd_fmr_ps)) {
+			fps = cfs_list_entry(kiblnd_data.kib_connd_fmr_ps.next,
+					     kib_fmr_poolset_t, fps_connd_list);
+			cfs_list_del_init(&fps->fps_connd_list);
+			/* kiblnd_fini_fmr_poolset() waits for me */
+			kiblnd_data.kib_connd_fmr_growing = fps;
+
+			spin_unlock_irqrestore(&kiblnd_data.kib_connd_lock,
+					       flags);
+			dropped_lock = 1;
+
+			kiblnd_fmr_pool_prefetch(fps);
+
+			spin_lock_irqsave(&kiblnd_data.kib_connd_lock, flags);
+			kiblnd_data.kib_connd_fmr_growing = NULL;
+		}
+
                 /* careful with the jiffy wrap... */
                 timeout = (int)(deadline - jiffies);
                 if (timeout <= 0) {
@@ -126,6 +126,11 @@ static int fmr_cache = 1;
 CFS_MODULE_PARM(fmr_cache, "i", int, 0444,
 		"non-zero to enable FMR caching");
 
+static int fmr_prefetch = 75;
+CFS_MODULE_PARM(fmr_prefetch, "i", int, 0644,
+		"% of FMRs mapped on a CPT to allocate a new pool in "
+		"background (0 to disable)");
+
 /* NB: this value is shared by all CPTs, it can grow at runtime */
 static int pmr_pool_size = 512;
 CFS_MODULE_PARM(pmr_pool_size, "i", int, 0444,
@@ -170,6 +175,7 @@ kib_tunables_t kiblnd_tunables = {
         .kib_fmr_pool_size          = &fmr_pool_size,
         .kib_fmr_flush_trigger      = &fmr_flush_trigger,
         .kib_fmr_cache              = &fmr_cache,
+	.kib_fmr_prefetch	    = &fmr_prefetch,
         .kib_pmr_pool_size          = &pmr_pool_size,
         .kib_require_priv_port      = &require_privileged_port,
 	.kib_use_priv_port	    = &use_privileged_port,
@@ -203,7 +209,9 @@ enum {
         O2IBLND_FMR_FLUSH_TRIGGER,
         O2IBLND_FMR_CACHE,
         O2IBLND_PMR_POOL_SIZE,
-        O2IBLND_DEV_FAILOVER
+	O2IBLND_DEV_FAILOVER,
+	O2IBLND_FMR_PREFETCH,
+	O2IBLND_FMR_STATS
 };
 #else
 
@@ -228,9 +236,38 @@ enum {
 #define O2IBLND_FMR_CACHE        CTL_UNNUMBERED
 #define O2IBLND_PMR_POOL_SIZE    CTL_UNNUMBERED
 #define O2IBLND_DEV_FAILOVER     CTL_UNNUMBERED
+#define O2IBLND_FMR_PREFETCH	 CTL_UNNUMBERED
+#define O2IBLND_FMR_STATS	 CTL_UNNUMBERED
 
 #endif
 
+static int __kiblnd_proc_fmr_stats(void *data, int write,
+				   loff_t pos, void *buffer, int nob)
+{
+	char		*tmpstr;
+	const int	 tmpsiz = PAGE_SIZE;
+	int		 len;
+	int		 rc;
+
+	if (write)
+		return -EPERM;
+
+	LIBCFS_ALLOC(tmpstr, tmpsiz);
+	if (tmpstr == NULL)
+		return -ENOMEM;
+
+	len = kiblnd_fmr_pool_stats(tmpstr, tmpsiz);
+	if (pos >= len)
+		rc = 0;
+	else
+		rc = cfs_trace_copyout_string(buffer, nob, tmpstr + pos, NULL);
+
+	LIBCFS_FREE(tmpstr, tmpsiz);
+	return rc;
+}
+
+DECLARE_PROC_HANDLER(kiblnd_proc_fmr_stats);
+
 static struct ctl_table kiblnd_ctl_table[] = {
         {
                 .ctl_name = O2IBLND_SERVICE,
@@ -401,6 +438,22 @@ static struct ctl_table kiblnd_ctl_table[] = {
                 .mode     = 0444,
                 .proc_handler = &proc_dointvec
         },
+	{
+		.ctl_name = O2IBLND_FMR_PREFETCH,
+		.procname = "fmr_prefetch",
+		.data     = &fmr_prefetch,
+		.maxlen   = sizeof(int),
+		.mode     = 0644,
+		.proc_handler = &proc_dointvec
+	},
+	{
+		.ctl_name = O2IBLND_FMR_STATS,
+		.procname = "fmr_stats",
+		.data     = NULL,
+		.maxlen   = 0,
+		.mode     = 0444,
+		.proc_handler = &kiblnd_proc_fmr_stats
+	},
         {0}
 };
 
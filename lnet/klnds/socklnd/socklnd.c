@@ -64,6 +64,22 @@ ksocknal_ip2iface(lnet_ni_t *ni, __u32 ip)
         return (NULL);
 }
 
+/* Is \a ni bound to CPT \a cpt, i.e. are its schedulers running there? */
+static int
+ksocknal_ni_has_cpt(lnet_ni_t *ni, int cpt)
+{
+	int i;
+
+	if (ni->ni_cpts == NULL)
+		return 1;
+
+	for (i = 0; i < ni->ni_ncpts; i++) {
+		if (ni->ni_cpts[i] == cpt)
+			return 1;
+	}
+	return 0;
+}
+
 ksock_route_t *
 ksocknal_create_route (__u32 ipaddr, int port)
 {
@@ -84,6 +100,7 @@ ksocknal_create_route (__u32 ipaddr, int port)
         route->ksnr_deleted = 0;
         route->ksnr_conn_count = 0;
         route->ksnr_share_count = 0;
+	memset(route->ksnr_nconns, 0, sizeof(route->ksnr_nconns));
 
         return (route);
 }
@@ -358,7 +375,10 @@ ksocknal_associate_route_conn_locked(ksock_route_t *route, ksock_conn_t *conn)
                         iface->ksni_nroutes++;
         }
 
-        route->ksnr_connected |= (1<<type);
+	/* the type is connected once it has all its connections */
+	route->ksnr_nconns[type]++;
+	if (route->ksnr_nconns[type] >= ksocknal_route_type_conns(type))
+		route->ksnr_connected |= (1 << type);
         route->ksnr_conn_count++;
 
         /* Successful connection => further attempts can
@@ -1034,6 +1054,7 @@ ksocknal_create_conn (lnet_ni_t *ni, ksock_route_t *route,
         ksock_tx_t        *txtmp;
         int                rc;
         int                active;
+	int		   nconns;
         char              *warn = NULL;
 
         active = (route != NULL);
@@ -1211,8 +1232,14 @@ ksocknal_create_conn (lnet_ni_t *ni, ksock_route_t *route,
         }
 
         /* Refuse to duplicate an existing connection, unless this is a
-         * loopback connection */
+         * loopback connection or another bulk connection to stripe over */
         if (conn->ksnc_ipaddr != conn->ksnc_myipaddr) {
+		nconns = active ? ksocknal_route_type_conns(conn->ksnc_type) :
+				  SOCKNAL_CONNS_PER_PEER_MAX;
+		if (conn->ksnc_type != SOCKLND_CONN_BULK_IN &&
+		    conn->ksnc_type != SOCKLND_CONN_BULK_OUT)
+			nconns = 1;
+
                 cfs_list_for_each(tmp, &peer->ksnp_conns) {
                         conn2 = cfs_list_entry(tmp, ksock_conn_t, ksnc_list);
 
@@ -1221,6 +1248,9 @@ ksocknal_create_conn (lnet_ni_t *ni, ksock_route_t *route,
                             conn2->ksnc_type != conn->ksnc_type)
                                 continue;
 
+			if (--nconns > 0)
+				continue;
+
                         /* Reply on a passive connection attempt so the peer
                          * realises we're connected. */
                         LASSERT (rc == 0);
@@ -1262,6 +1292,17 @@ ksocknal_create_conn (lnet_ni_t *ni, ksock_route_t *route,
         peer->ksnp_send_keepalive = 0;
         peer->ksnp_error = 0;
 
+	if (*ksocknal_tunables.ksnd_nic_affinity) {
+		/* process it where the NIC delivers its input, if I have
+		 * schedulers there */
+		ksock_interface_t *iface;
+
+		iface = ksocknal_ip2iface(ni, conn->ksnc_myipaddr);
+		if (iface != NULL && iface->ksni_cpt != CFS_CPT_ANY &&
+		    ksocknal_ni_has_cpt(ni, iface->ksni_cpt))
+			cpt = iface->ksni_cpt;
+	}
+
 	sched = ksocknal_choose_scheduler_locked(cpt);
         sched->kss_nconns++;
         conn->ksnc_scheduler = sched;
@@ -1411,8 +1452,6 @@ ksocknal_close_conn_locked (ksock_conn_t *conn, int error)
          * Caller holds ksnd_global_lock exclusively in irq context */
         ksock_peer_t      *peer = conn->ksnc_peer;
         ksock_route_t     *route;
-        ksock_conn_t      *conn2;
-        cfs_list_t        *tmp;
 
         LASSERT (peer->ksnp_error == 0);
         LASSERT (!conn->ksnc_closing);
@@ -1425,20 +1464,13 @@ ksocknal_close_conn_locked (ksock_conn_t *conn, int error)
         if (route != NULL) {
                 /* dissociate conn from route... */
                 LASSERT (!route->ksnr_deleted);
-                LASSERT ((route->ksnr_connected & (1 << conn->ksnc_type)) != 0);
-
-                conn2 = NULL;
-                cfs_list_for_each(tmp, &peer->ksnp_conns) {
-                        conn2 = cfs_list_entry(tmp, ksock_conn_t, ksnc_list);
-
-                        if (conn2->ksnc_route == route &&
-                            conn2->ksnc_type == conn->ksnc_type)
-                                break;
+		LASSERT(route->ksnr_nconns[conn->ksnc_type] > 0);
 
-                        conn2 = NULL;
-                }
-                if (conn2 == NULL)
-                        route->ksnr_connected &= ~(1 << conn->ksnc_type);
+		/* reconnect when the type is missing a connection */
+		route->ksnr_nconns[conn->ksnc_type]--;
+		if (route->ksnr_nconns[conn->ksnc_type] <
+		    ksocknal_route_type_conns(conn->ksnc_type))
+			route->ksnr_connected &= ~(1 << conn->ksnc_type);
 
                 conn->ksnc_route = NULL;
 
@@ -1971,6 +2003,7 @@ ksocknal_add_interface(lnet_ni_t *ni, __u32 ipaddress, __u32 netmask)
                 iface->ksni_netmask = netmask;
                 iface->ksni_nroutes = 0;
                 iface->ksni_npeers = 0;
+		iface->ksni_cpt = CFS_CPT_ANY;
 
                 for (i = 0; i < ksocknal_data.ksnd_peer_hash_size; i++) {
                         cfs_list_for_each(ptmp, &ksocknal_data.ksnd_peers[i]) {
@@ -2837,6 +2870,14 @@ ksocknal_startup (lnet_ni_t *ni)
 		net->ksnn_ninterfaces = i;
 	}
 
+	for (i = 0; i < net->ksnn_ninterfaces; i++) {
+		ksock_interface_t *iface = &net->ksnn_interfaces[i];
+
+		iface->ksni_cpt = ksocknal_lib_nic_cpt(iface->ksni_name);
+		CDEBUG(D_NET, "Interface %s on CPT %d\n",
+		       iface->ksni_name, iface->ksni_cpt);
+	}
+
 	/* call it before add it to ksocknal_data.ksnd_nets */
 	rc = ksocknal_net_start_threads(net, ni->ni_cpts, ni->ni_ncpts);
 	if (rc != 0)
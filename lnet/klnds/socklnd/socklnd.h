@@ -103,6 +103,7 @@ typedef struct                                  /* in-use interface */
 	int		ksni_nroutes;		/* # routes using (active) */
 	int		ksni_npeers;		/* # peers using (passive) */
 	char		ksni_name[IFNAMSIZ];	/* interface name */
+	int		ksni_cpt;		/* CPT of the NIC or CFS_CPT_ANY */
 } ksock_interface_t;
 
 typedef struct
@@ -117,6 +118,7 @@ typedef struct
         int              *ksnd_max_reconnectms; /* ...exponentially increasing to this */
         int              *ksnd_eager_ack;       /* make TCP ack eagerly? */
         int              *ksnd_typed_conns;     /* drive sockets by type? */
+	int		 *ksnd_conns_per_peer;	/* # bulk conns of each type per route */
         int              *ksnd_min_bulk;        /* smallest "large" message */
         int              *ksnd_tx_buffer_size;  /* socket tx buffer size */
         int              *ksnd_rx_buffer_size;  /* socket rx buffer size */
@@ -136,6 +138,10 @@ typedef struct
         unsigned int     *ksnd_zc_min_payload;  /* minimum zero copy payload size */
         int              *ksnd_zc_recv;         /* enable ZC receive (for Chelsio TOE) */
         int              *ksnd_zc_recv_min_nfrags; /* minimum # of fragments to enable ZC receive */
+	int		 *ksnd_skb_recv_min_payload; /* min payload received straight from skbs */
+	int		 *ksnd_busy_poll;	/* usecs to poll before sleeping */
+	int		 *ksnd_tx_coalesce;	/* max bytes of small messages sent at once */
+	int		 *ksnd_nic_affinity;	/* schedule conns on the CPT of the NIC */
 #ifdef CPU_AFFINITY
         int              *ksnd_irq_affinity;    /* enable IRQ affinity? */
 #endif
@@ -237,6 +243,7 @@ typedef struct                                  /* transmit packet */
 {
         cfs_list_t     tx_list;        /* queue on conn for transmission etc */
         cfs_list_t     tx_zc_list;     /* queue on peer for ZC request */
+	cfs_list_t     tx_coalesced;   /* small txs sent along with me */
         cfs_atomic_t   tx_refcount;    /* tx reference count */
         int            tx_nob;         /* # packet bytes */
         int            tx_resid;       /* residual bytes */
@@ -355,6 +362,7 @@ typedef struct ksock_route
         unsigned int          ksnr_deleted:1;   /* been removed from peer? */
         unsigned int          ksnr_share_count; /* created explicitly? */
         int                   ksnr_conn_count;  /* # conns established by this route */
+	int		      ksnr_nconns[SOCKLND_CONN_NTYPES]; /* # conns established by type */
 } ksock_route_t;
 
 #define SOCKNAL_KEEPALIVE_PING          1       /* cookie for keepalive ping */
@@ -438,6 +446,21 @@ ksocknal_route_mask(void)
                 (1 << SOCKLND_CONN_BULK_OUT));
 }
 
+/* max # bulk connections of each type to accept from a peer, the peer
+ * may have a higher conns_per_peer than me */
+#define SOCKNAL_CONNS_PER_PEER_MAX	16
+
+/* # connections of @type a route makes, bulk messages are striped over
+ * conns_per_peer connections of their type */
+static inline int
+ksocknal_route_type_conns(int type)
+{
+	if (type == SOCKLND_CONN_BULK_IN || type == SOCKLND_CONN_BULK_OUT)
+		return *ksocknal_tunables.ksnd_conns_per_peer;
+
+	return 1;
+}
+
 static inline cfs_list_t *
 ksocknal_nid2peerlist (lnet_nid_t nid)
 {
@@ -510,6 +533,19 @@ ksocknal_tx_decref (ksock_tx_t *tx)
                 ksocknal_tx_done(NULL, tx);
 }
 
+/* residual bytes of @tx and of the txs coalesced with it */
+static inline int
+ksocknal_tx_resid(ksock_tx_t *tx)
+{
+	ksock_tx_t *tx2;
+	int	    resid = tx->tx_resid;
+
+	cfs_list_for_each_entry(tx2, &tx->tx_coalesced, tx_list)
+		resid += tx2->tx_resid;
+
+	return resid;
+}
+
 static inline void
 ksocknal_route_addref (ksock_route_t *route)
 {
@@ -599,6 +635,7 @@ extern void ksocknal_read_callback(ksock_conn_t *conn);
 extern void ksocknal_write_callback(ksock_conn_t *conn);
 
 extern int ksocknal_lib_zc_capable(ksock_conn_t *conn);
+extern int ksocknal_lib_nic_cpt(char *ifname);
 extern void ksocknal_lib_save_callback(cfs_socket_t *sock, ksock_conn_t *conn);
 extern void ksocknal_lib_set_callback(cfs_socket_t *sock,  ksock_conn_t *conn);
 extern void ksocknal_lib_reset_callback(cfs_socket_t *sock, ksock_conn_t *conn);
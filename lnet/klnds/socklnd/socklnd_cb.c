@@ -54,6 +54,7 @@ ksocknal_alloc_tx(int type, int size)
                 return NULL;
 
         cfs_atomic_set(&tx->tx_refcount, 1);
+	CFS_INIT_LIST_HEAD(&tx->tx_coalesced);
         tx->tx_zc_aborted = 0;
         tx->tx_zc_capable = 0;
         tx->tx_zc_checked = 0;
@@ -107,14 +108,45 @@ ksocknal_free_tx (ksock_tx_t *tx)
 	}
 }
 
+/* "consume" @nob bytes sent of the iov of @tx, return what's left for
+ * the txs coalesced with it */
+static int
+ksocknal_consume_iov(ksock_tx_t *tx, int nob)
+{
+	struct iovec	*iov = tx->tx_iov;
+	int		 left = 0;
+
+	if (nob > tx->tx_resid) {
+		left = nob - tx->tx_resid;
+		nob = tx->tx_resid;
+	}
+	tx->tx_resid -= nob;
+
+	while (nob != 0) {
+		LASSERT(tx->tx_niov > 0);
+
+		if (nob < (int)iov->iov_len) {
+			iov->iov_base = (void *)((char *)iov->iov_base + nob);
+			iov->iov_len -= nob;
+			break;
+		}
+
+		nob -= iov->iov_len;
+		tx->tx_iov = ++iov;
+		tx->tx_niov--;
+	}
+
+	return left;
+}
+
 int
 ksocknal_send_iov (ksock_conn_t *conn, ksock_tx_t *tx)
 {
-        struct iovec  *iov = tx->tx_iov;
+	ksock_tx_t	*tx2;
         int    nob;
         int    rc;
 
-        LASSERT (tx->tx_niov > 0);
+	LASSERT(tx->tx_niov > 0 || !cfs_list_empty(&tx->tx_coalesced));
 
         /* Never touch tx->tx_iov inside ksocknal_lib_send_iov() */
         rc = ksocknal_lib_send_iov(conn, tx);
@@ -122,24 +154,13 @@ ksocknal_send_iov (ksock_conn_t *conn, ksock_tx_t *tx)
         if (rc <= 0)                            /* sent nothing? */
                 return (rc);
 
-        nob = rc;
-        LASSERT (nob <= tx->tx_resid);
-        tx->tx_resid -= nob;
-
-        /* "consume" iov */
-        do {
-                LASSERT (tx->tx_niov > 0);
-
-                if (nob < (int) iov->iov_len) {
-                        iov->iov_base = (void *)((char *)iov->iov_base + nob);
-                        iov->iov_len -= nob;
-                        return (rc);
-                }
-
-                nob -= iov->iov_len;
-                tx->tx_iov = ++iov;
-                tx->tx_niov--;
-        } while (nob != 0);
+	nob = ksocknal_consume_iov(tx, rc);
+	cfs_list_for_each_entry(tx2, &tx->tx_coalesced, tx_list) {
+		if (nob == 0)
+			break;
+		nob = ksocknal_consume_iov(tx2, nob);
+	}
+	LASSERT(nob == 0);
 
         return (rc);
 }
@@ -192,7 +213,7 @@ ksocknal_transmit (ksock_conn_t *conn, ksock_tx_t *tx)
                 cfs_pause(cfs_time_seconds(ksocknal_data.ksnd_stall_tx));
         }
 
-        LASSERT (tx->tx_resid != 0);
+	LASSERT(ksocknal_tx_resid(tx) != 0);
 
         rc = ksocknal_connsock_addref(conn);
         if (rc != 0) {
@@ -205,7 +226,8 @@ ksocknal_transmit (ksock_conn_t *conn, ksock_tx_t *tx)
                         /* testing... */
                         ksocknal_data.ksnd_enomem_tx--;
                         rc = -EAGAIN;
-                } else if (tx->tx_niov != 0) {
+		} else if (tx->tx_niov != 0 || tx->tx_nkiov == 0) {
+			/* header, or messages coalesced with tx */
                         rc = ksocknal_send_iov (conn, tx);
                 } else {
                         rc = ksocknal_send_kiov (conn, tx);
@@ -241,7 +263,7 @@ ksocknal_transmit (ksock_conn_t *conn, ksock_tx_t *tx)
                 cfs_atomic_sub (rc, &conn->ksnc_tx_nob);
                 rc = 0;
 
-        } while (tx->tx_resid != 0);
+	} while (ksocknal_tx_resid(tx) != 0);
 
         ksocknal_connsock_decref(conn);
         return (rc);
@@ -393,6 +415,15 @@ ksocknal_tx_done (lnet_ni_t *ni, ksock_tx_t *tx)
 
         LASSERT(ni != NULL || tx->tx_conn != NULL);
 
+	/* messages sent along with me are done (or failed) too */
+	while (!cfs_list_empty(&tx->tx_coalesced)) {
+		ksock_tx_t *tx2 = cfs_list_entry(tx->tx_coalesced.next,
+						 ksock_tx_t, tx_list);
+
+		cfs_list_del(&tx2->tx_list);
+		ksocknal_tx_decref(tx2);
+	}
+
         if (tx->tx_conn != NULL)
                 ksocknal_conn_decref(tx->tx_conn);
 
@@ -501,6 +532,51 @@ ksocknal_uncheck_zc_req(ksock_tx_t *tx)
 	ksocknal_tx_decref(tx);
 }
 
+static int
+ksocknal_tx_coalescable(ksock_conn_t *conn, ksock_tx_t *tx)
+{
+#if SOCKNAL_SINGLE_FRAG_TX || !defined(__linux__)
+	/* only the linux ksocknal_lib_send_iov() sends coalesced messages */
+	return 0;
+#else
+	/* small unsent messages without pages, V2.x checksums each message
+	 * as it starts sending it */
+	return tx->tx_nkiov == 0 && !tx->tx_zc_capable &&
+	       tx->tx_resid == tx->tx_nob &&
+	       tx->tx_nob <= *ksocknal_tunables.ksnd_tx_coalesce &&
+	       !(*ksocknal_tunables.ksnd_enable_csum &&
+		 conn->ksnc_proto == &ksocknal_protocol_v2x);
+#endif
+}
+
+/* Take the small messages queued behind @tx, they go out in the same
+ * sendmsg() and complete with it. Called holding kss_lock. */
+static void
+ksocknal_coalesce_txs_locked(ksock_conn_t *conn, ksock_tx_t *tx)
+{
+	ksock_tx_t	*tx2;
+	int		nob = tx->tx_nob;
+	int		niov = tx->tx_niov;
+
+	while (!cfs_list_empty(&conn->ksnc_tx_queue)) {
+		tx2 = cfs_list_entry(conn->ksnc_tx_queue.next,
+				     ksock_tx_t, tx_list);
+
+		if (!ksocknal_tx_coalescable(conn, tx2) ||
+		    nob + tx2->tx_nob > *ksocknal_tunables.ksnd_tx_coalesce ||
+		    niov + tx2->tx_niov > LNET_MAX_IOV)
+			break;
+
+		/* no ZC-ACK piggybacking on it once it's been taken */
+		if (conn->ksnc_tx_carrier == tx2)
+			ksocknal_next_tx_carrier(conn);
+
+		cfs_list_move_tail(&tx2->tx_list, &tx->tx_coalesced);
+		nob += tx2->tx_nob;
+		niov += tx2->tx_niov;
+	}
+}
+
 int
 ksocknal_process_transmit (ksock_conn_t *conn, ksock_tx_t *tx)
 {
@@ -513,7 +589,7 @@ ksocknal_process_transmit (ksock_conn_t *conn, ksock_tx_t *tx)
 
         CDEBUG (D_NET, "send(%d) %d\n", tx->tx_resid, rc);
 
-        if (tx->tx_resid == 0) {
+	if (ksocknal_tx_resid(tx) == 0) {
                 /* Sent everything OK */
                 LASSERT (rc == 0);
 
@@ -1389,6 +1465,35 @@ ksocknal_sched_cansleep(ksock_sched_t *sched)
 	return rc;
 }
 
+/* busy_poll: spin a while for something to do before going to sleep,
+ * it's quicker than waiting for a wakeup. Return non-zero if there's
+ * work now. */
+static int
+ksocknal_sched_spin(ksock_sched_t *sched)
+{
+	int	usecs = *ksocknal_tunables.ksnd_busy_poll;
+	s64	end;
+
+	if (usecs <= 0)
+		return 0;
+
+	end = ktime_to_us(ktime_get()) + usecs;
+	do {
+		/* unlocked peeks, the caller rechecks under kss_lock */
+		if (!cfs_list_empty(&sched->kss_rx_conns) ||
+		    !cfs_list_empty(&sched->kss_tx_conns) ||
+		    ksocknal_data.ksnd_shuttingdown)
+			return 1;
+
+		if (need_resched())
+			break;
+
+		cpu_relax();
+	} while (ktime_to_us(ktime_get()) < end);
+
+	return 0;
+}
+
 int ksocknal_scheduler(void *arg)
 {
 	struct ksock_sched_info	*info;
@@ -1487,6 +1592,10 @@ int ksocknal_scheduler(void *arg)
                         /* dequeue now so empty list => more to send */
                         cfs_list_del(&tx->tx_list);
 
+			if (cfs_list_empty(&tx->tx_coalesced) &&
+			    ksocknal_tx_coalescable(conn, tx))
+				ksocknal_coalesce_txs_locked(conn, tx);
+
                         /* Clear tx_ready in case send isn't complete.  Do
                          * it BEFORE we call process_transmit, since
                          * write_space can set it any time after we release
@@ -1538,13 +1647,14 @@ int ksocknal_scheduler(void *arg)
 
                         nloops = 0;
 
-                        if (!did_something) {   /* wait for something to do */
+			if (did_something) {
+				cond_resched();
+			} else if (!ksocknal_sched_spin(sched)) {
+				/* wait for something to do */
 				rc = wait_event_interruptible_exclusive(
 					sched->kss_waitq,
 					!ksocknal_sched_cansleep(sched));
 				LASSERT (rc == 0);
-			} else {
-				cond_resched();
 			}
 
 			spin_lock_bh(&sched->kss_lock);
@@ -66,7 +66,12 @@ enum {
         SOCKLND_BACKOFF_MAX,
         SOCKLND_PROTOCOL,
         SOCKLND_ZERO_COPY_RECV,
-        SOCKLND_ZERO_COPY_RECV_MIN_NFRAGS
+        SOCKLND_ZERO_COPY_RECV_MIN_NFRAGS,
+	SOCKLND_SKB_RECV_MIN_PAYLOAD,
+	SOCKLND_CONNS_PER_PEER,
+	SOCKLND_BUSY_POLL,
+	SOCKLND_NIC_AFFINITY,
+	SOCKLND_TX_COALESCE
 };
 #else
 
@@ -96,6 +101,11 @@ enum {
 #define SOCKLND_PROTOCOL        CTL_UNNUMBERED
 #define SOCKLND_ZERO_COPY_RECV  CTL_UNNUMBERED
 #define SOCKLND_ZERO_COPY_RECV_MIN_NFRAGS CTL_UNNUMBERED
+#define SOCKLND_SKB_RECV_MIN_PAYLOAD CTL_UNNUMBERED
+#define SOCKLND_CONNS_PER_PEER  CTL_UNNUMBERED
+#define SOCKLND_BUSY_POLL       CTL_UNNUMBERED
+#define SOCKLND_NIC_AFFINITY    CTL_UNNUMBERED
+#define SOCKLND_TX_COALESCE     CTL_UNNUMBERED
 #endif
 
 static struct ctl_table ksocknal_ctl_table[] = {
@@ -208,6 +218,42 @@ static struct ctl_table ksocknal_ctl_table[] = {
                 .proc_handler = &proc_dointvec,
                 .strategy = &sysctl_intvec,
         },
+	{
+		.ctl_name = SOCKLND_SKB_RECV_MIN_PAYLOAD,
+		.procname = "skb_recv_min_payload",
+		.data     = &ksocknal_tunables.ksnd_skb_recv_min_payload,
+		.maxlen   = sizeof(int),
+		.mode     = 0644,
+		.proc_handler = &proc_dointvec,
+		.strategy = &sysctl_intvec,
+	},
+	{
+		.ctl_name = SOCKLND_BUSY_POLL,
+		.procname = "busy_poll",
+		.data     = &ksocknal_tunables.ksnd_busy_poll,
+		.maxlen   = sizeof(int),
+		.mode     = 0644,
+		.proc_handler = &proc_dointvec,
+		.strategy = &sysctl_intvec,
+	},
+	{
+		.ctl_name = SOCKLND_NIC_AFFINITY,
+		.procname = "nic_affinity",
+		.data     = &ksocknal_tunables.ksnd_nic_affinity,
+		.maxlen   = sizeof(int),
+		.mode     = 0644,
+		.proc_handler = &proc_dointvec,
+		.strategy = &sysctl_intvec,
+	},
+	{
+		.ctl_name = SOCKLND_TX_COALESCE,
+		.procname = "tx_coalesce",
+		.data     = &ksocknal_tunables.ksnd_tx_coalesce,
+		.maxlen   = sizeof(int),
+		.mode     = 0644,
+		.proc_handler = &proc_dointvec,
+		.strategy = &sysctl_intvec,
+	},
         {
                 .ctl_name = SOCKLND_TYPED,
                 .procname = "typed",
@@ -217,6 +263,15 @@ static struct ctl_table ksocknal_ctl_table[] = {
                 .proc_handler = &proc_dointvec,
                 .strategy = &sysctl_intvec,
         },
+	{
+		.ctl_name = SOCKLND_CONNS_PER_PEER,
+		.procname = "conns_per_peer",
+		.data     = &ksocknal_tunables.ksnd_conns_per_peer,
+		.maxlen   = sizeof(int),
+		.mode     = 0444,
+		.proc_handler = &proc_dointvec,
+		.strategy = &sysctl_intvec,
+	},
         {
                 .ctl_name = SOCKLND_BULK_MIN,
                 .procname = "min_bulk",
@@ -429,6 +484,33 @@ ksocknal_lib_get_conn_addrs (ksock_conn_t *conn)
         return 0;
 }
 
+/* CPT of the NUMA node of the NIC of interface @ifname, the NIC raises
+ * its interrupts (and processes input) there */
+int
+ksocknal_lib_nic_cpt(char *ifname)
+{
+	struct net_device *dev;
+	int		   node = -1;
+
+#ifdef HAVE_DEV_GET_BY_NAME_2ARG
+	dev = dev_get_by_name(&init_net, ifname);
+#else
+	dev = dev_get_by_name(ifname);
+#endif
+	if (dev == NULL)
+		return CFS_CPT_ANY;
+
+	if (dev->dev.parent != NULL)
+		node = dev_to_node(dev->dev.parent);
+	dev_put(dev);
+
+	if (node < 0 || !node_online(node))
+		return CFS_CPT_ANY;
+
+	return cfs_cpt_of_cpu(lnet_cpt_table(),
+			      cpumask_first(cpumask_of_node(node)));
+}
+
 int
 ksocknal_lib_zc_capable(ksock_conn_t *conn)
 {
@@ -466,6 +548,7 @@ ksocknal_lib_send_iov (ksock_conn_t *conn, ksock_tx_t *tx)
 #else
                 struct iovec   *scratchiov = conn->ksnc_scheduler->kss_scratch_iov;
                 unsigned int    niov = tx->tx_niov;
+		ksock_tx_t     *tx2;
 #endif
                 struct msghdr msg = {
                         .msg_name       = NULL,
@@ -484,8 +567,20 @@ ksocknal_lib_send_iov (ksock_conn_t *conn, ksock_tx_t *tx)
                         nob += scratchiov[i].iov_len;
                 }
 
+#if !SOCKNAL_SINGLE_FRAG_TX
+		/* messages coalesced with tx go in the same sendmsg() */
+		cfs_list_for_each_entry(tx2, &tx->tx_coalesced, tx_list) {
+			for (i = 0; i < tx2->tx_niov; i++, niov++) {
+				LASSERT(niov < LNET_MAX_IOV);
+				scratchiov[niov] = tx2->tx_iov[i];
+				nob += scratchiov[niov].iov_len;
+			}
+		}
+		msg.msg_iovlen = niov;
+#endif
+
                 if (!cfs_list_empty(&conn->ksnc_tx_queue) ||
-                    nob < tx->tx_resid)
+                    nob < ksocknal_tx_resid(tx))
                         msg.msg_flags |= MSG_MORE;
 
                 set_fs (KERNEL_DS);
@@ -706,6 +801,102 @@ ksocknal_lib_kiov_vmap(lnet_kiov_t *kiov, int niov,
         return addr;
 }
 
+typedef struct {
+	ksock_conn_t	*ksrd_conn;
+	lnet_kiov_t	*ksrd_kiov;	/* fragment being filled */
+	unsigned int	 ksrd_offset;	/* offset in that fragment */
+} ksock_skb_rx_t;
+
+/* tcp_read_sock() actor: copy @len bytes at @offset of @skb into the
+ * receive fragments, the checksum is accumulated in the same pass */
+static int
+ksocknal_lib_skb_rx_actor(read_descriptor_t *desc, struct sk_buff *skb,
+			  unsigned int offset, size_t len)
+{
+	ksock_skb_rx_t	*rx = desc->arg.data;
+	ksock_conn_t	*conn = rx->ksrd_conn;
+	lnet_kiov_t	*kiov;
+	char		*base;
+	size_t		 left = min(len, desc->count);
+	int		 fragnob;
+	int		 copied = 0;
+	int		 rc;
+
+	while (left > 0) {
+		kiov = rx->ksrd_kiov;
+		fragnob = min_t(size_t, left,
+				kiov->kiov_len - rx->ksrd_offset);
+
+		base = kmap(kiov->kiov_page) + kiov->kiov_offset +
+		       rx->ksrd_offset;
+		rc = skb_copy_bits(skb, offset + copied, base, fragnob);
+		if (rc == 0 && conn->ksnc_msg.ksm_csum != 0)
+			conn->ksnc_rx_csum = ksocknal_csum(conn->ksnc_rx_csum,
+							   base, fragnob);
+		kunmap(kiov->kiov_page);
+
+		if (rc != 0) {
+			desc->error = rc;
+			break;
+		}
+
+		copied += fragnob;
+		left -= fragnob;
+		rx->ksrd_offset += fragnob;
+		if (rx->ksrd_offset == kiov->kiov_len) {
+			rx->ksrd_kiov++;
+			rx->ksrd_offset = 0;
+		}
+	}
+
+	desc->count -= copied;
+	desc->written += copied;
+	return copied;
+}
+
+/* Receive straight from the queued skbs into the fragments under the
+ * socket lock, instead of mapping all the pages for sock_recvmsg().
+ * LNet receives into pages of the upper layer, so the data still has
+ * to be copied once, but the pages are only mapped while they're being
+ * filled and a checksum doesn't need another pass over them. */
+static int
+ksocknal_lib_skb_recv_kiov(ksock_conn_t *conn, int nob)
+{
+	struct sock		*sk = conn->ksnc_sock->sk;
+	ksock_skb_rx_t		 rx = {
+		.ksrd_conn	= conn,
+		.ksrd_kiov	= conn->ksnc_rx_kiov,
+		.ksrd_offset	= 0,
+	};
+	read_descriptor_t	 desc = {
+		.written	= 0,
+		.count		= nob,
+		.arg.data	= &rx,
+		.error		= 0,
+	};
+	int			 rc;
+
+	lock_sock(sk);
+	rc = tcp_read_sock(sk, &desc, ksocknal_lib_skb_rx_actor);
+	if (rc == 0) {
+		/* nothing copied, tell the caller why, like recvmsg */
+		if (desc.error != 0)
+			rc = desc.error;
+		else if (sk->sk_err != 0)
+			rc = sock_error(sk);
+		else if ((sk->sk_shutdown & RCV_SHUTDOWN) != 0 ||
+			 sock_flag(sk, SOCK_DONE))
+			rc = 0;
+		else if (sk->sk_state == TCP_CLOSE)
+			rc = -ENOTCONN;
+		else
+			rc = -EAGAIN;
+	}
+	release_sock(sk);
+
+	return rc;
+}
+
 int
 ksocknal_lib_recv_kiov (ksock_conn_t *conn)
 {
@@ -740,6 +931,16 @@ ksocknal_lib_recv_kiov (ksock_conn_t *conn)
         int          sum;
         int          fragnob;
 
+	/* TOE drivers (zc_recv) don't queue skbs on the socket */
+	if (!*ksocknal_tunables.ksnd_zc_recv &&
+	    *ksocknal_tunables.ksnd_skb_recv_min_payload > 0) {
+		for (nob = i = 0; i < conn->ksnc_rx_nkiov; i++)
+			nob += kiov[i].kiov_len;
+
+		if (nob >= *ksocknal_tunables.ksnd_skb_recv_min_payload)
+			return ksocknal_lib_skb_recv_kiov(conn, nob);
+	}
+
         /* NB we can't trust socket ops to either consume our iovs
          * or leave them alone. */
         if ((addr = ksocknal_lib_kiov_vmap(kiov, niov, scratchiov, pages)) != NULL) {
@@ -917,6 +1118,19 @@ ksocknal_lib_setup_sock (struct socket *sock)
                 }
         }
 
+#ifdef SO_BUSY_POLL
+	/* let receives poll the device queue when there's no input */
+	option = *ksocknal_tunables.ksnd_busy_poll;
+	if (option > 0) {
+		set_fs(KERNEL_DS);
+		rc = sock_setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL,
+				     (char *)&option, sizeof(option));
+		set_fs(oldmm);
+		if (rc != 0)
+			CWARN("Can't set SO_BUSY_POLL %d: %d\n", option, rc);
+	}
+#endif
+
         rc = libcfs_sock_setbuf(sock,
                                 *ksocknal_tunables.ksnd_tx_buffer_size,
                                 *ksocknal_tunables.ksnd_rx_buffer_size);
@@ -667,6 +667,12 @@ ksocknal_lib_zc_capable(ksock_conn_t *conn)
         return 0;
 }
 
+int
+ksocknal_lib_nic_cpt(char *ifname)
+{
+	return CFS_CPT_ANY;
+}
+
 int
 ksocknal_lib_memory_pressure(ksock_conn_t *conn)
 {
@@ -76,6 +76,10 @@ static int typed_conns = 1;
 CFS_MODULE_PARM(typed_conns, "i", int, 0444,
                 "use different sockets for bulk");
 
+static int conns_per_peer = 1;
+CFS_MODULE_PARM(conns_per_peer, "i", int, 0444,
+		"# sockets per peer to stripe bulk of each direction over");
+
 static int min_bulk = (1<<10);
 CFS_MODULE_PARM(min_bulk, "i", int, 0644,
                 "smallest 'large' message");
@@ -151,6 +155,25 @@ static unsigned int zc_recv_min_nfrags = 16;
 CFS_MODULE_PARM(zc_recv_min_nfrags, "i", int, 0644,
                 "minimum # of fragments to enable ZC recv");
 
+static int busy_poll = 0;
+CFS_MODULE_PARM(busy_poll, "i", int, 0644,
+		"usecs schedulers and sockets poll for input before "
+		"sleeping (0 to disable)");
+
+static int tx_coalesce = (16 << 10);
+CFS_MODULE_PARM(tx_coalesce, "i", int, 0644,
+		"max bytes of small messages to a peer sent together "
+		"(0 to disable)");
+
+static int nic_affinity = 0;
+CFS_MODULE_PARM(nic_affinity, "i", int, 0644,
+		"schedule connections on the CPT of their NIC");
+
+static int skb_recv_min_payload = (32 << 10);
+CFS_MODULE_PARM(skb_recv_min_payload, "i", int, 0644,
+		"minimum payload size to receive straight from socket "
+		"buffers (0 to disable)");
+
 #ifdef SOCKNAL_BACKOFF
 static int backoff_init = 3;
 CFS_MODULE_PARM(backoff_init, "i", int, 0644,
@@ -181,6 +204,7 @@ int ksocknal_tunables_init(void)
         ksocknal_tunables.ksnd_max_reconnectms    = &max_reconnectms;
         ksocknal_tunables.ksnd_eager_ack          = &eager_ack;
         ksocknal_tunables.ksnd_typed_conns        = &typed_conns;
+	ksocknal_tunables.ksnd_conns_per_peer     = &conns_per_peer;
         ksocknal_tunables.ksnd_min_bulk           = &min_bulk;
         ksocknal_tunables.ksnd_tx_buffer_size     = &tx_buffer_size;
         ksocknal_tunables.ksnd_rx_buffer_size     = &rx_buffer_size;
@@ -200,6 +224,10 @@ int ksocknal_tunables_init(void)
         ksocknal_tunables.ksnd_zc_min_payload     = &zc_min_payload;
         ksocknal_tunables.ksnd_zc_recv            = &zc_recv;
         ksocknal_tunables.ksnd_zc_recv_min_nfrags = &zc_recv_min_nfrags;
+	ksocknal_tunables.ksnd_skb_recv_min_payload = &skb_recv_min_payload;
+	ksocknal_tunables.ksnd_busy_poll          = &busy_poll;
+	ksocknal_tunables.ksnd_tx_coalesce        = &tx_coalesce;
+	ksocknal_tunables.ksnd_nic_affinity       = &nic_affinity;
 
 #ifdef CPU_AFFINITY
 	if (enable_irq_affinity) {
@@ -227,6 +255,12 @@ int ksocknal_tunables_init(void)
         if (*ksocknal_tunables.ksnd_zc_min_payload < (2 << 10))
                 *ksocknal_tunables.ksnd_zc_min_payload = (2 << 10);
 
+	if (*ksocknal_tunables.ksnd_conns_per_peer < 1)
+		*ksocknal_tunables.ksnd_conns_per_peer = 1;
+	if (*ksocknal_tunables.ksnd_conns_per_peer > SOCKNAL_CONNS_PER_PEER_MAX)
+		*ksocknal_tunables.ksnd_conns_per_peer =
+			SOCKNAL_CONNS_PER_PEER_MAX;
+
         /* initialize platform-sepcific tunables */
         return ksocknal_lib_tunables_init();
 };
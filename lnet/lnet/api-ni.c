@@ -67,12 +67,22 @@ static int rnet_htable_size = LNET_REMOTE_NETS_HASH_DEFAULT;
 CFS_MODULE_PARM(rnet_htable_size, "i", int, 0444,
 		"size of remote network hash table");
 
+static char *peer_rails = "";
+CFS_MODULE_PARM(peer_rails, "s", charp, 0444,
+		"NIDs of multi-rail peers");
+
 char *
 lnet_get_routes(void)
 {
         return routes;
 }
 
+char *
+lnet_get_rails(void)
+{
+	return peer_rails;
+}
+
 char *
 lnet_get_networks(void)
 {
@@ -120,6 +130,14 @@ lnet_get_routes(void)
         return (str == NULL) ? "" : str;
 }
 
+char *
+lnet_get_rails(void)
+{
+	char *str = getenv("LNET_PEER_RAILS");
+
+	return (str == NULL) ? "" : str;
+}
+
 char *
 lnet_get_networks (void)
 {
@@ -745,6 +763,7 @@ lnet_prepare(lnet_pid_t requested_pid)
 #endif
 
 	CFS_INIT_LIST_HEAD(&the_lnet.ln_test_peers);
+	CFS_INIT_LIST_HEAD(&the_lnet.ln_rail_sets);
 	CFS_INIT_LIST_HEAD(&the_lnet.ln_nis);
 	CFS_INIT_LIST_HEAD(&the_lnet.ln_nis_cpt);
 	CFS_INIT_LIST_HEAD(&the_lnet.ln_nis_zombie);
@@ -1475,6 +1494,10 @@ LNetNIInit(lnet_pid_t requested_pid)
         if (rc != 0)
                 goto failed1;
 
+	rc = lnet_rails_create(lnet_get_rails());
+	if (rc != 0)
+		goto failed2;
+
         rc = lnet_parse_routes(lnet_get_routes(), &im_a_router);
         if (rc != 0)
                 goto failed2;
@@ -1515,6 +1538,7 @@ LNetNIInit(lnet_pid_t requested_pid)
  failed2:
         lnet_destroy_routes();
         lnet_shutdown_lndnis();
+	lnet_rails_destroy();
  failed1:
         lnet_unprepare();
  failed0:
@@ -1557,6 +1581,7 @@ LNetNIFini()
                 lnet_acceptor_stop();
                 lnet_destroy_routes();
                 lnet_shutdown_lndnis();
+		lnet_rails_destroy();
                 lnet_unprepare();
         }
 
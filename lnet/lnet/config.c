@@ -102,6 +102,9 @@ lnet_ni_free(struct lnet_ni *ni)
 	if (ni->ni_tx_queues != NULL)
 		cfs_percpt_free(ni->ni_tx_queues);
 
+	if (ni->ni_stats != NULL)
+		cfs_percpt_free(ni->ni_stats);
+
 	if (ni->ni_cpts != NULL)
 		cfs_expr_list_values_free(ni->ni_cpts, ni->ni_ncpts);
 
@@ -155,6 +158,11 @@ lnet_ni_alloc(__u32 net, struct cfs_expr_list *el, cfs_list_t *nilist)
 	cfs_percpt_for_each(tq, i, ni->ni_tx_queues)
 		CFS_INIT_LIST_HEAD(&tq->tq_delayed);
 
+	ni->ni_stats = cfs_percpt_alloc(lnet_cpt_table(),
+					sizeof(*ni->ni_stats[0]));
+	if (ni->ni_stats == NULL)
+		goto failed;
+
 	if (el == NULL) {
 		ni->ni_cpts  = NULL;
 		ni->ni_ncpts = LNET_CPT_NUMBER;
@@ -46,6 +46,56 @@ static int local_nid_dist_zero = 1;
 CFS_MODULE_PARM(local_nid_dist_zero, "i", int, 0444,
                 "Reserved");
 
+static int health_sensitivity = 100;
+CFS_MODULE_PARM(health_sensitivity, "i", int, 0644,
+		"Health lost by an NI or peer NI on a send failure "
+		"(0 to disable)");
+
+static int health_recovery = 50;
+CFS_MODULE_PARM(health_recovery, "i", int, 0644,
+		"Health regained by an NI or peer NI per second");
+
+static int retry_count = 2;
+CFS_MODULE_PARM(retry_count, "i", int, 0644,
+		"Times a failed PUT/GET is resent on another path");
+
+/**
+ * Health of an NI or a peer NI, from 0 to LNET_HEALTH_MAX. It drops by
+ * health_sensitivity on each send failure and recovers by health_recovery
+ * per second after the last failure. Computed without locking, the caller
+ * only gets a hint.
+ */
+int
+lnet_health_value(struct lnet_health *health)
+{
+	int	deficit = health->lh_deficit;
+	long	recovered;
+
+	if (deficit == 0)
+		return LNET_HEALTH_MAX;
+
+	/* recovery of more than LNET_HEALTH_MAX seconds is always full */
+	recovered = MIN(cfs_time_current_sec() - health->lh_stamp,
+			LNET_HEALTH_MAX) * MAX(health_recovery, 0);
+	if (recovered >= deficit)
+		return LNET_HEALTH_MAX;
+
+	return LNET_HEALTH_MAX - deficit + recovered;
+}
+
+/* caller serialises updates of \a health */
+void
+lnet_health_fail(struct lnet_health *health)
+{
+	int deficit;
+
+	deficit = LNET_HEALTH_MAX - lnet_health_value(health) +
+		  health_sensitivity;
+
+	health->lh_deficit = MIN(deficit, LNET_HEALTH_MAX);
+	health->lh_stamp   = cfs_time_current_sec();
+}
+
 int
 lnet_fail_nid (lnet_nid_t nid, unsigned int threshold)
 {
@@ -682,9 +732,24 @@ lnet_prep_send(lnet_msg_t *msg, int type, lnet_process_id_t target,
         msg->msg_hdr.payload_length = cpu_to_le32(len);
 }
 
+/**
+ * Finalize \a msg which failed with \a status before any of it left this
+ * node, after trying to resend it on another path.  Only failures like
+ * this may be resent, once the LND has accepted a message the peer can
+ * have got it, whatever the completion status says.
+ */
+static void
+lnet_finalize_unsent(lnet_ni_t *ni, lnet_msg_t *msg, int status)
+{
+	/* an unlinked MD wants no more traffic */
+	if (status == -ECANCELED || lnet_resend(msg, status) != 0)
+		lnet_finalize(ni, msg, status);
+}
+
 void
 lnet_ni_send(lnet_ni_t *ni, lnet_msg_t *msg)
 {
+	struct lnet_peer_rail *rail = msg->msg_rail;
 	void   *priv = msg->msg_private;
 	int     rc;
 
@@ -692,9 +757,16 @@ lnet_ni_send(lnet_ni_t *ni, lnet_msg_t *msg)
 	LASSERT (LNET_NETTYP(LNET_NIDNET(ni->ni_nid)) == LOLND ||
 		 (msg->msg_txcredit && msg->msg_peertxcredit));
 
-	rc = (ni->ni_lnd->lnd_send)(ni, priv, msg);
+	if (rail != NULL &&
+	    CFS_FAIL_CHECK_VALUE(CFS_FAIL_LNET_SEND_RAIL,
+				 rail - rail->pr_set->rs_rails))
+		rc = -EIO;
+	else
+		rc = (ni->ni_lnd->lnd_send)(ni, priv, msg);
+
+	/* the LND refused the message, nothing went on the wire */
 	if (rc < 0)
-		lnet_finalize(ni, msg, rc);
+		lnet_finalize_unsent(ni, msg, rc);
 }
 
 int
@@ -850,7 +922,7 @@ lnet_post_send_locked(lnet_msg_t *msg, int do_send)
 		CNETERR("Dropping message for %s: peer not alive\n",
 			libcfs_id2str(msg->msg_target));
 		if (do_send)
-			lnet_finalize(ni, msg, -EHOSTUNREACH);
+			lnet_finalize_unsent(ni, msg, -EHOSTUNREACH);
 
 		lnet_net_lock(cpt);
 		return EHOSTUNREACH;
@@ -983,11 +1055,14 @@ lnet_post_routed_recv_locked (lnet_msg_t *msg, int do_recv)
                 rbp->rbp_credits--;
                 if (rbp->rbp_credits < rbp->rbp_mincredits)
                         rbp->rbp_mincredits = rbp->rbp_credits;
+		if (rbp->rbp_credits < rbp->rbp_lowcredits)
+			rbp->rbp_lowcredits = rbp->rbp_credits;
 
                 if (rbp->rbp_credits < 0) {
                         /* must have checked eager_recv before here */
 			LASSERT(msg->msg_rx_ready_delay);
 			msg->msg_rx_delayed = 1;
+			rbp->rbp_nwaits++;
                         cfs_list_add_tail(&msg->msg_list, &rbp->rbp_msgs);
                         return EAGAIN;
                 }
@@ -1141,6 +1216,8 @@ lnet_compare_routes(lnet_route_t *r1, lnet_route_t *r2)
 {
 	lnet_peer_t *p1 = r1->lr_gateway;
 	lnet_peer_t *p2 = r2->lr_gateway;
+	int	     h1;
+	int	     h2;
 
 	if (r1->lr_priority < r2->lr_priority)
 		return 1;
@@ -1154,6 +1231,16 @@ lnet_compare_routes(lnet_route_t *r1, lnet_route_t *r2)
 	if (r1->lr_hops > r2->lr_hops)
 		return -1;
 
+	h1 = MIN(lnet_health_value(&p1->lp_health),
+		 lnet_health_value(&p1->lp_ni->ni_health));
+	h2 = MIN(lnet_health_value(&p2->lp_health),
+		 lnet_health_value(&p2->lp_ni->ni_health));
+	if (h1 > h2)
+		return 1;
+
+	if (h1 < h2)
+		return -1;
+
 	if (p1->lp_txqnob < p2->lp_txqnob)
 		return 1;
 
@@ -1234,8 +1321,10 @@ int
 lnet_send(lnet_nid_t src_nid, lnet_msg_t *msg, lnet_nid_t rtr_nid)
 {
 	lnet_nid_t		dst_nid = msg->msg_target.nid;
+	struct lnet_peer_rail	*rail = NULL;
 	struct lnet_ni		*src_ni;
 	struct lnet_ni		*local_ni;
+	struct lnet_peer	*peer = NULL;
 	struct lnet_peer	*lp;
 	int			cpt;
 	int			cpt2;
@@ -1253,11 +1342,34 @@ lnet_send(lnet_nid_t src_nid, lnet_msg_t *msg, lnet_nid_t rtr_nid)
         msg->msg_sending = 1;
 
 	LASSERT(!msg->msg_tx_committed);
+
+	if (rtr_nid == LNET_NID_ANY && !msg->msg_routing) {
+		/* stripe over the NIDs of a multi-rail peer, the peer maps
+		 * my NID back to my primary NID so it can send ACK/REPLY
+		 * on any rail, which lets me override a pre-determined
+		 * source NI as well */
+		rail = lnet_rail_select(dst_nid);
+		if (rail != NULL) {
+			dst_nid = rail->pr_nid;
+			if (src_nid != LNET_NID_ANY)
+				src_nid = rail->pr_ni_nid;
+
+			msg->msg_target.nid = dst_nid;
+			msg->msg_hdr.dest_nid = cpu_to_le64(dst_nid);
+		}
+	}
+
 	cpt = lnet_cpt_of_nid(rtr_nid == LNET_NID_ANY ? dst_nid : rtr_nid);
+	/* a local peer is usually known already, find it without holding
+	 * the lock, it's dropped below if @dst_nid turns out to be remote */
+	if (rtr_nid == LNET_NID_ANY)
+		peer = lnet_find_peer(dst_nid, cpt);
  again:
 	lnet_net_lock(cpt);
 
 	if (the_lnet.ln_shutdown) {
+		if (peer != NULL)
+			lnet_peer_decref_locked(peer);
 		lnet_net_unlock(cpt);
 		return -ESHUTDOWN;
 	}
@@ -1267,6 +1379,8 @@ lnet_send(lnet_nid_t src_nid, lnet_msg_t *msg, lnet_nid_t rtr_nid)
 	} else {
 		src_ni = lnet_nid2ni_locked(src_nid, cpt);
 		if (src_ni == NULL) {
+			if (peer != NULL)
+				lnet_peer_decref_locked(peer);
 			lnet_net_unlock(cpt);
                         LCONSOLE_WARN("Can't send to %s: src %s is not a "
                                       "local nid\n", libcfs_nid2str(dst_nid),
@@ -1288,6 +1402,8 @@ lnet_send(lnet_nid_t src_nid, lnet_msg_t *msg, lnet_nid_t rtr_nid)
 		} else {
 			lnet_ni_decref_locked(local_ni, cpt);
 			lnet_ni_decref_locked(src_ni, cpt);
+			if (peer != NULL)
+				lnet_peer_decref_locked(peer);
 			lnet_net_unlock(cpt);
 			LCONSOLE_WARN("No route to %s via from %s\n",
 				      libcfs_nid2str(dst_nid),
@@ -1298,11 +1414,20 @@ lnet_send(lnet_nid_t src_nid, lnet_msg_t *msg, lnet_nid_t rtr_nid)
 		LASSERT(src_nid != LNET_NID_ANY);
 		lnet_msg_commit(msg, cpt);
 
+		if (rail != NULL) {
+			/* released by lnet_msg_decommit_tx() */
+			msg->msg_rail = rail;
+			rail->pr_inflight++;
+			rail->pr_inflight_nob += msg->msg_len;
+		}
+
 		if (!msg->msg_routing)
 			msg->msg_hdr.src_nid = cpu_to_le64(src_nid);
 
 		if (src_ni == the_lnet.ln_loni) {
 			/* No send credit hassles with LOLND */
+			if (peer != NULL)
+				lnet_peer_decref_locked(peer);
 			lnet_net_unlock(cpt);
 			lnet_ni_send(src_ni, msg);
 
@@ -1312,7 +1437,12 @@ lnet_send(lnet_nid_t src_nid, lnet_msg_t *msg, lnet_nid_t rtr_nid)
 			return 0;
 		}
 
-		rc = lnet_nid2peer_locked(&lp, dst_nid, cpt);
+		if (peer != NULL) {
+			lp = peer;	/* my ref from lnet_find_peer() */
+			rc = 0;
+		} else {
+			rc = lnet_nid2peer_locked(&lp, dst_nid, cpt);
+		}
 		/* lp has ref on src_ni; lose mine */
 		lnet_ni_decref_locked(src_ni, cpt);
 		if (rc != 0) {
@@ -1324,6 +1454,10 @@ lnet_send(lnet_nid_t src_nid, lnet_msg_t *msg, lnet_nid_t rtr_nid)
                 }
                 LASSERT (lp->lp_ni == src_ni);
         } else {
+		if (peer != NULL) {
+			lnet_peer_decref_locked(peer);
+			peer = NULL;
+		}
 #ifndef __KERNEL__
 		lnet_net_unlock(cpt);
 
@@ -1415,6 +1549,65 @@ lnet_send(lnet_nid_t src_nid, lnet_msg_t *msg, lnet_nid_t rtr_nid)
 	return 0; /* rc == 0 or EAGAIN */
 }
 
+/**
+ * Resend a PUT or GET I originated which failed with \a status before it
+ * left this node, if it went to a multi-rail peer or through a router, so
+ * that lnet_send() can pick another rail or router now the failed one lost
+ * health.  Called by lnet_finalize_unsent() only, a message the LND has
+ * accepted may have reached the peer and must not be sent again.
+ *
+ * \retval 0 the message has been resent, don't finalize it
+ * \retval -ve the message should be finalized with \a status
+ */
+int
+lnet_resend(lnet_msg_t *msg, int status)
+{
+	lnet_nid_t	src_nid;
+	int		cpt;
+	int		rc;
+
+	LASSERT(status != 0);
+
+	if (msg->msg_retry_count >= MIN(retry_count, 15) ||
+	    !msg->msg_tx_committed || msg->msg_rx_committed ||
+	    msg->msg_routing || msg->msg_md == NULL ||
+	    (msg->msg_type != LNET_MSG_PUT && msg->msg_type != LNET_MSG_GET))
+		return -EINVAL;
+
+	/* there is no other path */
+	if (msg->msg_rail == NULL && !msg->msg_target_is_router)
+		return -EHOSTUNREACH;
+
+	if (the_lnet.ln_shutdown)
+		return -ESHUTDOWN;
+
+	/* return credits, account the failure and degrade health */
+	cpt = msg->msg_tx_cpt;
+	lnet_net_lock(cpt);
+	lnet_msg_decommit(msg, cpt, status);
+	lnet_net_unlock(cpt);
+
+	msg->msg_retry_count++;
+	msg->msg_sending = 0;
+	msg->msg_tx_delayed = 0;
+	msg->msg_target_is_router = 0;
+	/* lnet_send() may have replaced the target by a rail or a router */
+	msg->msg_target.nid = le64_to_cpu(msg->msg_hdr.dest_nid);
+	msg->msg_target.pid = le32_to_cpu(msg->msg_hdr.dest_pid);
+	src_nid = le64_to_cpu(msg->msg_hdr.src_nid);
+
+	CDEBUG(D_NET, "Resending %s to %s (%d), attempt %d\n",
+	       lnet_msgtyp2str(msg->msg_type), libcfs_id2str(msg->msg_target),
+	       status, msg->msg_retry_count);
+
+	rc = lnet_send(src_nid, msg, LNET_NID_ANY);
+	if (rc != 0)
+		CNETERR("Error resending %s to %s: %d\n",
+			lnet_msgtyp2str(msg->msg_type),
+			libcfs_id2str(msg->msg_target), rc);
+	return rc;
+}
+
 static void
 lnet_drop_message(lnet_ni_t *ni, int cpt, void *private, unsigned int nob)
 {
@@ -1936,17 +2129,23 @@ lnet_parse(lnet_ni_t *ni, lnet_hdr_t *hdr, lnet_nid_t from_nid,
 		msg->msg_routing	= 1;
 
 	} else {
-		/* convert common msg->hdr fields to host byteorder */
+		/* convert common msg->hdr fields to host byteorder, and
+		 * identify a multi-rail sender by its primary NID whichever
+		 * rail the message came in on */
 		msg->msg_hdr.type	= type;
-		msg->msg_hdr.src_nid	= src_nid;
+		msg->msg_hdr.src_nid	= lnet_rail_primary(src_nid);
 		msg->msg_hdr.src_pid	= le32_to_cpu(msg->msg_hdr.src_pid);
 		msg->msg_hdr.dest_nid	= dest_nid;
 		msg->msg_hdr.dest_pid	= dest_pid;
 		msg->msg_hdr.payload_length = payload_length;
 	}
 
+	/* the sender is usually known, find it without holding the lock */
+	msg->msg_rxpeer = lnet_find_peer(from_nid, cpt);
+
 	lnet_net_lock(cpt);
-	rc = lnet_nid2peer_locked(&msg->msg_rxpeer, from_nid, cpt);
+	if (msg->msg_rxpeer == NULL)
+		rc = lnet_nid2peer_locked(&msg->msg_rxpeer, from_nid, cpt);
 	if (rc != 0) {
 		lnet_net_unlock(cpt);
 		CERROR("%s, src %s: Dropping %s "
@@ -2205,7 +2404,7 @@ LNetPut(lnet_nid_t self, lnet_handle_md_t mdh, lnet_ack_req_t ack,
         if (rc != 0) {
                 CNETERR( "Error sending PUT to %s: %d\n",
                        libcfs_id2str(target), rc);
-                lnet_finalize (NULL, msg, rc);
+		lnet_finalize_unsent(NULL, msg, rc);
         }
 
         /* completion will be signalled by an event */
@@ -2258,7 +2457,7 @@ lnet_create_reply_msg (lnet_ni_t *ni, lnet_msg_t *getmsg)
 	/* setup information for lnet_build_msg_event */
 	msg->msg_from = peer_id.nid;
 	msg->msg_type = LNET_MSG_GET; /* flag this msg as an "optimized" GET */
-	msg->msg_hdr.src_nid = peer_id.nid;
+	msg->msg_hdr.src_nid = lnet_rail_primary(peer_id.nid);
 	msg->msg_hdr.payload_length = getmd->md_length;
 	msg->msg_receiving = 1; /* required by lnet_msg_attach_md */
 
@@ -2398,7 +2597,7 @@ LNetGet(lnet_nid_t self, lnet_handle_md_t mdh,
 	if (rc < 0) {
 		CNETERR("Error sending GET to %s: %d\n",
 			libcfs_id2str(target), rc);
-		lnet_finalize(NULL, msg, rc);
+		lnet_finalize_unsent(NULL, msg, rc);
 	}
 
         /* completion will be signalled by an event */
@@ -169,6 +169,64 @@ lnet_msg_commit(lnet_msg_t *msg, int cpt)
 		counters->msgs_max = counters->msgs_alloc;
 }
 
+static void
+lnet_msg_stats_tx(lnet_msg_t *msg, int status)
+{
+	struct lnet_peer_rail	*rail = msg->msg_rail;
+	struct lnet_ni_stats	*stats;
+	struct lnet_ni		*ni;
+
+	if (rail != NULL) {
+		/* msg_tx_cpt is the CPT of rail->pr_nid */
+		LASSERT(rail->pr_inflight > 0);
+		rail->pr_inflight--;
+		rail->pr_inflight_nob -= msg->msg_len;
+		if (status == 0) {
+			rail->pr_send_count++;
+			rail->pr_send_length += msg->msg_len;
+		} else {
+			rail->pr_errors++;
+			lnet_health_fail(&rail->pr_health);
+		}
+		msg->msg_rail = NULL;
+	}
+
+	if (msg->msg_txpeer == NULL) /* loopback */
+		return;
+
+	ni = msg->msg_txpeer->lp_ni;
+	stats = ni->ni_stats[msg->msg_tx_cpt];
+	if (status == 0) {
+		stats->nis_send_count++;
+		stats->nis_send_length += msg->msg_len;
+		return;
+	}
+
+	stats->nis_errors++;
+	lnet_health_fail(&msg->msg_txpeer->lp_health);
+
+	lnet_ni_lock(ni);
+	lnet_health_fail(&ni->ni_health);
+	lnet_ni_unlock(ni);
+}
+
+static void
+lnet_msg_stats_rx(lnet_msg_t *msg, int status)
+{
+	struct lnet_ni_stats *stats;
+
+	if (msg->msg_rxpeer == NULL)
+		return;
+
+	stats = msg->msg_rxpeer->lp_ni->ni_stats[msg->msg_rx_cpt];
+	if (status == 0) {
+		stats->nis_recv_count++;
+		stats->nis_recv_length += msg->msg_wanted;
+	} else {
+		stats->nis_errors++;
+	}
+}
+
 static void
 lnet_msg_decommit_tx(lnet_msg_t *msg, int status)
 {
@@ -176,6 +234,7 @@ lnet_msg_decommit_tx(lnet_msg_t *msg, int status)
 	lnet_event_t	*ev = &msg->msg_ev;
 
 	LASSERT(msg->msg_tx_committed);
+	lnet_msg_stats_tx(msg, status);
 	if (status != 0)
 		goto out;
 
@@ -228,6 +287,7 @@ lnet_msg_decommit_rx(lnet_msg_t *msg, int status)
 	LASSERT(!msg->msg_tx_committed); /* decommitted or never committed */
 	LASSERT(msg->msg_rx_committed);
 
+	lnet_msg_stats_rx(msg, status);
 	if (status != 0)
 		goto out;
 
@@ -447,6 +507,7 @@ lnet_finalize (lnet_ni_t *ni, lnet_msg_t *msg, int status)
 
 	if (msg == NULL)
 		return;
+
 #if 0
         CDEBUG(D_WARNING, "%s msg->%s Flags:%s%s%s%s%s%s%s%s%s%s%s txp %s rxp %s\n",
                lnet_msgtyp2str(msg->msg_type), libcfs_id2str(msg->msg_target),
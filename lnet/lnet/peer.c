@@ -112,6 +112,13 @@ lnet_peer_tables_cleanup(void)
 
 	LASSERT(the_lnet.ln_shutdown);	/* i.e. no new peers */
 
+	/* lnet_find_peer() checks ln_shutdown under rcu_read_lock(), so no
+	 * lockless reader is walking the hash after a grace period, and
+	 * unlinked peers can be moved to the deathrow right away */
+#ifdef __KERNEL__
+	synchronize_rcu();
+#endif
+
 	cfs_percpt_for_each(ptable, i, the_lnet.ln_peer_tables) {
 		lnet_net_lock(i);
 
@@ -166,7 +173,7 @@ lnet_destroy_peer_locked(lnet_peer_t *lp)
 {
 	struct lnet_peer_table *ptable;
 
-	LASSERT(lp->lp_refcount == 0);
+	LASSERT(cfs_atomic_read(&lp->lp_refcount) == 0);
 	LASSERT(lp->lp_rtr_refcount == 0);
 	LASSERT(cfs_list_empty(&lp->lp_txq));
 	LASSERT(cfs_list_empty(&lp->lp_hashlist));
@@ -201,6 +208,48 @@ lnet_find_peer_locked(struct lnet_peer_table *ptable, lnet_nid_t nid)
 	return NULL;
 }
 
+/**
+ * Find the peer \a nid in the peer table of \a cpt and take a reference on
+ * it, without taking lnet_net_lock(). Peers are only removed from the hash
+ * at shutdown, so the walk only races with insertions, which are RCU-safe.
+ * Returns NULL if there is no such peer, the caller then has to create it
+ * by lnet_nid2peer_locked().
+ */
+lnet_peer_t *
+lnet_find_peer(lnet_nid_t nid, int cpt)
+{
+	struct lnet_peer_table	*ptable = the_lnet.ln_peer_tables[cpt];
+	lnet_peer_t		*found = NULL;
+#ifdef __KERNEL__
+	cfs_list_t		*peers;
+	lnet_peer_t		*lp;
+
+	rcu_read_lock();
+	if (the_lnet.ln_shutdown)
+		goto out;
+
+	peers = &ptable->pt_hash[lnet_nid2peerhash(nid)];
+	cfs_list_for_each_entry_rcu(lp, peers, lp_hashlist) {
+		if (lp->lp_nid != nid)
+			continue;
+
+		/* the hash holds a reference, so it can only be dying at
+		 * shutdown */
+		if (cfs_atomic_inc_not_zero(&lp->lp_refcount))
+			found = lp;
+		break;
+	}
+ out:
+	rcu_read_unlock();
+#else
+	lnet_net_lock(cpt);
+	if (!the_lnet.ln_shutdown)
+		found = lnet_find_peer_locked(ptable, nid);
+	lnet_net_unlock(cpt);
+#endif
+	return found;
+}
+
 int
 lnet_nid2peer_locked(lnet_peer_t **lpp, lnet_nid_t nid, int cpt)
 {
@@ -264,7 +313,7 @@ lnet_nid2peer_locked(lnet_peer_t **lpp, lnet_nid_t nid, int cpt)
 	lp->lp_ping_feats = LNET_PING_FEAT_INVAL;
 	lp->lp_nid = nid;
 	lp->lp_cpt = cpt2;
-	lp->lp_refcount = 2;	/* 1 for caller; 1 for hash */
+	cfs_atomic_set(&lp->lp_refcount, 2);	/* 1 for caller; 1 for hash */
 	lp->lp_rtr_refcount = 0;
 
 	lnet_net_lock(cpt);
@@ -291,8 +340,9 @@ lnet_nid2peer_locked(lnet_peer_t **lpp, lnet_nid_t nid, int cpt)
 	lp->lp_rtrcredits    =
 	lp->lp_minrtrcredits = lnet_peer_buffer_credits(lp->lp_ni);
 
-	cfs_list_add_tail(&lp->lp_hashlist,
-			  &ptable->pt_hash[lnet_nid2peerhash(nid)]);
+	/* publish it to lnet_find_peer() */
+	cfs_list_add_tail_rcu(&lp->lp_hashlist,
+			      &ptable->pt_hash[lnet_nid2peerhash(nid)]);
 	ptable->pt_version++;
 	*lpp = lp;
 
@@ -326,7 +376,7 @@ lnet_debug_peer(lnet_nid_t nid)
                 aliveness = lp->lp_alive ? "up" : "down";
 
         CDEBUG(D_WARNING, "%-24s %4d %5s %5d %5d %5d %5d %5d %ld\n",
-               libcfs_nid2str(lp->lp_nid), lp->lp_refcount,
+               libcfs_nid2str(lp->lp_nid), cfs_atomic_read(&lp->lp_refcount),
                aliveness, lp->lp_ni->ni_peertxcredits,
                lp->lp_rtrcredits, lp->lp_minrtrcredits,
                lp->lp_txcredits, lp->lp_mintxcredits, lp->lp_txqnob);
@@ -335,3 +385,250 @@ lnet_debug_peer(lnet_nid_t nid)
 
 	lnet_net_unlock(cpt);
 }
+
+static struct lnet_peer_rail *
+lnet_rail_find(lnet_nid_t nid)
+{
+	struct lnet_peer_rail	*rail;
+	cfs_list_t		*head;
+
+	if (the_lnet.ln_rail_hash == NULL)
+		return NULL;
+
+	head = &the_lnet.ln_rail_hash[lnet_nid2peerhash(nid)];
+	cfs_list_for_each_entry(rail, head, pr_hash) {
+		if (rail->pr_nid == nid)
+			return rail;
+	}
+	return NULL;
+}
+
+/**
+ * Map \a nid to the NID identifying its multi-rail peer, so that messages
+ * arriving over any rail of the peer match the same MEs and reach the same
+ * export. Returns \a nid itself if it isn't a rail of a multi-rail peer.
+ */
+lnet_nid_t
+lnet_rail_primary(lnet_nid_t nid)
+{
+	struct lnet_peer_rail *rail = lnet_rail_find(nid);
+
+	return rail == NULL ? nid : rail->pr_set->rs_rails[0].pr_nid;
+}
+
+static int
+lnet_rail_health(struct lnet_peer_rail *rail)
+{
+	return MIN(lnet_health_value(&rail->pr_health),
+		   lnet_health_value(&rail->pr_ni->ni_health));
+}
+
+/**
+ * Choose the rail to send to a multi-rail peer \a nid on, among rails
+ * reachable on a local network: the healthiest one, then the one with the
+ * fewest bytes in flight, then the fewest messages. Ties are broken
+ * round-robin so an idle peer is still striped. Returns NULL if \a nid
+ * isn't a multi-rail peer.
+ */
+struct lnet_peer_rail *
+lnet_rail_select(lnet_nid_t nid)
+{
+	struct lnet_peer_rail	*rail = lnet_rail_find(nid);
+	struct lnet_peer_rail	*best = NULL;
+	struct lnet_rail_set	*set;
+	unsigned int		start;
+	int			best_health = -1;
+	int			health;
+	int			i;
+
+	if (rail == NULL)
+		return NULL;
+
+	set = rail->pr_set;
+	if (set->rs_self) /* don't stripe messages to myself */
+		return NULL;
+
+	start = set->rs_rotor++;
+	for (i = 0; i < set->rs_nrails; i++) {
+		rail = &set->rs_rails[(start + i) % set->rs_nrails];
+		if (rail->pr_ni == NULL)
+			continue;
+
+		health = lnet_rail_health(rail);
+		if (health < best_health)
+			continue;
+
+		if (health > best_health ||
+		    rail->pr_inflight_nob < best->pr_inflight_nob ||
+		    (rail->pr_inflight_nob == best->pr_inflight_nob &&
+		     rail->pr_inflight < best->pr_inflight)) {
+			best = rail;
+			best_health = health;
+		}
+	}
+	return best;
+}
+
+static int
+lnet_rail_add(struct lnet_rail_set *set, lnet_nid_t nid)
+{
+	struct lnet_peer_rail	*rail;
+	cfs_list_t		*tmp;
+	int			i;
+
+	if (set->rs_nrails == LNET_MAX_RAILS) {
+		CERROR("Too many rails for peer %s (max %d)\n",
+		       libcfs_nid2str(set->rs_rails[0].pr_nid),
+		       LNET_MAX_RAILS);
+		return -E2BIG;
+	}
+
+	if (lnet_rail_find(nid) != NULL) {
+		CERROR("Rail %s is specified twice\n", libcfs_nid2str(nid));
+		return -EINVAL;
+	}
+
+	for (i = 0; i < set->rs_nrails; i++) {
+		if (LNET_NIDNET(set->rs_rails[i].pr_nid) == LNET_NIDNET(nid)) {
+			CERROR("Rails %s and %s are on the same network\n",
+			       libcfs_nid2str(set->rs_rails[i].pr_nid),
+			       libcfs_nid2str(nid));
+			return -EINVAL;
+		}
+	}
+
+	rail = &set->rs_rails[set->rs_nrails++];
+	rail->pr_set	= set;
+	rail->pr_nid	= nid;
+	rail->pr_ni_nid	= LNET_NID_ANY;
+
+	/* A rail on a net I have no NI on is only used to map its NID to
+	 * the primary one, lnet_rail_select() never sends on it.
+	 * NIs don't change until shutdown */
+	lnet_net_lock(0);
+	cfs_list_for_each(tmp, &the_lnet.ln_nis) {
+		lnet_ni_t *ni = cfs_list_entry(tmp, lnet_ni_t, ni_list);
+
+		if (LNET_NIDNET(ni->ni_nid) != LNET_NIDNET(nid))
+			continue;
+
+		rail->pr_ni	= ni;
+		rail->pr_ni_nid	= ni->ni_nid;
+		if (ni->ni_nid == nid)
+			set->rs_self = 1;
+		break;
+	}
+	lnet_net_unlock(0);
+
+	cfs_list_add_tail(&rail->pr_hash,
+			  &the_lnet.ln_rail_hash[lnet_nid2peerhash(nid)]);
+	return 0;
+}
+
+/**
+ * Build multi-rail peers from \a rails, a list of peers separated by ';' or
+ * white space, each of them a ',' separated list of its NIDs on different
+ * networks, primary NID first, e.g. "10.0.0.1@o2ib,10.1.0.1@o2ib1". The
+ * same list should be given to all nodes so both ends of a connection agree
+ * on peer identity.
+ */
+int
+lnet_rails_create(char *rails)
+{
+	struct lnet_rail_set	*set;
+	char			*buf;
+	char			*str;
+	char			*peer;
+	char			*nidstr;
+	lnet_nid_t		nid;
+	int			len;
+	int			rc = 0;
+	int			i;
+
+	LASSERT(cfs_list_empty(&the_lnet.ln_rail_sets));
+	LASSERT(the_lnet.ln_rail_hash == NULL);
+
+	if (*rails == 0)
+		return 0;
+
+	len = strlen(rails) + 1;
+	LIBCFS_ALLOC(buf, len);
+	if (buf == NULL)
+		return -ENOMEM;
+	memcpy(buf, rails, len);
+
+	LIBCFS_ALLOC(the_lnet.ln_rail_hash,
+		     LNET_PEER_HASH_SIZE * sizeof(cfs_list_t));
+	if (the_lnet.ln_rail_hash == NULL) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < LNET_PEER_HASH_SIZE; i++)
+		CFS_INIT_LIST_HEAD(&the_lnet.ln_rail_hash[i]);
+
+	str = buf;
+	while ((peer = strsep(&str, "; \t\n")) != NULL) {
+		if (*peer == 0)
+			continue;
+
+		LIBCFS_ALLOC(set, sizeof(*set));
+		if (set == NULL) {
+			rc = -ENOMEM;
+			goto out;
+		}
+		cfs_list_add_tail(&set->rs_list, &the_lnet.ln_rail_sets);
+
+		while ((nidstr = strsep(&peer, ",")) != NULL) {
+			if (*nidstr == 0)
+				continue;
+
+			nid = libcfs_str2nid(nidstr);
+			if (nid == LNET_NID_ANY) {
+				CERROR("Invalid rail NID: %s\n", nidstr);
+				rc = -EINVAL;
+				goto out;
+			}
+
+			rc = lnet_rail_add(set, nid);
+			if (rc != 0)
+				goto out;
+		}
+
+		if (set->rs_nrails < 2) {
+			CERROR("Multi-rail peer %s needs at least 2 NIDs\n",
+			       set->rs_nrails == 0 ? "<none>" :
+			       libcfs_nid2str(set->rs_rails[0].pr_nid));
+			rc = -EINVAL;
+			goto out;
+		}
+
+		LCONSOLE_INFO("Multi-rail peer %s: %d rails\n",
+			      libcfs_nid2str(set->rs_rails[0].pr_nid),
+			      set->rs_nrails);
+	}
+ out:
+	LIBCFS_FREE(buf, len);
+	if (rc != 0)
+		lnet_rails_destroy();
+	return rc;
+}
+
+void
+lnet_rails_destroy(void)
+{
+	struct lnet_rail_set *set;
+
+	while (!cfs_list_empty(&the_lnet.ln_rail_sets)) {
+		set = cfs_list_entry(the_lnet.ln_rail_sets.next,
+				     struct lnet_rail_set, rs_list);
+		cfs_list_del(&set->rs_list);
+		LIBCFS_FREE(set, sizeof(*set));
+	}
+
+	if (the_lnet.ln_rail_hash != NULL) {
+		LIBCFS_FREE(the_lnet.ln_rail_hash,
+			    LNET_PEER_HASH_SIZE * sizeof(cfs_list_t));
+		the_lnet.ln_rail_hash = NULL;
+	}
+}
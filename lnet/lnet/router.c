@@ -49,6 +49,12 @@ CFS_MODULE_PARM(large_router_buffers, "i", int, 0444,
 static int peer_buffer_credits = 0;
 CFS_MODULE_PARM(peer_buffer_credits, "i", int, 0444,
                 "# router buffer credits per peer");
+static int router_buffers_rebalance = 10;
+CFS_MODULE_PARM(router_buffers_rebalance, "i", int, 0644,
+		"Seconds between resizing router buffer pools (0 to disable)");
+static int router_buffers_max_scale = 4;
+CFS_MODULE_PARM(router_buffers_max_scale, "i", int, 0444,
+		"Max times a router buffer pool grows beyond its initial size");
 
 static int auto_down = 1;
 CFS_MODULE_PARM(auto_down, "i", int, 0444,
@@ -129,8 +135,13 @@ lnet_notify_locked(lnet_peer_t *lp, int notifylnd, int alive, cfs_time_t when)
         lp->lp_alive = !(!alive);               /* 1 bit! */
         lp->lp_notify = 1;
         lp->lp_notifylnd |= notifylnd;
-	if (lp->lp_alive)
+	if (lp->lp_alive) {
 		lp->lp_ping_feats = LNET_PING_FEAT_INVAL; /* reset */
+	} else {
+		/* recover gradually when it comes back */
+		lp->lp_health.lh_deficit = LNET_HEALTH_MAX;
+		lp->lp_health.lh_stamp	 = cfs_time_current_sec();
+	}
 
 	CDEBUG(D_NET, "set %s %d\n", libcfs_nid2str(lp->lp_nid), alive);
 }
@@ -176,7 +187,7 @@ lnet_ni_notify_locked(lnet_ni_t *ni, lnet_peer_t *lp)
 static void
 lnet_rtr_addref_locked(lnet_peer_t *lp)
 {
-	LASSERT(lp->lp_refcount > 0);
+	LASSERT(cfs_atomic_read(&lp->lp_refcount) > 0);
 	LASSERT(lp->lp_rtr_refcount >= 0);
 
 	/* lnet_net_lock must be exclusively locked */
@@ -203,7 +214,7 @@ lnet_rtr_addref_locked(lnet_peer_t *lp)
 static void
 lnet_rtr_decref_locked(lnet_peer_t *lp)
 {
-	LASSERT(lp->lp_refcount > 0);
+	LASSERT(cfs_atomic_read(&lp->lp_refcount) > 0);
 	LASSERT(lp->lp_rtr_refcount > 0);
 
 	/* lnet_net_lock must be exclusively locked */
@@ -1230,6 +1241,8 @@ lnet_prune_rc_data(int wait_unlink)
 
 #if defined(__KERNEL__) && defined(LNET_ROUTER)
 
+static void lnet_rtrpools_rebalance(void);
+
 static int
 lnet_router_checker(void *arg)
 {
@@ -1276,6 +1289,9 @@ rescan:
 
 		lnet_net_unlock(cpt);
 
+		if (the_lnet.ln_routing)
+			lnet_rtrpools_rebalance();
+
 		lnet_prune_rc_data(0); /* don't wait for UNLINK */
 
 		/* Call cfs_pause() here always adds 1 to load average
@@ -1392,6 +1408,7 @@ lnet_rtrpool_alloc_bufs(lnet_rtrbufpool_t *rbp, int nbufs, int cpt)
                 rbp->rbp_nbuffers++;
                 rbp->rbp_credits++;
                 rbp->rbp_mincredits++;
+		rbp->rbp_lowcredits++;
                 cfs_list_add(&rb->rb_list, &rbp->rbp_bufs);
 
                 /* No allocation "under fire" */
@@ -1404,7 +1421,7 @@ lnet_rtrpool_alloc_bufs(lnet_rtrbufpool_t *rbp, int nbufs, int cpt)
 }
 
 void
-lnet_rtrpool_init(lnet_rtrbufpool_t *rbp, int npages)
+lnet_rtrpool_init(lnet_rtrbufpool_t *rbp, int npages, int nmin, int nmax)
 {
         CFS_INIT_LIST_HEAD(&rbp->rbp_msgs);
         CFS_INIT_LIST_HEAD(&rbp->rbp_bufs);
@@ -1412,6 +1429,127 @@ lnet_rtrpool_init(lnet_rtrbufpool_t *rbp, int npages)
         rbp->rbp_npages = npages;
         rbp->rbp_credits = 0;
         rbp->rbp_mincredits = 0;
+	rbp->rbp_nmin = nmin;
+	rbp->rbp_nmax = nmax;
+}
+
+static void
+lnet_rtrpool_grow(lnet_rtrbufpool_t *rbp, int nbufs, int cpt)
+{
+	CFS_LIST_HEAD	(bufs);
+	lnet_rtrbuf_t	*rb;
+	lnet_msg_t	*msg;
+	int		i;
+
+	/* allocate without the lock, then add the buffers one by one, just
+	 * like lnet_return_rx_credits_locked() does */
+	for (i = 0; i < nbufs; i++) {
+		rb = lnet_new_rtrbuf(rbp, cpt);
+		if (rb == NULL)
+			break;
+		cfs_list_add(&rb->rb_list, &bufs);
+	}
+
+	CDEBUG(D_NET, "Grow %d page router buffers on CPT %d: %d + %d\n",
+	       rbp->rbp_npages, cpt, rbp->rbp_nbuffers, i);
+
+	lnet_net_lock(cpt);
+	while (!cfs_list_empty(&bufs)) {
+		rb = cfs_list_entry(bufs.next, lnet_rtrbuf_t, rb_list);
+		cfs_list_move(&rb->rb_list, &rbp->rbp_bufs);
+
+		rbp->rbp_nbuffers++;
+		rbp->rbp_credits++;
+		if (rbp->rbp_credits <= 0) {
+			msg = cfs_list_entry(rbp->rbp_msgs.next,
+					     lnet_msg_t, msg_list);
+			cfs_list_del(&msg->msg_list);
+
+			/* NB: drops and retakes the lock */
+			(void) lnet_post_routed_recv_locked(msg, 1);
+		}
+	}
+	lnet_net_unlock(cpt);
+}
+
+static void
+lnet_rtrpool_shrink(lnet_rtrbufpool_t *rbp, int nbufs, int cpt)
+{
+	CFS_LIST_HEAD	(bufs);
+	lnet_rtrbuf_t	*rb;
+
+	lnet_net_lock(cpt);
+	/* only free buffers can go, busy ones stay with their messages */
+	while (nbufs-- > 0 && rbp->rbp_credits > 0) {
+		LASSERT(!cfs_list_empty(&rbp->rbp_bufs));
+
+		rb = cfs_list_entry(rbp->rbp_bufs.next, lnet_rtrbuf_t, rb_list);
+		cfs_list_move(&rb->rb_list, &bufs);
+
+		rbp->rbp_nbuffers--;
+		rbp->rbp_credits--;
+		if (rbp->rbp_credits < rbp->rbp_lowcredits)
+			rbp->rbp_lowcredits = rbp->rbp_credits;
+	}
+	lnet_net_unlock(cpt);
+
+	while (!cfs_list_empty(&bufs)) {
+		rb = cfs_list_entry(bufs.next, lnet_rtrbuf_t, rb_list);
+		cfs_list_del(&rb->rb_list);
+		lnet_destroy_rtrbuf(rb, rbp->rbp_npages);
+	}
+}
+
+/* Resize router buffer pools from what happened since the last call:
+ * a pool which had messages waiting for a buffer grows by a quarter
+ * (or by the number of waits if it's more), a pool which never had more
+ * than half its buffers busy gives back half of its idle ones. Pools
+ * stay within [rbp_nmin, rbp_nmax] */
+static void
+lnet_rtrpools_rebalance(void)
+{
+	static long		last;
+	long			now = cfs_time_current_sec();
+	lnet_rtrbufpool_t	*rtrp;
+	lnet_rtrbufpool_t	*rbp;
+	__u64			nwaits;
+	int			nbuffers;
+	int			nbufs;
+	int			low;
+	int			idx;
+	int			i;
+
+	if (router_buffers_rebalance <= 0 ||
+	    now < last + router_buffers_rebalance)
+		return;
+
+	last = now;
+
+	cfs_percpt_for_each(rtrp, i, the_lnet.ln_rtrpools) {
+		for (idx = 0; idx < LNET_NRBPOOLS; idx++) {
+			rbp = &rtrp[idx];
+
+			lnet_net_lock(i);
+			nwaits = rbp->rbp_nwaits - rbp->rbp_nwaits_seen;
+			rbp->rbp_nwaits_seen = rbp->rbp_nwaits;
+			low = rbp->rbp_lowcredits;
+			rbp->rbp_lowcredits = rbp->rbp_credits;
+			nbuffers = rbp->rbp_nbuffers;
+			lnet_net_unlock(i);
+
+			if (nwaits > 0 && nbuffers < rbp->rbp_nmax) {
+				nbufs = min_t(__u64, nwaits, rbp->rbp_nmax);
+				nbufs = max(nbufs, nbuffers / 4);
+				nbufs = min(nbufs, rbp->rbp_nmax - nbuffers);
+				lnet_rtrpool_grow(rbp, nbufs, i);
+
+			} else if (nwaits == 0 && low > nbuffers / 2 &&
+				   nbuffers > rbp->rbp_nmin) {
+				nbufs = min(low / 2, nbuffers - rbp->rbp_nmin);
+				lnet_rtrpool_shrink(rbp, nbufs, i);
+			}
+		}
+	}
 }
 
 void
@@ -1538,18 +1676,24 @@ lnet_rtrpools_alloc(int im_a_router)
 		return -ENOMEM;
 	}
 
+	if (router_buffers_max_scale < 1)
+		router_buffers_max_scale = 1;
+
 	cfs_percpt_for_each(rtrp, i, the_lnet.ln_rtrpools) {
-		lnet_rtrpool_init(&rtrp[0], 0);
+		lnet_rtrpool_init(&rtrp[0], 0, LNET_NRB_TINY_MIN,
+				  nrb_tiny * router_buffers_max_scale);
 		rc = lnet_rtrpool_alloc_bufs(&rtrp[0], nrb_tiny, i);
 		if (rc != 0)
 			goto failed;
 
-		lnet_rtrpool_init(&rtrp[1], small_pages);
+		lnet_rtrpool_init(&rtrp[1], small_pages, LNET_NRB_SMALL_MIN,
+				  nrb_small * router_buffers_max_scale);
 		rc = lnet_rtrpool_alloc_bufs(&rtrp[1], nrb_small, i);
 		if (rc != 0)
 			goto failed;
 
-		lnet_rtrpool_init(&rtrp[2], large_pages);
+		lnet_rtrpool_init(&rtrp[2], large_pages, LNET_NRB_LARGE_MIN,
+				  nrb_large * router_buffers_max_scale);
 		rc = lnet_rtrpool_alloc_bufs(&rtrp[2], nrb_large, i);
 		if (rc != 0)
 			goto failed;
@@ -42,6 +42,8 @@ enum {
         PSDEV_LNET_BUFFERS,
         PSDEV_LNET_NIS,
 	PSDEV_LNET_PTL_ROTOR,
+	PSDEV_LNET_NI_STATS,
+	PSDEV_LNET_RAILS,
 };
 #else
 #define CTL_LNET           CTL_UNNUMBERED
@@ -52,6 +54,8 @@ enum {
 #define PSDEV_LNET_BUFFERS CTL_UNNUMBERED
 #define PSDEV_LNET_NIS     CTL_UNNUMBERED
 #define PSDEV_LNET_PTL_ROTOR	CTL_UNNUMBERED
+#define PSDEV_LNET_NI_STATS	CTL_UNNUMBERED
+#define PSDEV_LNET_RAILS	CTL_UNNUMBERED
 #endif
 
 #define LNET_LOFFT_BITS		(sizeof(loff_t) * 8)
@@ -350,7 +354,7 @@ int LL_PROC_PROTO(proc_lnet_routers)
                         lnet_nid_t nid = peer->lp_nid;
                         cfs_time_t now = cfs_time_current();
                         cfs_time_t deadline = peer->lp_ping_deadline;
-                        int nrefs     = peer->lp_refcount;
+                        int nrefs     = cfs_atomic_read(&peer->lp_refcount);
                         int nrtrrefs  = peer->lp_rtr_refcount;
                         int alive_cnt = peer->lp_alive_count;
                         int alive     = peer->lp_alive;
@@ -511,7 +515,8 @@ int LL_PROC_PROTO(proc_lnet_peers)
 
                 if (peer != NULL) {
                         lnet_nid_t nid       = peer->lp_nid;
-                        int        nrefs     = peer->lp_refcount;
+                        int        nrefs     =
+				cfs_atomic_read(&peer->lp_refcount);
                         int        lastalive = -1;
                         char      *aliveness = "NA";
                         int        maxcr     = peer->lp_ni->ni_peertxcredits;
@@ -594,8 +599,8 @@ static int __proc_lnet_buffers(void *data, int write,
 
 	LASSERT(!write);
 
-	/* (4 %d) * 4 * LNET_CPT_NUMBER */
-	tmpsiz = 64 * (LNET_NRBPOOLS + 1) * LNET_CPT_NUMBER;
+	/* (4 %d + 1 %llu) * 4 * LNET_CPT_NUMBER */
+	tmpsiz = 80 * (LNET_NRBPOOLS + 1) * LNET_CPT_NUMBER;
         LIBCFS_ALLOC(tmpstr, tmpsiz);
         if (tmpstr == NULL)
                 return -ENOMEM;
@@ -603,8 +608,8 @@ static int __proc_lnet_buffers(void *data, int write,
         s = tmpstr; /* points to current position in tmpstr[] */
 
         s += snprintf(s, tmpstr + tmpsiz - s,
-                      "%5s %5s %7s %7s\n",
-                      "pages", "count", "credits", "min");
+		      "%5s %5s %7s %7s %9s\n",
+		      "pages", "count", "credits", "min", "waits");
         LASSERT (tmpstr + tmpsiz - s > 0);
 
 	if (the_lnet.ln_rtrpools == NULL)
@@ -616,11 +621,12 @@ static int __proc_lnet_buffers(void *data, int write,
 		lnet_net_lock(LNET_LOCK_EX);
 		cfs_percpt_for_each(rbp, i, the_lnet.ln_rtrpools) {
 			s += snprintf(s, tmpstr + tmpsiz - s,
-				      "%5d %5d %7d %7d\n",
+				      "%5d %5d %7d %7d %9"LPF64"u\n",
 				      rbp[idx].rbp_npages,
 				      rbp[idx].rbp_nbuffers,
 				      rbp[idx].rbp_credits,
-				      rbp[idx].rbp_mincredits);
+				      rbp[idx].rbp_mincredits,
+				      rbp[idx].rbp_nwaits);
 			LASSERT(tmpstr + tmpsiz - s > 0);
 		}
 		lnet_net_unlock(LNET_LOCK_EX);
@@ -761,6 +767,150 @@ int LL_PROC_PROTO(proc_lnet_nis)
         return rc;
 }
 
+static int __proc_lnet_ni_stats(void *data, int write,
+				loff_t pos, void *buffer, int nob)
+{
+	struct lnet_ni_stats	*stats;
+	struct lnet_ni_stats	sum;
+	cfs_list_t		*tmp;
+	lnet_ni_t		*ni;
+	char			*tmpstr;
+	char			*s;
+	int			tmpsiz;
+	int			nnis = 0;
+	int			rc;
+	int			i;
+
+	/* NIs don't change while /proc/sys/lnet is registered */
+	cfs_list_for_each(tmp, &the_lnet.ln_nis)
+		nnis++;
+
+	if (write) {
+		cfs_list_for_each(tmp, &the_lnet.ln_nis) {
+			ni = cfs_list_entry(tmp, lnet_ni_t, ni_list);
+			cfs_percpt_for_each(stats, i, ni->ni_stats) {
+				lnet_net_lock(i);
+				memset(stats, 0, sizeof(*stats));
+				lnet_net_unlock(i);
+			}
+		}
+		return 0;
+	}
+
+	tmpsiz = 128 * (nnis + 1);
+	LIBCFS_ALLOC(tmpstr, tmpsiz);
+	if (tmpstr == NULL)
+		return -ENOMEM;
+
+	s = tmpstr;
+	s += snprintf(s, tmpstr + tmpsiz - s,
+		      "%-24s %6s %12s %16s %12s %16s %8s\n",
+		      "nid", "health", "send_count", "send_length",
+		      "recv_count", "recv_length", "errors");
+
+	cfs_list_for_each(tmp, &the_lnet.ln_nis) {
+		ni = cfs_list_entry(tmp, lnet_ni_t, ni_list);
+
+		memset(&sum, 0, sizeof(sum));
+		cfs_percpt_for_each(stats, i, ni->ni_stats) {
+			lnet_net_lock(i);
+			sum.nis_send_count  += stats->nis_send_count;
+			sum.nis_send_length += stats->nis_send_length;
+			sum.nis_recv_count  += stats->nis_recv_count;
+			sum.nis_recv_length += stats->nis_recv_length;
+			sum.nis_errors	    += stats->nis_errors;
+			lnet_net_unlock(i);
+		}
+
+		s += snprintf(s, tmpstr + tmpsiz - s,
+			      "%-24s %6d %12"LPF64"u %16"LPF64"u %12"LPF64"u "
+			      "%16"LPF64"u %8"LPF64"u\n",
+			      libcfs_nid2str(ni->ni_nid),
+			      lnet_health_value(&ni->ni_health),
+			      sum.nis_send_count, sum.nis_send_length,
+			      sum.nis_recv_count, sum.nis_recv_length,
+			      sum.nis_errors);
+	}
+	LASSERT(tmpstr + tmpsiz - s > 0);
+
+	if (pos >= s - tmpstr)
+		rc = 0;
+	else
+		rc = cfs_trace_copyout_string(buffer, nob, tmpstr + pos, NULL);
+
+	LIBCFS_FREE(tmpstr, tmpsiz);
+	return rc;
+}
+
+DECLARE_PROC_HANDLER(proc_lnet_ni_stats);
+
+static int __proc_lnet_rails(void *data, int write,
+			     loff_t pos, void *buffer, int nob)
+{
+	struct lnet_rail_set	*set;
+	struct lnet_peer_rail	*rail;
+	cfs_list_t		*tmp;
+	char			*tmpstr;
+	char			*s;
+	int			tmpsiz;
+	int			nrails = 0;
+	int			rc;
+	int			i;
+
+	LASSERT(!write);
+
+	/* rail sets don't change while /proc/sys/lnet is registered */
+	cfs_list_for_each(tmp, &the_lnet.ln_rail_sets) {
+		set = cfs_list_entry(tmp, struct lnet_rail_set, rs_list);
+		nrails += set->rs_nrails;
+	}
+
+	tmpsiz = 160 * (nrails + 1);
+	LIBCFS_ALLOC(tmpstr, tmpsiz);
+	if (tmpstr == NULL)
+		return -ENOMEM;
+
+	s = tmpstr;
+	s += snprintf(s, tmpstr + tmpsiz - s,
+		      "%-24s %-24s %-24s %6s %8s %10s %12s %16s %8s\n",
+		      "peer", "rail", "local", "health", "inflight", "inflt_nob",
+		      "send_count", "send_length", "errors");
+
+	cfs_list_for_each(tmp, &the_lnet.ln_rail_sets) {
+		set = cfs_list_entry(tmp, struct lnet_rail_set, rs_list);
+
+		for (i = 0; i < set->rs_nrails; i++) {
+			rail = &set->rs_rails[i];
+
+			s += snprintf(s, tmpstr + tmpsiz - s,
+				      "%-24s %-24s %-24s %6d %8d %10u "
+				      "%12"LPF64"u %16"LPF64"u %8"LPF64"u\n",
+				      libcfs_nid2str(set->rs_rails[0].pr_nid),
+				      libcfs_nid2str(rail->pr_nid),
+				      set->rs_self ? "self" :
+				      rail->pr_ni == NULL ? "-" :
+				      libcfs_nid2str(rail->pr_ni_nid),
+				      lnet_health_value(&rail->pr_health),
+				      rail->pr_inflight,
+				      rail->pr_inflight_nob,
+				      rail->pr_send_count,
+				      rail->pr_send_length,
+				      rail->pr_errors);
+		}
+	}
+	LASSERT(tmpstr + tmpsiz - s > 0);
+
+	if (pos >= s - tmpstr)
+		rc = 0;
+	else
+		rc = cfs_trace_copyout_string(buffer, nob, tmpstr + pos, NULL);
+
+	LIBCFS_FREE(tmpstr, tmpsiz);
+	return rc;
+}
+
+DECLARE_PROC_HANDLER(proc_lnet_rails);
+
 struct lnet_portal_rotors {
 	int             pr_value;
 	const char      *pr_name;
@@ -909,6 +1059,18 @@ static struct ctl_table lnet_table[] = {
 		.mode     = 0644,
 		.proc_handler = &proc_lnet_portal_rotor,
 	},
+	{
+		INIT_CTL_NAME(PSDEV_LNET_NI_STATS)
+		.procname = "ni_stats",
+		.mode     = 0644,
+		.proc_handler = &proc_lnet_ni_stats,
+	},
+	{
+		INIT_CTL_NAME(PSDEV_LNET_RAILS)
+		.procname = "rails",
+		.mode     = 0444,
+		.proc_handler = &proc_lnet_rails,
+	},
 	{
 		INIT_CTL_NAME(0)
 	}
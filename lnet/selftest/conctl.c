@@ -687,6 +687,7 @@ lst_stat_query_ioctl(lstio_stat_args_t *args)
 		rc = lstcon_nodes_stat(args->lstio_sta_count,
                                        args->lstio_sta_idsp,
                                        args->lstio_sta_timeout,
+				       args->lstio_sta_lat,
                                        args->lstio_sta_resultp);
 	} else if (args->lstio_sta_namep != NULL) {
 		if (args->lstio_sta_nmlen <= 0 ||
@@ -701,6 +702,7 @@ lst_stat_query_ioctl(lstio_stat_args_t *args)
 				    args->lstio_sta_nmlen);
 		if (rc == 0)
 			rc = lstcon_group_stat(name, args->lstio_sta_timeout,
+					       args->lstio_sta_lat,
 					       args->lstio_sta_resultp);
 		else
 			rc = -EFAULT;
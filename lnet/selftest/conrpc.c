@@ -694,12 +694,16 @@ lstcon_batrpc_prep(lstcon_node_t *nd, int transop, unsigned feats,
 }
 
 int
-lstcon_statrpc_prep(lstcon_node_t *nd, unsigned feats, lstcon_rpc_t **crpc)
+lstcon_statrpc_prep(lstcon_node_t *nd, unsigned feats, int lat,
+		    lstcon_rpc_t **crpc)
 {
 	srpc_stat_reqst_t *srq;
 	int		   rc;
 
-	rc = lstcon_rpc_prep(nd, SRPC_SERVICE_QUERY_STAT, feats, 0, 0, crpc);
+	/* latency query has the same request as stat query */
+	rc = lstcon_rpc_prep(nd, lat ? SRPC_SERVICE_QUERY_LAT :
+				       SRPC_SERVICE_QUERY_STAT,
+			     feats, 0, 0, crpc);
         if (rc != 0)
                 return rc;
 
@@ -1152,7 +1156,7 @@ lstcon_rpc_trans_ndlist(cfs_list_t *ndlist,
 						(lstcon_tsb_hdr_t *)arg, &rpc);
 			break;
 		case LST_TRANS_STATQRY:
-			rc = lstcon_statrpc_prep(nd, feats, &rpc);
+			rc = lstcon_statrpc_prep(nd, feats, *(int *)arg, &rpc);
                         break;
                 default:
                         rc = -EINVAL;
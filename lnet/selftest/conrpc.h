@@ -120,7 +120,7 @@ int  lstcon_batrpc_prep(struct lstcon_node *nd, int transop, unsigned version,
 int  lstcon_testrpc_prep(struct lstcon_node *nd, int transop, unsigned version,
                          struct lstcon_test *test, lstcon_rpc_t **crpc);
 int  lstcon_statrpc_prep(struct lstcon_node *nd, unsigned version,
-			 lstcon_rpc_t **crpc);
+			 int lat, lstcon_rpc_t **crpc);
 void lstcon_rpc_put(lstcon_rpc_t *crpc);
 int  lstcon_rpc_trans_prep(cfs_list_t *translist,
                            int transop, lstcon_rpc_trans_t **transpp);
@@ -1513,18 +1513,39 @@ lstcon_statrpc_readent(int transop, srpc_msg_t *msg,
         return 0;
 }
 
+int
+lstcon_latrpc_readent(int transop, srpc_msg_t *msg,
+		      lstcon_rpc_ent_t *ent_up)
+{
+	srpc_lat_reply_t *rep = &msg->msg_body.lat_reply;
+
+	if (rep->lat_status != 0)
+		return 0;
+
+	if (copy_to_user(&ent_up->rpe_payload[0], &rep->lat_counters,
+			 sizeof(rep->lat_counters)))
+		return -EFAULT;
+
+	return 0;
+}
+
 int
 lstcon_ndlist_stat(cfs_list_t *ndlist,
-                   int timeout, cfs_list_t *result_up)
+                   int timeout, int lat, cfs_list_t *result_up)
 {
         cfs_list_t          head;
         lstcon_rpc_trans_t *trans;
         int                 rc;
 
+	if (lat && (console_session.ses_features & LST_FEAT_LAT_HIST) == 0) {
+		CNETERR("Session doesn't have latency histograms\n");
+		return -EPROTO;
+	}
+
         CFS_INIT_LIST_HEAD(&head);
 
         rc = lstcon_rpc_trans_ndlist(ndlist, &head,
-                                     LST_TRANS_STATQRY, NULL, NULL, &trans);
+                                     LST_TRANS_STATQRY, &lat, NULL, &trans);
         if (rc != 0) {
                 CERROR("Can't create transaction: %d\n", rc);
                 return rc;
@@ -1533,14 +1554,15 @@ lstcon_ndlist_stat(cfs_list_t *ndlist,
         lstcon_rpc_trans_postwait(trans, LST_VALIDATE_TIMEOUT(timeout));
 
         rc = lstcon_rpc_trans_interpreter(trans, result_up,
-                                          lstcon_statrpc_readent);
+					  lat ? lstcon_latrpc_readent :
+						lstcon_statrpc_readent);
         lstcon_rpc_trans_destroy(trans);
 
         return rc;
 }
 
 int
-lstcon_group_stat(char *grp_name, int timeout, cfs_list_t *result_up)
+lstcon_group_stat(char *grp_name, int timeout, int lat, cfs_list_t *result_up)
 {
         lstcon_group_t     *grp;
         int                 rc;
@@ -1551,7 +1573,7 @@ lstcon_group_stat(char *grp_name, int timeout, cfs_list_t *result_up)
                 return rc;
         }
 
-        rc = lstcon_ndlist_stat(&grp->grp_ndl_list, timeout, result_up);
+	rc = lstcon_ndlist_stat(&grp->grp_ndl_list, timeout, lat, result_up);
 
         lstcon_group_put(grp);
 
@@ -1560,7 +1582,7 @@ lstcon_group_stat(char *grp_name, int timeout, cfs_list_t *result_up)
 
 int
 lstcon_nodes_stat(int count, lnet_process_id_t *ids_up,
-                  int timeout, cfs_list_t *result_up)
+		  int timeout, int lat, cfs_list_t *result_up)
 {
         lstcon_ndlink_t         *ndl;
         lstcon_group_t          *tmp;
@@ -1595,7 +1617,7 @@ lstcon_nodes_stat(int count, lnet_process_id_t *ids_up,
                 return rc;
         }
 
-        rc = lstcon_ndlist_stat(&tmp->grp_ndl_list, timeout, result_up);
+	rc = lstcon_ndlist_stat(&tmp->grp_ndl_list, timeout, lat, result_up);
 
         lstcon_group_put(tmp);
 
@@ -221,10 +221,10 @@ extern int lstcon_batch_list(int idx, int namelen, char *name_up);
 extern int lstcon_batch_info(char *name, lstcon_test_batch_ent_t *ent_up,
                              int server, int testidx, int *index_p,
                              int *ndent_p, lstcon_node_ent_t *dents_up);
-extern int lstcon_group_stat(char *grp_name, int timeout,
+extern int lstcon_group_stat(char *grp_name, int timeout, int lat,
                              cfs_list_t *result_up);
 extern int lstcon_nodes_stat(int count, lnet_process_id_t *ids_up,
-                             int timeout, cfs_list_t *result_up);
+                             int timeout, int lat, cfs_list_t *result_up);
 extern int lstcon_test_add(char *batch_name, int type, int loop,
 			   int concur, int dist, int span,
 			   char *src_name, char *dst_name,
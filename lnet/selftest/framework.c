@@ -287,6 +287,7 @@ sfw_init_session(sfw_session_t *sn, lst_sid_t sid,
         cfs_atomic_set(&sn->sn_refcount, 1);        /* +1 for caller */
         cfs_atomic_set(&sn->sn_brw_errors, 0);
         cfs_atomic_set(&sn->sn_ping_errors, 0);
+	spin_lock_init(&sn->sn_lat_lock);
 	strlcpy(&sn->sn_name[0], name, sizeof(sn->sn_name));
 
         sn->sn_timer_active = 0;
@@ -432,6 +433,52 @@ sfw_get_stats (srpc_stat_reqst_t *request, srpc_stat_reply_t *reply)
         return 0;
 }
 
+int
+sfw_get_latency(srpc_stat_reqst_t *request, srpc_lat_reply_t *reply)
+{
+	sfw_session_t *sn = sfw_data.fw_session;
+
+	reply->lat_sid = (sn == NULL) ? LST_INVALID_SID : sn->sn_id;
+
+	if (request->str_sid.ses_nid == LNET_NID_ANY) {
+		reply->lat_status = EINVAL;
+		return 0;
+	}
+
+	if (sn == NULL || !sfw_sid_equal(request->str_sid, sn->sn_id)) {
+		reply->lat_status = ESRCH;
+		return 0;
+	}
+
+	spin_lock(&sn->sn_lat_lock);
+	reply->lat_counters = sn->sn_lat;
+	spin_unlock(&sn->sn_lat_lock);
+
+	reply->lat_status = 0;
+	return 0;
+}
+
+static void
+sfw_account_latency(sfw_session_t *sn, srpc_client_rpc_t *rpc)
+{
+	struct timeval	now;
+	long		usecs;
+	int		i = 0;
+
+	do_gettimeofday(&now);
+	usecs = cfs_timeval_sub(&now, &rpc->crpc_stamp, NULL);
+	if (usecs < 0) /* clock stepped back */
+		return;
+
+	while (i < LST_LAT_NBUCKETS - 1 && (usecs >> (i + 1)) != 0)
+		i++;
+
+	spin_lock(&sn->sn_lat_lock);
+	sn->sn_lat.lat_buckets[i]++;
+	sn->sn_lat.lat_total_us += usecs;
+	spin_unlock(&sn->sn_lat_lock);
+}
+
 int
 sfw_make_session(srpc_mksn_reqst_t *request, srpc_mksn_reply_t *reply)
 {
@@ -903,6 +950,11 @@ sfw_test_rpc_done (srpc_client_rpc_t *rpc)
         sfw_test_instance_t *tsi = tsu->tsu_instance;
         int                  done = 0;
 
+	if (rpc->crpc_status == 0 &&
+	    (tsi->tsi_batch->bat_session->sn_features &
+	     LST_FEAT_LAT_HIST) != 0)
+		sfw_account_latency(tsi->tsi_batch->bat_session, rpc);
+
         tsi->tsi_ops->tso_done_rpc(tsu, rpc);
 
 	spin_lock(&tsi->tsi_lock);
@@ -1007,6 +1059,7 @@ sfw_run_test (swi_workitem_t *wi)
 
 	spin_lock(&rpc->crpc_lock);
 	rpc->crpc_timeout = rpc_timeout;
+	do_gettimeofday(&rpc->crpc_stamp);
 	srpc_post_rpc(rpc);
 	spin_unlock(&rpc->crpc_lock);
 	return 0;
@@ -1338,6 +1391,11 @@ sfw_handle_server_rpc(struct srpc_server_rpc *rpc)
                                    &reply->msg_body.stat_reply);
                 break;
 
+	case SRPC_SERVICE_QUERY_LAT:
+		rc = sfw_get_latency(&request->msg_body.lat_reqst,
+				     &reply->msg_body.lat_reply);
+		break;
+
         case SRPC_SERVICE_DEBUG:
                 rc = sfw_debug_session(&request->msg_body.dbg_reqst,
                                        &reply->msg_body.dbg_reply);
@@ -1493,6 +1551,27 @@ sfw_unpack_message (srpc_msg_t *msg)
                 return;
         }
 
+	if (msg->msg_type == SRPC_MSG_LAT_REQST) {
+		srpc_stat_reqst_t *req = &msg->msg_body.lat_reqst;
+
+		__swab32s(&req->str_type);
+		__swab64s(&req->str_rpyid);
+		sfw_unpack_sid(req->str_sid);
+		return;
+	}
+
+	if (msg->msg_type == SRPC_MSG_LAT_REPLY) {
+		srpc_lat_reply_t *rep = &msg->msg_body.lat_reply;
+		int		  i;
+
+		__swab32s(&rep->lat_status);
+		sfw_unpack_sid(rep->lat_sid);
+		__swab64s(&rep->lat_counters.lat_total_us);
+		for (i = 0; i < LST_LAT_NBUCKETS; i++)
+			__swab32s(&rep->lat_counters.lat_buckets[i]);
+		return;
+	}
+
         if (msg->msg_type == SRPC_MSG_MKSN_REQST) {
                 srpc_mksn_reqst_t *req = &msg->msg_body.mksn_reqst;
 
@@ -1649,6 +1728,11 @@ static srpc_service_t sfw_services[] =
                 /* sv_name */  "query stats",
                 0
         },
+	{
+		/* sv_id */    SRPC_SERVICE_QUERY_LAT,
+		/* sv_name */  "query latency",
+		0
+	},
         {
                 /* sv_id */    SRPC_SERVICE_MAKE_SESSION,
                 /* sv_name */  "make session",
@@ -90,6 +90,7 @@ struct sfw_test_instance;
 #define SRPC_SERVICE_TEST               4
 #define SRPC_SERVICE_QUERY_STAT         5
 #define SRPC_SERVICE_JOIN               6
+#define SRPC_SERVICE_QUERY_LAT          7
 #define SRPC_FRAMEWORK_SERVICE_MAX_ID   10
 /* other services start from SRPC_FRAMEWORK_SERVICE_MAX_ID+1 */
 #define SRPC_SERVICE_BRW                11
@@ -134,6 +135,9 @@ srpc_service2request (int service)
 
         case SRPC_SERVICE_JOIN:
                 return SRPC_MSG_JOIN_REQST;
+
+	case SRPC_SERVICE_QUERY_LAT:
+		return SRPC_MSG_LAT_REQST;
         }
 }
 
@@ -241,6 +245,7 @@ typedef struct srpc_client_rpc {
         /* bulk, request(reqst), and reply exchanged on wire */
         srpc_msg_t           crpc_reqstmsg;
         srpc_msg_t           crpc_replymsg;
+	struct timeval	     crpc_stamp;     /* posted at, for latency */
         lnet_handle_md_t     crpc_reqstmdh;
         lnet_handle_md_t     crpc_replymdh;
         srpc_bulk_t          crpc_bulk;
@@ -348,6 +353,8 @@ typedef struct {
         cfs_atomic_t      sn_brw_errors;
         cfs_atomic_t      sn_ping_errors;
         cfs_time_t        sn_started;
+	spinlock_t	  sn_lat_lock;	/* serialise sn_lat */
+	sfw_lat_counters_t sn_lat;	/* latency of my test RPCs */
 } sfw_session_t;
 
 #define sfw_sid_equal(sid0, sid1)     ((sid0).ses_nid == (sid1).ses_nid && \
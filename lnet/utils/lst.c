@@ -1491,12 +1491,13 @@ jt_lst_list_group(int argc, char **argv)
 
 int
 lst_stat_ioctl (char *name, int count, lnet_process_id_t *idsp,
-                int timeout, cfs_list_t *resultp)
+		int timeout, int lat, cfs_list_t *resultp)
 {
         lstio_stat_args_t args = {0};
 
         args.lstio_sta_key     = session_key;
         args.lstio_sta_timeout = timeout;
+	args.lstio_sta_lat     = lat;
         args.lstio_sta_nmlen   = strlen(name);
         args.lstio_sta_namep   = name;
         args.lstio_sta_count   = count;
@@ -1533,6 +1534,7 @@ lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
 {
         lst_stat_req_param_t *srp = NULL;
         int                   count = save_old ? 2 : 1;
+	int		      size;
         int                   rc;
         int                   i;
 
@@ -1562,11 +1564,15 @@ lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
 
         srp->srp_name = name;
 
+	/* big enough for either counters or latency histograms */
+	size = sizeof(sfw_counters_t) + sizeof(srpc_counters_t) +
+	       sizeof(lnet_counters_t);
+	if (size < sizeof(sfw_lat_counters_t))
+		size = sizeof(sfw_lat_counters_t);
+
         for (i = 0; i < count; i++) {
                 rc = lst_alloc_rpcent(&srp->srp_result[i], srp->srp_count,
-                                      sizeof(sfw_counters_t)  +
-                                      sizeof(srpc_counters_t) +
-                                      sizeof(lnet_counters_t));
+				      size);
                 if (rc != 0) {
                         fprintf(stderr, "Out of memory\n");
                         break;
@@ -1713,6 +1719,24 @@ lst_cal_lnet_stat(float delta, lnet_counters_t *lnet_new,
 
 }
 
+static void
+lst_print_lnet_stat_csv(char *name)
+{
+	int	i;
+
+	/* lnet,GROUP,R|W,avg/min/max RPC/s,avg/min/max MB/s */
+	for (i = 0; i <= 1; i++) {
+		fprintf(stdout, "lnet,%s,%c,%.0f,%.0f,%.0f,%.2f,%.2f,%.2f\n",
+			name, i == 0 ? 'R' : 'W',
+			lst_lnet_stat_value(0, i, 0),
+			lst_lnet_stat_value(0, i, 1),
+			lst_lnet_stat_value(0, i, 2),
+			lst_lnet_stat_value(1, i, 0),
+			lst_lnet_stat_value(1, i, 1),
+			lst_lnet_stat_value(1, i, 2));
+	}
+}
+
 void
 lst_print_lnet_stat(char *name, int bwrt, int rdwr, int type)
 {
@@ -1768,9 +1792,163 @@ lst_print_lnet_stat(char *name, int bwrt, int rdwr, int type)
         }
 }
 
+/* usecs of the @pct percentile of @count RPCs in log2 @buckets, linear
+ * within the bucket it falls in */
+static float
+lst_lat_percentile(__u32 *buckets, __u64 count, float pct)
+{
+	/* pct in 1/1000 %, so e.g. 99.9 isn't off by the float error */
+	__u64	pct_m = (__u64)(pct * 1000 + 0.5);
+	__u64	target;
+	__u64	sum = 0;
+	float	lo;
+	int	i;
+
+	/* nearest rank: the smallest one covering pct% of the samples */
+	target = (count * pct_m + 100000 - 1) / 100000;
+	if (target == 0)
+		target = 1;
+
+	for (i = 0; i < LST_LAT_NBUCKETS; i++) {
+		if (sum + buckets[i] < target) {
+			sum += buckets[i];
+			continue;
+		}
+
+		lo = i == 0 ? 0 : (float)(1ULL << i);
+		if (i == LST_LAT_NBUCKETS - 1) /* open-ended */
+			return lo;
+
+		return lo + ((float)(1ULL << (i + 1)) - lo) *
+			    (target - sum) / buckets[i];
+	}
+
+	return 0;
+}
+
+static void
+lst_print_lat_line(char *name, char *node, __u32 *buckets,
+		   __u64 total_us, int csv)
+{
+	__u64	count = 0;
+	int	i;
+
+	for (i = 0; i < LST_LAT_NBUCKETS; i++)
+		count += buckets[i];
+
+	if (csv) {
+		fprintf(stdout, "lat,%s,%s,"LPU64",%.0f,%.0f,%.0f,%.0f",
+			name, node, count,
+			count == 0 ? 0 : (float)total_us / count,
+			lst_lat_percentile(buckets, count, 50),
+			lst_lat_percentile(buckets, count, 99),
+			lst_lat_percentile(buckets, count, 99.9));
+		for (i = 0; i < LST_LAT_NBUCKETS; i++)
+			fprintf(stdout, ",%u", buckets[i]);
+		fprintf(stdout, "\n");
+		return;
+	}
+
+	if (count == 0) {
+		fprintf(stdout, "%s: no RPC completed\n", node);
+		return;
+	}
+
+	fprintf(stdout, "%s: RPCs: "LPU64" Avg: %.0f us p50: %.0f us "
+		"p99: %.0f us p99.9: %.0f us\n", node, count,
+		(float)total_us / count,
+		lst_lat_percentile(buckets, count, 50),
+		lst_lat_percentile(buckets, count, 99),
+		lst_lat_percentile(buckets, count, 99.9));
+}
+
+/* latency histograms of test RPCs sent by nodes of @name in the last
+ * interval, per node with @verbose or @csv, and of the whole group */
+void
+lst_print_lat(char *name, cfs_list_t *resultp, int idx, int verbose, int csv)
+{
+	cfs_list_t		tmp[2];
+	lstcon_rpc_ent_t	*new;
+	lstcon_rpc_ent_t	*old;
+	sfw_lat_counters_t	*lat_new;
+	sfw_lat_counters_t	*lat_old;
+	__u32			buckets[LST_LAT_NBUCKETS];
+	__u32			total[LST_LAT_NBUCKETS];
+	__u64			total_us = 0;
+	int			errcount = 0;
+	int			nnodes = 0;
+	int			i;
+
+	CFS_INIT_LIST_HEAD(&tmp[0]);
+	CFS_INIT_LIST_HEAD(&tmp[1]);
+	memset(total, 0, sizeof(total));
+
+	while (!cfs_list_empty(&resultp[idx])) {
+		if (cfs_list_empty(&resultp[1 - idx])) {
+			fprintf(stderr, "Group is changed, re-run stat\n");
+			break;
+		}
+
+		new = cfs_list_entry(resultp[idx].next, lstcon_rpc_ent_t,
+				     rpe_link);
+		old = cfs_list_entry(resultp[1 - idx].next, lstcon_rpc_ent_t,
+				     rpe_link);
+
+		/* first time get stats result, can't calculate diff */
+		if (new->rpe_peer.nid == LNET_NID_ANY)
+			break;
+
+		if (new->rpe_peer.nid != old->rpe_peer.nid ||
+		    new->rpe_peer.pid != old->rpe_peer.pid)
+			break;
+
+		cfs_list_del(&new->rpe_link);
+		cfs_list_add_tail(&new->rpe_link, &tmp[idx]);
+
+		cfs_list_del(&old->rpe_link);
+		cfs_list_add_tail(&old->rpe_link, &tmp[1 - idx]);
+
+		if (new->rpe_rpc_errno != 0 || new->rpe_fwk_errno != 0 ||
+		    old->rpe_rpc_errno != 0 || old->rpe_fwk_errno != 0) {
+			errcount++;
+			continue;
+		}
+
+		lat_new = (sfw_lat_counters_t *)&new->rpe_payload[0];
+		lat_old = (sfw_lat_counters_t *)&old->rpe_payload[0];
+
+		for (i = 0; i < LST_LAT_NBUCKETS; i++) {
+			buckets[i] = lat_new->lat_buckets[i] -
+				     lat_old->lat_buckets[i];
+			total[i] += buckets[i];
+		}
+		total_us += lat_new->lat_total_us - lat_old->lat_total_us;
+		nnodes++;
+
+		if (verbose || csv)
+			lst_print_lat_line(name,
+					   libcfs_id2str(new->rpe_peer),
+					   buckets, lat_new->lat_total_us -
+					   lat_old->lat_total_us, csv);
+	}
+
+	cfs_list_splice(&tmp[idx], &resultp[idx]);
+	cfs_list_splice(&tmp[1 - idx], &resultp[1 - idx]);
+
+	if (errcount > 0)
+		fprintf(stdout, "Failed to stat on %d nodes\n", errcount);
+
+	if (nnodes == 0)
+		return;
+
+	if (!csv)
+		fprintf(stdout, "[Latency of %s]\n", name);
+	lst_print_lat_line(name, "total", total, total_us, csv);
+}
+
 void
 lst_print_stat(char *name, cfs_list_t *resultp,
-	       int idx, int lnet, int bwrt, int rdwr, int type)
+	       int idx, int lnet, int bwrt, int rdwr, int type, int csv)
 {
         cfs_list_t        tmp[2];
         lstcon_rpc_ent_t *new;
@@ -1867,6 +2045,12 @@ lst_print_stat(char *name, cfs_list_t *resultp,
         if (!lnet)  /* TODO */
                 return;
 
+	if (csv) {
+		if (lnet_stat_result.lnet_stat_count != 0)
+			lst_print_lnet_stat_csv(name);
+		return;
+	}
+
         lst_print_lnet_stat(name, bwrt, rdwr, type);
 }
 
@@ -1884,6 +2068,9 @@ jt_lst_stat(int argc, char **argv)
         int                   bwrt    = 0;
         int                   rdwr    = 0;
         int                   type    = -1;
+	int		      lat     = 0;
+	int		      verbose = 0;
+	int		      csv     = 0;
         int                   idx     = 0;
         int                   rc;
         int                   c;
@@ -1902,6 +2089,9 @@ jt_lst_stat(int argc, char **argv)
 		{"avg"	     , no_argument,	 0, 'g' },
 		{"min"	     , no_argument,	 0, 'n' },
 		{"max"	     , no_argument,	 0, 'x' },
+		{"lat"	     , no_argument,	 0, 'L' },
+		{"verbose"   , no_argument,	 0, 'v' },
+		{"csv"	     , no_argument,	 0, 'C' },
 		{0,	       0,		 0,  0  }
         };
 
@@ -1912,7 +2102,8 @@ jt_lst_stat(int argc, char **argv)
         }
 
         while (1) {
-		c = getopt_long(argc, argv, "t:d:lcbarwgnx", stat_opts, &optidx);
+		c = getopt_long(argc, argv, "t:d:lcbarwgnxLvC",
+				stat_opts, &optidx);
 
                 if (c == -1)
                         break;
@@ -1966,6 +2157,15 @@ jt_lst_stat(int argc, char **argv)
                         }
                         type |= 4;
                         break;
+		case 'L':
+			lat = 1;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		case 'C':
+			csv = 1;
+			break;
 
                 default:
                         lst_print_usage(argv[0]);
@@ -1992,6 +2192,14 @@ jt_lst_stat(int argc, char **argv)
         if (count != -1)
             count++;
 
+	if (csv && lat) {
+		fprintf(stdout, "lat,GROUP,NODE,RPCS,AVG_US,P50_US,P99_US,"
+			"P999_US,BUCKET_0..%d\n", LST_LAT_NBUCKETS - 1);
+	} else if (csv) {
+		fprintf(stdout, "lnet,GROUP,R|W,AVG_RPC/S,MIN_RPC/S,MAX_RPC/S,"
+			"AVG_MB/S,MIN_MB/S,MAX_MB/S\n");
+	}
+
         CFS_INIT_LIST_HEAD(&head);
 
         while (optind < argc) {
@@ -2016,15 +2224,21 @@ jt_lst_stat(int argc, char **argv)
                                               srp_link) {
                         rc = lst_stat_ioctl(srp->srp_name,
                                             srp->srp_count, srp->srp_ids,
-                                            timeout, &srp->srp_result[idx]);
+					    timeout, lat,
+					    &srp->srp_result[idx]);
                         if (rc == -1) {
                                 lst_print_error("stat", "Failed to stat %s: %s\n",
                                                 srp->srp_name, strerror(errno));
                                 goto out;
                         }
 
-			lst_print_stat(srp->srp_name, srp->srp_result,
-				       idx, lnet, bwrt, rdwr, type);
+			if (lat)
+				lst_print_lat(srp->srp_name, srp->srp_result,
+					      idx, verbose, csv);
+			else
+				lst_print_stat(srp->srp_name, srp->srp_result,
+					       idx, lnet, bwrt, rdwr, type,
+					       csv);
 
                         lst_reset_rpcent(&srp->srp_result[1 - idx]);
                 }
@@ -2107,7 +2321,7 @@ jt_lst_show_error(int argc, char **argv)
         cfs_list_for_each_entry_typed(srp, &head, lst_stat_req_param_t,
                                       srp_link) {
                 rc = lst_stat_ioctl(srp->srp_name, srp->srp_count,
-                                    srp->srp_ids, 10, &srp->srp_result[0]);
+				    srp->srp_ids, 10, 0, &srp->srp_result[0]);
 
                 if (rc == -1) {
                         lst_print_error(srp->srp_name, "Failed to show errors of %s: %s\n",
@@ -3249,7 +3463,8 @@ static command_t lst_cmdlist[] = {
           "Usage: lst list_group [--active] [--busy] [--down] [--unknown] GROUP ..."    },
 	{"stat",                jt_lst_stat,            NULL,
 	 "Usage: lst stat [--bw] [--rate] [--read] [--write] [--max] [--min] [--avg] "
-	 " [--timeout #] [--delay #] [--count #] GROUP [GROUP]"                         },
+	 " [--lat [--verbose]] [--csv] [--timeout #] [--delay #] [--count #]"
+	 " GROUP [GROUP]"								},
         {"show_error",          jt_lst_show_error,      NULL,
          "Usage: lst show_error NAME | IDS ..."                                         },
         {"add_batch",           jt_lst_add_batch,       NULL,
@@ -674,6 +674,10 @@ extern int lprocfs_rd_pinger_recov(char *page, char **start, off_t off,
                                    int count, int *eof, void *data);
 extern int lprocfs_wr_pinger_recov(struct file *file, const char *buffer,
                                    unsigned long count, void *data);
+extern int lprocfs_rd_idle_timeout(char *page, char **start, off_t off,
+				   int count, int *eof, void *data);
+extern int lprocfs_wr_idle_timeout(struct file *file, const char *buffer,
+				   unsigned long count, void *data);
 
 /* Statfs helpers */
 extern int lprocfs_rd_blksize(char *page, char **start, off_t off,
@@ -1023,6 +1027,12 @@ static inline int lprocfs_wr_import(struct file *file, const char *buffer,
 static inline int lprocfs_wr_pinger_recov(struct file *file, const char *buffer,
                                     unsigned long count, void *data)
 { return 0; }
+static inline int lprocfs_rd_idle_timeout(char *page, char **start, off_t off,
+					  int count, int *eof, void *data)
+{ return 0; }
+static inline int lprocfs_wr_idle_timeout(struct file *file, const char *buffer,
+					  unsigned long count, void *data)
+{ return 0; }
 
 /* Statfs helpers */
 static inline
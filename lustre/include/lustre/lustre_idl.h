@@ -1299,6 +1299,10 @@ extern void lustre_swab_ptlrpc_body(struct ptlrpc_body *pb);
 #define OBD_CONNECT_PINGLESS	0x4000000000000ULL/* pings not required */
 #define OBD_CONNECT_FLOCK_DEAD	0x8000000000000ULL/* improved flock deadlock detection */
 #define OBD_CONNECT_DISP_STRIPE 0x10000000000000ULL/* create stripe disposition*/
+#define OBD_CONNECT_OPEN_BY_FID	0x20000000000000ULL/* reserved: open by fid */
+#define OBD_CONNECT_LFSCK	0x40000000000000ULL/* reserved: online LFSCK */
+#define OBD_CONNECT_AST_ALIVE	0x80000000000000ULL/* AST replies count as pings */
+#define OBD_CONNECT_FLAGS2	0x8000000000000000ULL/* ocd_connect_flags2 is valid */
 
 /* XXX README XXX:
  * Please DO NOT add flag values here before first ensuring that this same
@@ -1315,6 +1319,10 @@ extern void lustre_swab_ptlrpc_body(struct ptlrpc_body *pb);
  * 2.2 clients/servers is no longer needed.  LU-1252/LU-1644. */
 #define OBD_CONNECT_MNE_SWAB		 OBD_CONNECT_MDS_MDS
 
+/* ocd_connect_flags2, only valid with OBD_CONNECT_FLAGS2 set.  The same
+ * README as for ocd_connect_flags applies. */
+#define OBD_CONNECT2_BATCH_RPCS	0x8000000ULL /* compound MDS_BATCH RPCs */
+
 #define OCD_HAS_FLAG(ocd, flg)  \
         (!!((ocd)->ocd_connect_flags & OBD_CONNECT_##flg))
 
@@ -1343,8 +1351,11 @@ extern void lustre_swab_ptlrpc_body(struct ptlrpc_body *pb);
 				OBD_CONNECT_LVB_TYPE | OBD_CONNECT_LAYOUTLOCK |\
 				OBD_CONNECT_PINGLESS | OBD_CONNECT_MAX_EASIZE |\
 				OBD_CONNECT_FLOCK_DEAD | \
+				OBD_CONNECT_AST_ALIVE | OBD_CONNECT_FLAGS2 | \
 				OBD_CONNECT_DISP_STRIPE)
 
+#define MDT_CONNECT_SUPPORTED2	OBD_CONNECT2_BATCH_RPCS
+
 #define OST_CONNECT_SUPPORTED  (OBD_CONNECT_SRVLOCK | OBD_CONNECT_GRANT | \
                                 OBD_CONNECT_REQPORTAL | OBD_CONNECT_VERSION | \
                                 OBD_CONNECT_TRUNCLOCK | OBD_CONNECT_INDEX | \
@@ -1361,7 +1372,7 @@ extern void lustre_swab_ptlrpc_body(struct ptlrpc_body *pb);
 				OBD_CONNECT_JOBSTATS | \
 				OBD_CONNECT_LIGHTWEIGHT | OBD_CONNECT_LVB_TYPE|\
 				OBD_CONNECT_LAYOUTLOCK | OBD_CONNECT_FID | \
-				OBD_CONNECT_PINGLESS)
+				OBD_CONNECT_PINGLESS | OBD_CONNECT_AST_ALIVE)
 #define ECHO_CONNECT_SUPPORTED (0)
 #define MGS_CONNECT_SUPPORTED  (OBD_CONNECT_VERSION | OBD_CONNECT_AT | \
 				OBD_CONNECT_FULL20 | OBD_CONNECT_IMP_RECOV | \
@@ -1422,7 +1433,7 @@ struct obd_connect_data {
          * if the corresponding flag in ocd_connect_flags is set. Accessing
          * any field after ocd_maxbytes on the receiver without a valid flag
          * may result in out-of-bound memory access and kernel oops. */
-        __u64 padding1;          /* added 2.1.0. also fix lustre_swab_connect */
+	__u64 ocd_connect_flags2; /* OBD_CONNECT2_* per above */
         __u64 padding2;          /* added 2.1.0. also fix lustre_swab_connect */
         __u64 padding3;          /* added 2.1.0. also fix lustre_swab_connect */
         __u64 padding4;          /* added 2.1.0. also fix lustre_swab_connect */
@@ -2079,6 +2090,8 @@ typedef enum {
 	MDS_HSM_CT_REGISTER	= 59,
 	MDS_HSM_CT_UNREGISTER	= 60,
 	MDS_SWAP_LAYOUTS	= 61,
+	MDS_RMFID		= 62, /* reserved */
+	MDS_BATCH		= 63,
 	MDS_LAST_OPC
 } mds_cmd_t;
 
@@ -3739,6 +3752,35 @@ struct update_reply {
 void lustre_swab_update_buf(struct update_buf *ub);
 void lustre_swab_update_reply_buf(struct update_reply *ur);
 
+/**
+ * Compound request MDS_BATCH: independent MDS requests sent to one MDT in a
+ * single RPC and handled there by one service thread.
+ *
+ *   Batch request/reply buffer format
+ *   bb_magic:   BATCH_BUFFER_MAGIC_V1
+ *   bb_count:   How many sub-requests (replies) in the buffer.
+ *   bb_lens:    The lengths of each sub-request (reply) message, 0 if the
+ *		 sub-request got no reply.
+ *   messages:   1st lustre_msg, 8-byte aligned
+ *		 2nd lustre_msg, 8-byte aligned
+ *		 .....
+ *
+ * Every message is a complete lustre_msg as it would have been sent (or
+ * replied) on its own, so the usual packing and unpacking code applies to
+ * it unchanged.  The reply buffer has one slot per sub-request in the same
+ * order.
+ */
+#define BATCH_MAX_OPS		16
+#define BATCH_BUFFER_MAGIC_V1	0xBDDE0101
+#define BATCH_BUFFER_MAGIC	BATCH_BUFFER_MAGIC_V1
+struct batch_buf {
+	__u32	bb_magic;
+	__u32	bb_count;
+	__u32	bb_lens[0];
+};
+
+void lustre_swab_batch_buf(struct batch_buf *bb);
+
 /** layout swap request structure
  * fid1 and fid2 are in mdt_body
  */
@@ -76,6 +76,8 @@ struct obd_device;
 #define LDLM_DEFAULT_MAX_ALIVE (cfs_time_seconds(36000))
 #define LDLM_CTIME_AGE_LIMIT (10)
 #define LDLM_DEFAULT_PARALLEL_AST_LIMIT 1024
+#define LDLM_DEFAULT_CANCEL_BATCH 128
+#define LDLM_CANCEL_BATCH_AGE (cfs_time_seconds(1))
 
 /**
  * LDLM non-error return states
@@ -273,6 +275,30 @@ struct ldlm_pool {
 	int			pl_grant_plan;
 	/** Pool statistics. */
 	struct lprocfs_stats	*pl_stats;
+
+	/**
+	 * Server side SLV feedback controller, see ldlm_pool_recalc_slv().
+	 * Protected by pl_lock.
+	 * @{ */
+	/** Proportional, integral and derivative gains, in %. */
+	int			pl_slv_kp;
+	int			pl_slv_ki;
+	int			pl_slv_kd;
+	/** Target number of granted locks, in % of pl_limit. */
+	int			pl_slv_target;
+	/** Max SLV change per period, in 1/1024 of current SLV. */
+	int			pl_slv_max_step;
+	/** Target number of granted locks for last period. */
+	int			pl_slv_goal;
+	/** Last error, integral of error and output, in 1/1024 units. */
+	int			pl_slv_error;
+	int			pl_slv_integral;
+	int			pl_slv_output;
+	/** Locks requested by the shrinker during current period. */
+	int			pl_shrink_nr;
+	/** Smoothed memory pressure, in locks. */
+	int			pl_mem_pressure;
+	/** @} */
 };
 
 typedef int (*ldlm_res_policy)(struct ldlm_namespace *, struct ldlm_lock **,
@@ -428,6 +454,25 @@ struct ldlm_namespace {
 	unsigned int		ns_max_unused;
 	/** Maximum allowed age (last used time) for locks in the LRU */
 	unsigned int		ns_max_age;
+
+	/**
+	 * Client only: locks already cancelled locally whose CANCEL has not
+	 * been sent to the server yet, linked via l_bl_ast.
+	 * Protected by ns_lock. \see ldlm_cancel_batch_add
+	 */
+	cfs_list_t		ns_cancel_batch;
+	/** Number of locks in ns_cancel_batch */
+	unsigned int		ns_cancel_batch_nr;
+	/** Maximum number of locks kept in ns_cancel_batch, 0 disables it */
+	unsigned int		ns_cancel_batch_max;
+	/** Time the oldest lock in ns_cancel_batch was added */
+	cfs_time_t		ns_cancel_batch_time;
+
+	/**
+	 * MDT only: wait-for graph of blocked POSIX locks used for deadlock
+	 * detection, added with ldlm_lock::l_exp_flock_hash.
+	 */
+	cfs_hash_t		*ns_flock_wfg;
 	/**
 	 * Server only: number of times we evicted clients due to lack of reply
 	 * to ASTs.
@@ -618,6 +663,10 @@ typedef enum {
         LCF_LOCAL      = 0x2, /* Cancel locks locally, not notifing server */
         LCF_BL_AST     = 0x4, /* Cancel locks marked as LDLM_FL_BL_AST
                                * in the same RPC */
+	LCF_DEFER      = 0x8, /* Cancel locks locally, queue the CANCEL on
+			       * the namespace batch to be sent later */
+	LCF_DISCARD_DATA = 0x10, /* Drop cached pages under the locks
+				  * instead of writing them back */
 } ldlm_cancel_flags_t;
 
 struct ldlm_flock {
@@ -625,9 +674,8 @@ struct ldlm_flock {
         __u64 end;
         __u64 owner;
         __u64 blocking_owner;
-        struct obd_export *blocking_export;
-	/* Protected by the hash lock */
-	__u32 blocking_refs;
+	/* Server only, client NID of blocking_owner */
+	lnet_nid_t blocking_nid;
         __u32 pid;
 };
 
@@ -700,20 +748,11 @@ struct ldlm_lock {
 	 * Protected by lr_lock in struct ldlm_resource.
 	 */
 	cfs_list_t		l_res_link;
-	/**
-	 * Tree node for ldlm_extent.
-	 */
-	struct ldlm_interval	*l_tree_node;
 	/**
 	 * Per export hash of locks.
 	 * Protected by per-bucket exp->exp_lock_hash locks.
 	 */
 	cfs_hlist_node_t	l_exp_hash;
-	/**
-	 * Per export hash of flock locks.
-	 * Protected by per-bucket exp->exp_flock_hash locks.
-	 */
-	cfs_hlist_node_t	l_exp_flock_hash;
 	/**
 	 * Requested mode.
 	 * Protected by lr_lock.
@@ -799,9 +838,6 @@ struct ldlm_lock {
 	 */
 	cfs_time_t		l_last_used;
 
-	/** Originally requested extent for the extent lock. */
-	struct ldlm_extent	l_req_extent;
-
 	/*
 	 * Client-side-only members.
 	 */
@@ -873,9 +909,30 @@ struct ldlm_lock {
 	/**
 	 * Protected by lr_lock, linkages to "skip lists".
 	 * For more explanations of skip lists see ldlm/ldlm_inodebits.c
+	 * For extent locks this links the lock into li_group of its
+	 * interval tree node.
 	 */
-	cfs_list_t		l_sl_mode;
 	cfs_list_t		l_sl_policy;
+	/**
+	 * Members only used by one lock type, the resource type decides which
+	 * one is valid. See ldlm_lock_new().
+	 */
+	union {
+		/** PLAIN and IBITS locks, protected by lr_lock. */
+		cfs_list_t		l_sl_mode;
+		/** EXTENT locks. */
+		struct {
+			/** Tree node for ldlm_extent. */
+			struct ldlm_interval	*l_tree_node;
+			/** Originally requested extent for the extent lock. */
+			struct ldlm_extent	l_req_extent;
+		};
+		/**
+		 * FLOCK locks, node of the namespace wait-for graph.
+		 * Protected by per-bucket ns->ns_flock_wfg locks.
+		 */
+		cfs_hlist_node_t	l_exp_flock_hash;
+	};
 
 	/** Reference tracking structure to debug leaked locks. */
 	struct lu_ref		l_reference;
@@ -964,6 +1021,9 @@ struct ldlm_resource {
 	struct lu_ref		lr_reference;
 
 	struct inode		*lr_lvb_inode;
+
+	/** Resource is freed after a grace period, see ldlm_resource_get() */
+	cfs_rcu_head_t		lr_rcu;
 };
 
 static inline bool ldlm_has_layout(struct ldlm_lock *lock)
@@ -1445,6 +1505,9 @@ int ldlm_cli_cancel_list_local(cfs_list_t *cancels, int count,
                                ldlm_cancel_flags_t flags);
 int ldlm_cli_cancel_list(cfs_list_t *head, int count,
                          struct ptlrpc_request *req, ldlm_cancel_flags_t flags);
+void ldlm_cancel_batch_add(struct ldlm_namespace *ns, cfs_list_t *cancels,
+			   int count);
+int ldlm_cancel_batch_flush(struct ldlm_namespace *ns, int aged_only);
 /** @} ldlm_cli_api */
 
 /* mds/handler.c */
@@ -197,14 +197,11 @@ struct obd_export {
         __u32                     exp_conn_cnt;
         /** Hash list of all ldlm locks granted on this export */
         cfs_hash_t               *exp_lock_hash;
-        /**
-	 * Hash list for Posix lock deadlock detection, added with
-	 * ldlm_lock::l_exp_flock_hash.
-         */
-	cfs_hash_t               *exp_flock_hash;
         cfs_list_t                exp_outstanding_replies;
         cfs_list_t                exp_uncommitted_replies;
 	spinlock_t		  exp_uncommitted_replies_lock;
+	/** on a reply handling thread to release committed replies */
+	cfs_list_t		  exp_commit_list;
         /** Last committed transno for this export */
         __u64                     exp_last_committed;
         /** When was last request received */
@@ -277,6 +274,13 @@ static inline __u64 exp_connect_flags(struct obd_export *exp)
 	return *exp_connect_flags_ptr(exp);
 }
 
+static inline __u64 exp_connect_flags2(struct obd_export *exp)
+{
+	if (exp_connect_flags(exp) & OBD_CONNECT_FLAGS2)
+		return exp->exp_connect_data.ocd_connect_flags2;
+	return 0;
+}
+
 static inline int exp_max_brw_size(struct obd_export *exp)
 {
 	LASSERT(exp != NULL);
@@ -60,6 +60,24 @@
 #define AT_BINS 4                  /* "bin" means "N seconds of history" */
 #define AT_FLG_NOHIST 0x1          /* use last reported value only */
 
+/**
+ * Percentile estimator: measured values are counted in log-linear bins (exact
+ * below 8, then 4 bins per power of two up to AT_PCT_VAL_MAX) whose weights
+ * are halved every at_history / AT_BINS seconds.  The estimate is the upper
+ * bound of the bin where the ap_pct percentile falls, so a single slow
+ * request doesn't hold the timeout up for the whole history like the max of
+ * the bins does.
+ */
+#define AT_PCT_BINS	48
+#define AT_PCT_VAL_MAX	8192       /* larger values go to the last bin */
+#define AT_PCT_ONE	16         /* weight of one measured value */
+
+struct at_pct {
+	unsigned int	ap_pct;              /* percentile to estimate */
+	time_t		ap_decay_time;       /* last time weights were halved */
+	unsigned int	ap_weight[AT_PCT_BINS];
+};
+
 struct adaptive_timeout {
 	time_t		at_binstart;         /* bin start time */
 	unsigned int	at_hist[AT_BINS];    /* timeout history bins */
@@ -67,6 +85,7 @@ struct adaptive_timeout {
 	unsigned int	at_current;          /* current timeout value */
 	unsigned int	at_worst_ever;       /* worst-ever timeout value */
 	time_t		at_worst_time;       /* worst-ever timeout timestamp */
+	struct at_pct	*at_pct;             /* percentile estimator, if any */
 	spinlock_t	at_lock;
 };
 
@@ -100,6 +119,7 @@ enum lustre_imp_state {
         LUSTRE_IMP_RECOVER    = 8,
         LUSTRE_IMP_FULL       = 9,
         LUSTRE_IMP_EVICTED    = 10,
+	LUSTRE_IMP_IDLE       = 11,
 };
 
 /** Returns test string representation of numeric import state \a state */
@@ -108,10 +128,10 @@ static inline char * ptlrpc_import_state_name(enum lustre_imp_state state)
         static char* import_state_names[] = {
                 "<UNKNOWN>", "CLOSED",  "NEW", "DISCONN",
                 "CONNECTING", "REPLAY", "REPLAY_LOCKS", "REPLAY_WAIT",
-                "RECOVER", "FULL", "EVICTED",
+                "RECOVER", "FULL", "EVICTED", "IDLE",
         };
 
-        LASSERT (state <= LUSTRE_IMP_EVICTED);
+        LASSERT (state <= LUSTRE_IMP_IDLE);
         return import_state_names[state];
 }
 
@@ -297,10 +317,14 @@ struct obd_import {
 				   * chouse new connection */
 				  imp_force_reconnect:1,
 				  /* import has tried to connect with server */
-				  imp_connect_tried:1;
+				  imp_connect_tried:1,
+				  /* disconnecting to or reconnecting from IDLE,
+				   * no_delay requests wait for it too */
+				  imp_idle_connect:1;
         __u32                     imp_connect_op;
         struct obd_connect_data   imp_connect_data;
         __u64                     imp_connect_flags_orig;
+	__u64			  imp_connect_flags2_orig;
         int                       imp_connect_error;
 
         __u32                     imp_msg_magic;
@@ -310,6 +334,10 @@ struct obd_import {
 
         struct imp_at             imp_at;                 /* adaptive timeout data */
         time_t                    imp_last_reply_time;    /* for health check */
+	/** last reply to anything but a ping, for the idle check */
+	time_t			  imp_last_use;
+	/** disconnect after so many seconds without use, 0 to never */
+	int			  imp_idle_timeout;
 };
 
 typedef void (*obd_import_callback)(struct obd_import *imp, void *closure,
@@ -366,6 +394,8 @@ static inline int at_get(struct adaptive_timeout *at) {
         return (at->at_current > at_min) ? at->at_current : at_min;
 }
 int at_measured(struct adaptive_timeout *at, unsigned int val);
+void at_update(struct adaptive_timeout *at, unsigned int val, time_t now);
+int at_set_percentile(struct adaptive_timeout *at, unsigned int pct);
 int import_at_get_index(struct obd_import *imp, int portal);
 extern unsigned int at_max;
 #define AT_OFF (at_max == 0)
@@ -135,6 +135,20 @@
 
 #define PTLRPC_NTHRS_INIT	2
 
+/**
+ * Thread autoscaling
+ *
+ * Each service partition measures how long requests wait before a thread
+ * picks them up and how busy its threads are over PTLRPC_THRS_SCALE_INTERVAL.
+ * One more thread is started when the average wait is above the service
+ * target (threads_wait_target in /proc); threads above ?_NTHRS_INIT exit
+ * when the wait is below a quarter of the target and threads are busy less
+ * than PTLRPC_THRS_UTIL_LOW percent of the time.
+ */
+#define PTLRPC_THRS_WAIT_TARGET		10000	/* usec */
+#define PTLRPC_THRS_SCALE_INTERVAL	1	/* sec */
+#define PTLRPC_THRS_UTIL_LOW		50	/* percent */
+
 /**
  * Buffer Constants
  *
@@ -144,12 +158,23 @@
  * ?_BUFSIZE            # bytes in a single request buffer
  * ?_MAXREQSIZE         # maximum request service will receive
  *
- * When fewer than ?_NBUFS/2 buffers are posted for receive, another chunk
- * of ?_NBUFS is added to the pool.
+ * When fewer than half of the growth step are posted for receive, another
+ * chunk of growth step buffers is added to the pool.  The growth step starts
+ * at ?_NBUFS, doubles (up to PTLRPC_RQBD_GROW_MAX times ?_NBUFS) each time
+ * the pool runs low again within PTLRPC_RQBD_GROW_INTERVAL seconds, and goes
+ * back to ?_NBUFS otherwise.  Once the pool stays above its low-water mark,
+ * the growth step is halved every PTLRPC_RQBD_GROW_INTERVAL seconds down to
+ * ?_NBUFS.  Buffers released by requests are freed rather than reposted
+ * while PTLRPC_RQBD_SHRINK_FACTOR times the growth step are already posted,
+ * so the pool shrinks back after a burst.
  *
  * Messages larger than ?_MAXREQSIZE are dropped.  Request buffers are
  * considered full when less than ?_MAXREQSIZE is left in them.
  */
+#define PTLRPC_RQBD_GROW_INTERVAL	1	/* sec */
+#define PTLRPC_RQBD_GROW_MAX		16
+#define PTLRPC_RQBD_SHRINK_FACTOR	4
+
 /**
  * Thread Constants
  *
@@ -612,6 +637,19 @@ struct ptlrpc_request_set {
 	set_producer_func     set_producer;
 	/** opaq argument passed to the producer callback */
 	void                 *set_producer_arg;
+	/**
+	 * Additional fields used by sets processed on events, only ptlrpcd
+	 * sets now. ptlrpc_check_set() then looks at the requests queued on
+	 * \a set_ready by ptlrpc_client_wake_req() only, and at the whole set
+	 * once a second.
+	 */
+	int                   set_events;
+	/** Lock for \a set_ready manipulations */
+	spinlock_t		set_ready_lock;
+	/** List of requests with new events, links rq_ready_chain */
+	cfs_list_t            set_ready;
+	/** Next time all requests are looked at */
+	time_t                set_rescan_time;
 };
 
 /**
@@ -1841,6 +1879,9 @@ struct ptlrpc_request {
                 rq_at_linked:1,     /* link into service's srv_at_array */
                 rq_reply_truncate:1,
                 rq_committed:1,
+		/* sub-request of a compound MDS_BATCH RPC, replied inside
+		 * the reply of the compound request */
+		rq_batch_sub:1,
                 /* whether the "rq_set" is a valid one */
                 rq_invalid_rqset:1,
 		rq_generation_set:1,
@@ -2022,6 +2063,8 @@ struct ptlrpc_request {
 	wait_queue_head_t rq_set_waitq;
 	/** Link item for request set lists */
 	cfs_list_t  rq_set_chain;
+	/** Link item for request set ready list */
+	cfs_list_t  rq_ready_chain;
         /** Link back to the request set */
         struct ptlrpc_request_set *rq_set;
         /** Async completion handler, called when reply is received */
@@ -2315,6 +2358,19 @@ enum {
         SVC_RUNNING     = 1 << 3,
         SVC_EVENT       = 1 << 4,
         SVC_SIGNAL      = 1 << 5,
+	SVC_SHRINKING	= 1 << 6,
+};
+
+/**
+ * Request load accounted by a service thread, see ptlrpc_threads_autoscale()
+ */
+struct ptlrpc_thread_load {
+	/** # requests handled */
+	__u64				tl_nreqs;
+	/** usec requests waited before being handled */
+	__u64				tl_wait;
+	/** usec spent handling requests */
+	__u64				tl_busy;
 };
 
 #define PTLRPC_THR_NAME_LEN		32
@@ -2350,6 +2406,8 @@ struct ptlrpc_thread {
 	wait_queue_head_t		t_ctl_waitq;
 	struct lu_env			*t_env;
 	char				t_name[PTLRPC_THR_NAME_LEN];
+	/** only updated by the thread itself */
+	struct ptlrpc_thread_load	t_load;
 };
 
 static inline int thread_is_init(struct ptlrpc_thread *thread)
@@ -2502,6 +2560,10 @@ struct ptlrpc_service {
 	int				srv_nthrs_cpt_init;
 	/** limit of threads number for each partition */
 	int				srv_nthrs_cpt_limit;
+	/** target of request wait time (usec), 0 disables thread autoscaling */
+	int				srv_thrs_wait_target;
+	/** percentile of service times estimated by AT, 0 for the max */
+	int				srv_at_pct;
         /** Root of /proc dir tree for this service */
         cfs_proc_dir_entry_t           *srv_procroot;
         /** Pointer to statistic data for this service */
@@ -2573,12 +2635,22 @@ struct ptlrpc_service_part {
 	int				scp_thr_nextid;
 	/** # of starting threads */
 	int				scp_nthrs_starting;
-	/** # of stopping threads, reserved for shrinking threads */
+	/** # of threads asked to stop by thread autoscaling */
 	int				scp_nthrs_stopping;
 	/** # running threads */
 	int				scp_nthrs_running;
 	/** service threads list */
 	cfs_list_t			scp_threads;
+	/** last time threads load was sampled */
+	struct timeval			scp_load_time;
+	/** threads load at scp_load_time */
+	struct ptlrpc_thread_load	scp_load_last;
+	/** load of the threads which have been shrunk */
+	struct ptlrpc_thread_load	scp_load_exited;
+	/** average request wait time (usec) over the last interval */
+	long				scp_load_wait;
+	/** threads busy percentage over the last interval */
+	int				scp_load_util;
 
 	/**
 	 * serialize the following fields, used for protecting
@@ -2592,6 +2664,10 @@ struct ptlrpc_service_part {
 	int				scp_nrqbds_posted;
 	/** in progress of allocating rqbd */
 	int				scp_rqbd_allocating;
+	/** # rqbds to allocate when the pool runs low */
+	int				scp_rqbd_grow;
+	/** last time the rqbd pool was grown */
+	cfs_time_t			scp_rqbd_grow_time;
 	/** # incoming reqs */
 	int				scp_nreqs_incoming;
 	/** request buffers to be reposted */
@@ -2730,6 +2806,11 @@ struct ptlrpcd_ctl {
          * Record the partner index to be processed next.
          */
         int                         pc_cursor;
+        /**
+         * CPU partition the thread is bound to, CFS_CPT_ANY if it may run
+         * on any CPU.
+         */
+        int                         pc_cpt;
 #ifndef __KERNEL__
         /**
          * Async rpcs flag to make sure that ptlrpcd_check() is called only
@@ -2945,6 +3026,13 @@ void ptlrpc_set_add_req(struct ptlrpc_request_set *, struct ptlrpc_request *);
 void ptlrpc_set_add_new_req(struct ptlrpcd_ctl *pc,
                             struct ptlrpc_request *req);
 
+void ptlrpc_batch_set_size(struct ptlrpc_request *req,
+			   struct ptlrpc_request **subs, int count);
+void ptlrpc_batch_pack(struct ptlrpc_request *req,
+		       struct ptlrpc_request **subs, int count);
+int ptlrpc_batch_unpack(struct ptlrpc_request *req,
+			struct ptlrpc_request **subs, int count);
+
 void ptlrpc_free_rq_pool(struct ptlrpc_request_pool *pool);
 void ptlrpc_add_rqs_to_pool(struct ptlrpc_request_pool *pool, int num_rq);
 
@@ -3089,6 +3177,8 @@ struct ptlrpc_service_conf {
 void ptlrpc_save_lock(struct ptlrpc_request *req,
                       struct lustre_handle *lock, int mode, int no_ack);
 void ptlrpc_commit_replies(struct obd_export *exp);
+void ptlrpc_schedule_commit_replies(struct obd_export *exp);
+void ptlrpc_update_export_timer(struct obd_export *exp, long extra_delay);
 void ptlrpc_dispatch_difficult_reply(struct ptlrpc_reply_state *rs);
 void ptlrpc_schedule_difficult_reply(struct ptlrpc_reply_state *rs);
 int ptlrpc_hpreq_handler(struct ptlrpc_request *req);
@@ -3105,6 +3195,9 @@ int ptlrpc_service_health_check(struct ptlrpc_service *);
 void ptlrpc_server_drop_request(struct ptlrpc_request *req);
 void ptlrpc_request_change_export(struct ptlrpc_request *req,
 				  struct obd_export *export);
+struct ptlrpc_request *ptlrpc_batch_sub_init(struct ptlrpc_request *req,
+					     struct batch_buf *bb, int idx);
+void ptlrpc_batch_sub_fini(struct ptlrpc_request *sub);
 
 #ifdef __KERNEL__
 int ptlrpc_hr_init(void);
@@ -3223,6 +3316,14 @@ void lustre_msg_set_service_time(struct lustre_msg *msg, __u32 service_time);
 void lustre_msg_set_jobid(struct lustre_msg *msg, char *jobid);
 void lustre_msg_set_cksum(struct lustre_msg *msg, __u32 cksum);
 
+int lustre_batch_buf_size(int count, __u32 *lens);
+void lustre_batch_buf_init(struct batch_buf *bb, int count);
+void lustre_batch_buf_add(struct batch_buf *bb, int idx,
+			  struct lustre_msg *msg, int len);
+struct lustre_msg *lustre_batch_buf_msg(struct batch_buf *bb, int idx,
+					int *len);
+int lustre_batch_buf_check(struct batch_buf *bb, int len, int swab);
+
 static inline void
 lustre_shrink_reply(struct ptlrpc_request *req, int segment,
                     unsigned int newlen, int move_data)
@@ -3340,13 +3441,50 @@ ptlrpc_client_recv_or_unlink(struct ptlrpc_request *req)
 	return rc;
 }
 
+/**
+ * Queue \a req for the next ptlrpc_check_set() of \a set if the set is
+ * processed on events.
+ */
+static inline void
+ptlrpc_set_req_ready(struct ptlrpc_request_set *set,
+		     struct ptlrpc_request *req)
+{
+	if (!set->set_events)
+		return;
+
+	spin_lock(&set->set_ready_lock);
+	if (cfs_list_empty(&req->rq_ready_chain))
+		cfs_list_add_tail(&req->rq_ready_chain, &set->set_ready);
+	spin_unlock(&set->set_ready_lock);
+}
+
+/**
+ * Dequeue \a req from the ready list of \a set, must be called before the
+ * request leaves the set.
+ */
+static inline void
+ptlrpc_set_req_unready(struct ptlrpc_request_set *set,
+		       struct ptlrpc_request *req)
+{
+	if (!set->set_events)
+		return;
+
+	spin_lock(&set->set_ready_lock);
+	cfs_list_del_init(&req->rq_ready_chain);
+	spin_unlock(&set->set_ready_lock);
+}
+
 static inline void
 ptlrpc_client_wake_req(struct ptlrpc_request *req)
 {
-	if (req->rq_set == NULL)
+	struct ptlrpc_request_set *set = req->rq_set;
+
+	if (set == NULL) {
 		wake_up(&req->rq_reply_waitq);
-	else
-		wake_up(&req->rq_set->set_waitq);
+	} else {
+		ptlrpc_set_req_ready(set, req);
+		wake_up(&set->set_waitq);
+	}
 }
 
 static inline void
@@ -3472,6 +3610,7 @@ int ptlrpc_del_timeout_client(cfs_list_t *obd_list,
                               enum timeout_event event);
 struct ptlrpc_request * ptlrpc_prep_ping(struct obd_import *imp);
 int ptlrpc_obd_ping(struct obd_device *obd);
+void ptlrpc_pinger_sending_on_import(struct obd_import *imp);
 #ifdef __KERNEL__
 void ping_evictor_start(void);
 void ping_evictor_stop(void);
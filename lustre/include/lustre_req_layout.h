@@ -158,6 +158,7 @@ extern struct req_format RQF_MDS_SYNC;
 extern struct req_format RQF_MDS_GETXATTR;
 extern struct req_format RQF_MDS_GETATTR;
 extern struct req_format RQF_UPDATE_OBJ;
+extern struct req_format RQF_MDS_BATCH;
 
 /*
  * This is format of direct (non-intent) MDS_GETATTR_NAME request.
@@ -336,6 +337,8 @@ extern struct req_msg_field RMF_U32;
 /* OBJ update format */
 extern struct req_msg_field RMF_UPDATE;
 extern struct req_msg_field RMF_UPDATE_REPLY;
+extern struct req_msg_field RMF_BATCH_BUF;
+extern struct req_msg_field RMF_BATCH_REPLY;
 /** @} req_layout */
 
 #endif /* _LUSTRE_REQ_LAYOUT_H__ */
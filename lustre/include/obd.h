@@ -1454,6 +1454,11 @@ struct md_ops {
 			  const char *, int, int, int,
 			  struct ptlrpc_request **);
 
+	int (*m_getattr_xattr)(struct obd_export *, struct md_op_data *,
+			       obd_valid, const char *, int,
+			       struct ptlrpc_request **,
+			       struct ptlrpc_request **);
+
         int (*m_intent_getattr_async)(struct obd_export *,
                                       struct md_enqueue_info *,
                                       struct ldlm_enqueue_info *);
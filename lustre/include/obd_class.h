@@ -113,7 +113,8 @@ char *obd_export_nid2str(struct obd_export *exp);
 
 int obd_export_evict_by_nid(struct obd_device *obd, const char *nid);
 int obd_export_evict_by_uuid(struct obd_device *obd, const char *uuid);
-int obd_connect_flags2str(char *page, int count, __u64 flags, char *sep);
+int obd_connect_flags2str(char *page, int count, __u64 flags, __u64 flags2,
+			  char *sep);
 
 int obd_zombie_impexp_init(void);
 void obd_zombie_impexp_stop(void);
@@ -2079,6 +2080,21 @@ static inline int md_getxattr(struct obd_export *exp,
                                            request));
 }
 
+static inline int md_getattr_xattr(struct obd_export *exp,
+				   struct md_op_data *op_data,
+				   obd_valid xattr_valid,
+				   const char *xattr_name, int xattr_size,
+				   struct ptlrpc_request **request,
+				   struct ptlrpc_request **xattr_req)
+{
+	ENTRY;
+	EXP_CHECK_MD_OP(exp, getattr_xattr);
+	EXP_MD_COUNTER_INCREMENT(exp, getattr_xattr);
+	RETURN(MDP(exp->exp_obd, getattr_xattr)(exp, op_data, xattr_valid,
+						xattr_name, xattr_size,
+						request, xattr_req));
+}
+
 static inline int md_set_open_replay_data(struct obd_export *exp,
 					  struct obd_client_handle *och,
 					  struct lookup_intent *it)
@@ -244,6 +244,7 @@ int obd_alloc_fail(const void *ptr, const char *name, const char *type,
 #define OBD_FAIL_MDS_HSM_ACTION_NET		0x150
 #define OBD_FAIL_MDS_CHANGELOG_INIT		0x151
 #define OBD_FAIL_MDS_HSM_SWAP_LAYOUTS		0x152
+#define OBD_FAIL_MDS_BATCH_NET			0x153
 
 /* layout lock */
 #define OBD_FAIL_MDS_NO_LL_GETATTR	 0x170
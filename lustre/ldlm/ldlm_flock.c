@@ -100,38 +100,64 @@ ldlm_flocks_overlap(struct ldlm_lock *lock, struct ldlm_lock *new)
                 lock->l_policy_data.l_flock.start));
 }
 
+/**
+ * Key of a node in the flock wait-for graph: the owner cookie of a POSIX
+ * locker and the NID of its client. The owner must stay the first member,
+ * see ldlm_flock_wfg_hash().
+ */
+struct ldlm_flock_wfg_key {
+	__u64		fwk_owner;
+	lnet_nid_t	fwk_nid;
+};
+
+static inline lnet_nid_t ldlm_flock_nid(struct ldlm_lock *lock)
+{
+	if (lock->l_export == NULL)
+		return LNET_NID_ANY;
+	return lock->l_export->exp_connection->c_peer.nid;
+}
+
+static inline void ldlm_flock_wfg_key_init(struct ldlm_flock_wfg_key *key,
+					   struct ldlm_lock *lock)
+{
+	key->fwk_owner = lock->l_policy_data.l_flock.owner;
+	key->fwk_nid = ldlm_flock_nid(lock);
+}
+
 static inline void ldlm_flock_blocking_link(struct ldlm_lock *req,
 					    struct ldlm_lock *lock)
 {
+	cfs_hash_t *wfg = ldlm_res_to_ns(req->l_resource)->ns_flock_wfg;
+	struct ldlm_flock_wfg_key key;
+
         /* For server only */
-        if (req->l_export == NULL)
+	if (req->l_export == NULL || wfg == NULL)
 		return;
 
 	LASSERT(cfs_hlist_unhashed(&req->l_exp_flock_hash));
 
         req->l_policy_data.l_flock.blocking_owner =
                 lock->l_policy_data.l_flock.owner;
-        req->l_policy_data.l_flock.blocking_export =
-		lock->l_export;
-	req->l_policy_data.l_flock.blocking_refs = 0;
+	req->l_policy_data.l_flock.blocking_nid = ldlm_flock_nid(lock);
 
-	cfs_hash_add(req->l_export->exp_flock_hash,
-		     &req->l_policy_data.l_flock.owner,
-		     &req->l_exp_flock_hash);
+	ldlm_flock_wfg_key_init(&key, req);
+	cfs_hash_add(wfg, &key, &req->l_exp_flock_hash);
 }
 
 static inline void ldlm_flock_blocking_unlink(struct ldlm_lock *req)
 {
+	cfs_hash_t *wfg = ldlm_res_to_ns(req->l_resource)->ns_flock_wfg;
+	struct ldlm_flock_wfg_key key;
+
         /* For server only */
-        if (req->l_export == NULL)
+	if (req->l_export == NULL || wfg == NULL)
                 return;
 
 	check_res_locked(req->l_resource);
-	if (req->l_export->exp_flock_hash != NULL &&
-	    !cfs_hlist_unhashed(&req->l_exp_flock_hash))
-		cfs_hash_del(req->l_export->exp_flock_hash,
-			     &req->l_policy_data.l_flock.owner,
-			     &req->l_exp_flock_hash);
+	if (!cfs_hlist_unhashed(&req->l_exp_flock_hash)) {
+		ldlm_flock_wfg_key_init(&key, req);
+		cfs_hash_del(wfg, &key, &req->l_exp_flock_hash);
+	}
 }
 
 static inline void
@@ -163,94 +189,64 @@ ldlm_flock_destroy(struct ldlm_lock *lock, ldlm_mode_t mode, __u64 flags)
 /**
  * POSIX locks deadlock detection code.
  *
- * Given a new lock \a req and an existing lock \a bl_lock it conflicts
- * with, we need to iterate through all blocked POSIX locks for this
- * export and see if there is a deadlock condition arising. (i.e. when
- * one client holds a lock on something and want a lock on something
- * else and at the same time another client has the opposite situation).
+ * Every blocked POSIX lock on the server is a node of the namespace wait-for
+ * graph ns_flock_wfg, keyed by its owner and client NID, with an edge to the
+ * owner of the first lock it conflicts with (blocking_owner/blocking_nid).
+ * The graph is maintained incrementally: a lock is added when it starts to
+ * wait in ldlm_flock_blocking_link() and removed when it stops waiting in
+ * ldlm_flock_blocking_unlink().
+ *
+ * A process sleeps on one lock at a time, so each node has at most one
+ * outgoing edge and a new edge \a req -> \a bl_lock closes a cycle (i.e.
+ * one client holds a lock on something and wants a lock on something else
+ * and at the same time another client has the opposite situation) iff the
+ * path starting at the owner of \a bl_lock leads back to the owner of
+ * \a req. Every hop of that path is a single hash lookup.
  */
-
-struct ldlm_flock_lookup_cb_data {
-	__u64 *bl_owner;
-	struct ldlm_lock *lock;
-	struct obd_export *exp;
-};
-
-static int ldlm_flock_lookup_cb(cfs_hash_t *hs, cfs_hash_bd_t *bd,
-				cfs_hlist_node_t *hnode, void *data)
-{
-	struct ldlm_flock_lookup_cb_data *cb_data = data;
-	struct obd_export *exp = cfs_hash_object(hs, hnode);
-	struct ldlm_lock *lock;
-
-	lock = cfs_hash_lookup(exp->exp_flock_hash, cb_data->bl_owner);
-	if (lock == NULL)
-		return 0;
-
-	/* Stop on first found lock. Same process can't sleep twice */
-	cb_data->lock = lock;
-	cb_data->exp = class_export_get(exp);
-
-	return 1;
-}
-
 static int
 ldlm_flock_deadlock(struct ldlm_lock *req, struct ldlm_lock *bl_lock)
 {
-        struct obd_export *req_exp = req->l_export;
-        struct obd_export *bl_exp = bl_lock->l_export;
-        __u64 req_owner = req->l_policy_data.l_flock.owner;
-        __u64 bl_owner = bl_lock->l_policy_data.l_flock.owner;
+	cfs_hash_t *wfg = ldlm_res_to_ns(req->l_resource)->ns_flock_wfg;
+	struct ldlm_flock_wfg_key req_key;
+	struct ldlm_flock_wfg_key key;
+	int hops;
 
         /* For server only */
-        if (req_exp == NULL)
+	if (req->l_export == NULL || wfg == NULL)
                 return 0;
 
-        class_export_get(bl_exp);
-	while (1) {
-		struct ldlm_flock_lookup_cb_data cb_data = {
-					.bl_owner = &bl_owner,
-					.lock = NULL,
-					.exp = NULL };
-		struct obd_export *bl_exp_new;
-		struct ldlm_lock *lock = NULL;
+	ldlm_flock_wfg_key_init(&req_key, req);
+	ldlm_flock_wfg_key_init(&key, bl_lock);
+
+	/* There is no cycle in the graph which does not include @req, so the
+	 * path has at most as many nodes as the graph. The limit only protects
+	 * against concurrent updates of the graph from other resources. */
+	hops = cfs_hash_size_get(wfg) + 1;
+	while (hops-- > 0) {
+		struct ldlm_lock *lock;
 		struct ldlm_flock *flock;
+		int failed;
 
-		if (bl_exp->exp_flock_hash != NULL) {
-			cfs_hash_for_each_key(bl_exp->exp_obd->obd_nid_hash,
-				&bl_exp->exp_connection->c_peer.nid,
-				ldlm_flock_lookup_cb, &cb_data);
-			lock = cb_data.lock;
-		}
+		if (key.fwk_owner == req_key.fwk_owner &&
+		    key.fwk_nid == req_key.fwk_nid)
+			return 1;
+
+		lock = cfs_hash_lookup(wfg, &key);
 		if (lock == NULL)
 			break;
 
-		class_export_put(bl_exp);
-		bl_exp = cb_data.exp;
-
 		LASSERT(req != lock);
 		flock = &lock->l_policy_data.l_flock;
-		LASSERT(flock->owner == bl_owner);
-                bl_owner = flock->blocking_owner;
-                bl_exp_new = class_export_get(flock->blocking_export);
-                class_export_put(bl_exp);
-
-		cfs_hash_put(bl_exp->exp_flock_hash, &lock->l_exp_flock_hash);
-                bl_exp = bl_exp_new;
+		key.fwk_owner = flock->blocking_owner;
+		key.fwk_nid = flock->blocking_nid;
+		failed = lock->l_export->exp_failed;
+		cfs_hash_put(wfg, &lock->l_exp_flock_hash);
 
-		if (bl_exp->exp_failed)
+		if (failed)
 			break;
+	}
 
-		if (bl_owner == req_owner &&
-		    (bl_exp->exp_connection->c_peer.nid ==
-		     req_exp->exp_connection->c_peer.nid)) {
-                        class_export_put(bl_exp);
-                        return 1;
-                }
-        }
-        class_export_put(bl_exp);
-
-        return 0;
+	return 0;
 }
 
 static void ldlm_flock_cancel_on_deadlock(struct ldlm_lock *lock,
@@ -523,7 +519,8 @@ reprocess:
 						lock->l_granted_mode, &null_cbs,
 						NULL, 0, LVB_T_NONE);
                         lock_res_and_lock(req);
-                        if (!new2) {
+			if (IS_ERR(new2)) {
+				new2 = NULL;
                                 ldlm_flock_destroy(req, lock->l_granted_mode,
                                                    *flags);
                                 *err = -ENOLCK;
@@ -844,16 +841,18 @@ void ldlm_flock_policy_local_to_wire(const ldlm_policy_data_t *lpolicy,
 }
 
 /*
- * Export handle<->flock hash operations.
+ * Flock wait-for graph hash operations.
  */
 static unsigned
-ldlm_export_flock_hash(cfs_hash_t *hs, const void *key, unsigned mask)
+ldlm_flock_wfg_hash(cfs_hash_t *hs, const void *key, unsigned mask)
 {
+	/* Both struct ldlm_flock_wfg_key and the key returned by
+	 * ldlm_flock_wfg_key() start with the owner. */
 	return cfs_hash_u64_hash(*(__u64 *)key, mask);
 }
 
 static void *
-ldlm_export_flock_key(cfs_hlist_node_t *hnode)
+ldlm_flock_wfg_key(cfs_hlist_node_t *hnode)
 {
 	struct ldlm_lock *lock;
 
@@ -862,87 +861,75 @@ ldlm_export_flock_key(cfs_hlist_node_t *hnode)
 }
 
 static int
-ldlm_export_flock_keycmp(const void *key, cfs_hlist_node_t *hnode)
+ldlm_flock_wfg_keycmp(const void *key, cfs_hlist_node_t *hnode)
 {
-	return !memcmp(ldlm_export_flock_key(hnode), key, sizeof(__u64));
+	const struct ldlm_flock_wfg_key *fwk = key;
+	struct ldlm_lock *lock;
+
+	lock = cfs_hlist_entry(hnode, struct ldlm_lock, l_exp_flock_hash);
+	return lock->l_policy_data.l_flock.owner == fwk->fwk_owner &&
+	       ldlm_flock_nid(lock) == fwk->fwk_nid;
 }
 
 static void *
-ldlm_export_flock_object(cfs_hlist_node_t *hnode)
+ldlm_flock_wfg_object(cfs_hlist_node_t *hnode)
 {
 	return cfs_hlist_entry(hnode, struct ldlm_lock, l_exp_flock_hash);
 }
 
 static void
-ldlm_export_flock_get(cfs_hash_t *hs, cfs_hlist_node_t *hnode)
+ldlm_flock_wfg_get(cfs_hash_t *hs, cfs_hlist_node_t *hnode)
 {
 	struct ldlm_lock *lock;
-	struct ldlm_flock *flock;
 
 	lock = cfs_hlist_entry(hnode, struct ldlm_lock, l_exp_flock_hash);
 	LDLM_LOCK_GET(lock);
-
-	flock = &lock->l_policy_data.l_flock;
-	LASSERT(flock->blocking_export != NULL);
-	class_export_get(flock->blocking_export);
-	flock->blocking_refs++;
 }
 
 static void
-ldlm_export_flock_put(cfs_hash_t *hs, cfs_hlist_node_t *hnode)
+ldlm_flock_wfg_put(cfs_hash_t *hs, cfs_hlist_node_t *hnode)
 {
 	struct ldlm_lock *lock;
-	struct ldlm_flock *flock;
 
 	lock = cfs_hlist_entry(hnode, struct ldlm_lock, l_exp_flock_hash);
 	LDLM_LOCK_RELEASE(lock);
-
-	flock = &lock->l_policy_data.l_flock;
-	LASSERT(flock->blocking_export != NULL);
-	class_export_put(flock->blocking_export);
-	if (--flock->blocking_refs == 0) {
-		flock->blocking_owner = 0;
-		flock->blocking_export = NULL;
-	}
 }
 
-static cfs_hash_ops_t ldlm_export_flock_ops = {
-	.hs_hash        = ldlm_export_flock_hash,
-	.hs_key         = ldlm_export_flock_key,
-	.hs_keycmp      = ldlm_export_flock_keycmp,
-	.hs_object      = ldlm_export_flock_object,
-	.hs_get         = ldlm_export_flock_get,
-	.hs_put         = ldlm_export_flock_put,
-	.hs_put_locked  = ldlm_export_flock_put,
+static cfs_hash_ops_t ldlm_flock_wfg_ops = {
+	.hs_hash        = ldlm_flock_wfg_hash,
+	.hs_key         = ldlm_flock_wfg_key,
+	.hs_keycmp      = ldlm_flock_wfg_keycmp,
+	.hs_object      = ldlm_flock_wfg_object,
+	.hs_get         = ldlm_flock_wfg_get,
+	.hs_put         = ldlm_flock_wfg_put,
+	.hs_put_locked  = ldlm_flock_wfg_put,
 };
 
-int ldlm_init_flock_export(struct obd_export *exp)
+int ldlm_init_flock_wfg(struct ldlm_namespace *ns)
 {
-	if( strcmp(exp->exp_obd->obd_type->typ_name, LUSTRE_MDT_NAME) != 0)
-		RETURN(0);
+	ENTRY;
 
-	exp->exp_flock_hash =
-		cfs_hash_create(obd_uuid2str(&exp->exp_client_uuid),
-				HASH_EXP_LOCK_CUR_BITS,
-				HASH_EXP_LOCK_MAX_BITS,
-				HASH_EXP_LOCK_BKT_BITS, 0,
-				CFS_HASH_MIN_THETA, CFS_HASH_MAX_THETA,
-				&ldlm_export_flock_ops,
-				CFS_HASH_DEFAULT | CFS_HASH_NBLK_CHANGE);
-	if (!exp->exp_flock_hash)
+	ns->ns_flock_wfg = cfs_hash_create(ldlm_ns_name(ns),
+					   HASH_EXP_LOCK_CUR_BITS,
+					   HASH_EXP_LOCK_MAX_BITS,
+					   HASH_EXP_LOCK_BKT_BITS, 0,
+					   CFS_HASH_MIN_THETA,
+					   CFS_HASH_MAX_THETA,
+					   &ldlm_flock_wfg_ops,
+					   CFS_HASH_DEFAULT |
+					   CFS_HASH_NBLK_CHANGE);
+	if (ns->ns_flock_wfg == NULL)
 		RETURN(-ENOMEM);
 
 	RETURN(0);
 }
-EXPORT_SYMBOL(ldlm_init_flock_export);
 
-void ldlm_destroy_flock_export(struct obd_export *exp)
+void ldlm_fini_flock_wfg(struct ldlm_namespace *ns)
 {
 	ENTRY;
-	if (exp->exp_flock_hash) {
-		cfs_hash_putref(exp->exp_flock_hash);
-		exp->exp_flock_hash = NULL;
+	if (ns->ns_flock_wfg != NULL) {
+		cfs_hash_putref(ns->ns_flock_wfg);
+		ns->ns_flock_wfg = NULL;
 	}
 	EXIT;
 }
-EXPORT_SYMBOL(ldlm_destroy_flock_export);
@@ -525,6 +525,7 @@ int client_connect_import(const struct lu_env *env,
         if (data) {
                 *ocd = *data;
                 imp->imp_connect_flags_orig = data->ocd_connect_flags;
+		imp->imp_connect_flags2_orig = data->ocd_connect_flags2;
         }
 
         rc = ptlrpc_connect_import(imp);
@@ -225,6 +225,8 @@ void ldlm_lock_put(struct ldlm_lock *lock)
 
                 lprocfs_counter_decr(ldlm_res_to_ns(res)->ns_stats,
                                      LDLM_NSS_LOCKS);
+		if (res->lr_type == LDLM_EXTENT)
+			ldlm_interval_free(ldlm_interval_detach(lock));
                 lu_ref_del(&res->lr_reference, "lock", lock);
                 ldlm_resource_putref(res);
                 lock->l_resource = NULL;
@@ -236,7 +238,6 @@ void ldlm_lock_put(struct ldlm_lock *lock)
                 if (lock->l_lvb_data != NULL)
                         OBD_FREE_LARGE(lock->l_lvb_data, lock->l_lvb_len);
 
-                ldlm_interval_free(ldlm_interval_detach(lock));
                 lu_ref_fini(&lock->l_reference);
 		OBD_FREE_RCU(lock, sizeof(*lock), &lock->l_handle);
         }
@@ -491,10 +492,21 @@ static struct ldlm_lock *ldlm_lock_new(struct ldlm_resource *resource)
 	CFS_INIT_LIST_HEAD(&lock->l_rk_ast);
 	init_waitqueue_head(&lock->l_waitq);
 	lock->l_blocking_lock = NULL;
-	CFS_INIT_LIST_HEAD(&lock->l_sl_mode);
 	CFS_INIT_LIST_HEAD(&lock->l_sl_policy);
 	CFS_INIT_HLIST_NODE(&lock->l_exp_hash);
-	CFS_INIT_HLIST_NODE(&lock->l_exp_flock_hash);
+
+	/* Only initialize type specific members, they share storage. */
+	switch (resource->lr_type) {
+	case LDLM_EXTENT:
+		lock->l_tree_node = NULL;
+		break;
+	case LDLM_FLOCK:
+		CFS_INIT_HLIST_NODE(&lock->l_exp_flock_hash);
+		break;
+	default:
+		CFS_INIT_LIST_HEAD(&lock->l_sl_mode);
+		break;
+	}
 
         lprocfs_counter_incr(ldlm_res_to_ns(resource)->ns_stats,
                              LDLM_NSS_LOCKS);
@@ -1579,7 +1591,8 @@ int ldlm_fill_lvb(struct ldlm_lock *lock, struct req_capsule *pill,
 
 /**
  * Create and fill in new LDLM lock with specified properties.
- * Returns a referenced lock
+ * Returns a referenced lock, or ERR_PTR(-EPROTO) if \a type does not match
+ * the type of an existing resource and ERR_PTR(-ENOMEM) on other failures.
  */
 struct ldlm_lock *ldlm_lock_create(struct ldlm_namespace *ns,
                                    const struct ldlm_res_id *res_id,
@@ -1595,12 +1608,23 @@ struct ldlm_lock *ldlm_lock_create(struct ldlm_namespace *ns,
 
         res = ldlm_resource_get(ns, NULL, res_id, type, 1);
         if (res == NULL)
-                RETURN(NULL);
+                RETURN(ERR_PTR(-ENOMEM));
+
+	/* The type specific members of the lock share storage, the layout
+	 * is chosen by the resource type, which has to match the request. */
+	if (unlikely(res->lr_type != type)) {
+		CERROR("%s: lock type %d does not match resource "DLDLMRES
+		       " type %d\n", ldlm_ns_name(ns), type, PLDLMRES(res),
+		       res->lr_type);
+		ldlm_resource_putref(res);
+		RETURN(ERR_PTR(-EPROTO));
+	}
 
         lock = ldlm_lock_new(res);
-
-        if (lock == NULL)
-                RETURN(NULL);
+        if (lock == NULL) {
+		ldlm_resource_putref(res);
+                RETURN(ERR_PTR(-ENOMEM));
+	}
 
 	lock->l_req_mode = mode;
 	lock->l_ast_data = data;
@@ -1613,9 +1637,8 @@ struct ldlm_lock *ldlm_lock_create(struct ldlm_namespace *ns,
                 lock->l_glimpse_ast = cbs->lcs_glimpse;
         }
 
-        lock->l_tree_node = NULL;
         /* if this is the extent lock, allocate the interval tree node */
-        if (type == LDLM_EXTENT) {
+        if (res->lr_type == LDLM_EXTENT) {
                 if (ldlm_interval_alloc(lock) == NULL)
                         GOTO(out, 0);
         }
@@ -1636,7 +1659,7 @@ struct ldlm_lock *ldlm_lock_create(struct ldlm_namespace *ns,
 out:
         ldlm_lock_destroy(lock);
         LDLM_LOCK_RELEASE(lock);
-        return NULL;
+        RETURN(ERR_PTR(-ENOMEM));
 }
 
 /**
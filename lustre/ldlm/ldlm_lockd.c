@@ -706,6 +706,12 @@ static int ldlm_cb_interpret(const struct lu_env *env,
 
         LASSERT(lock != NULL);
 
+	/* The client replied, no matter how, so it is alive as if it had
+	 * pinged us.  Busy clients skip pings relying on that, see
+	 * ldlm_callback_handler(). */
+	if (req->rq_replied && lock->l_export != NULL)
+		ptlrpc_update_export_timer(lock->l_export, 0);
+
 	switch (arg->type) {
 	case LDLM_GL_CALLBACK:
 		/* Update the LVB from disk if the AST failed
@@ -1285,8 +1291,11 @@ int ldlm_handle_enqueue0(struct ldlm_namespace *ns,
                                 dlm_req->lock_desc.l_resource.lr_type,
                                 dlm_req->lock_desc.l_req_mode,
 				cbs, NULL, 0, LVB_T_NONE);
-        if (!lock)
-                GOTO(out, rc = -ENOMEM);
+	if (IS_ERR(lock)) {
+		rc = PTR_ERR(lock);
+		lock = NULL;
+		GOTO(out, rc);
+	}
 
         lock->l_last_activity = cfs_time_current_sec();
         lock->l_remote_handle = dlm_req->lock_handle[0];
@@ -1334,13 +1343,23 @@ existing_lock:
                         GOTO(out, rc);
         }
 
-        if (dlm_req->lock_desc.l_resource.lr_type != LDLM_PLAIN)
-                ldlm_convert_policy_to_local(req->rq_export,
-                                          dlm_req->lock_desc.l_resource.lr_type,
-                                          &dlm_req->lock_desc.l_policy_data,
-                                          &lock->l_policy_data);
-        if (dlm_req->lock_desc.l_resource.lr_type == LDLM_EXTENT)
-                lock->l_req_extent = lock->l_policy_data.l_extent;
+	/* A resent request finds its lock by handle, make sure it still
+	 * describes the same lock type before the policy is copied into the
+	 * type specific members of the lock. */
+	if (unlikely(lock->l_resource->lr_type !=
+		     dlm_req->lock_desc.l_resource.lr_type)) {
+		LDLM_ERROR(lock, "lock type %d does not match resource",
+			   dlm_req->lock_desc.l_resource.lr_type);
+		GOTO(out, rc = -EPROTO);
+	}
+
+	if (lock->l_resource->lr_type != LDLM_PLAIN)
+		ldlm_convert_policy_to_local(req->rq_export,
+					     lock->l_resource->lr_type,
+					     &dlm_req->lock_desc.l_policy_data,
+					     &lock->l_policy_data);
+	if (lock->l_resource->lr_type == LDLM_EXTENT)
+		lock->l_req_extent = lock->l_policy_data.l_extent;
 
 	err = ldlm_lock_enqueue(ns, &lock, cookie, &flags);
 	if (err) {
@@ -2273,6 +2292,16 @@ static int ldlm_callback_handler(struct ptlrpc_request *req)
         }
         unlock_res_and_lock(lock);
 
+	/* Our reply to the callback tells the server we are alive, put off
+	 * the next ping if it counts such replies as pings. */
+	if (ns_is_client(ns)) {
+		struct obd_import *imp = ns->ns_obd->u.cli.cl_import;
+
+		if (imp != NULL &&
+		    OCD_HAS_FLAG(&imp->imp_connect_data, AST_ALIVE))
+			ptlrpc_pinger_sending_on_import(imp);
+	}
+
         /* We want the ost thread to get this reply so that it can respond
          * to ost requests (write cache writeback) that might be triggered
          * in the callback.
@@ -2779,7 +2808,6 @@ static cfs_hash_ops_t ldlm_export_lock_ops = {
 
 int ldlm_init_export(struct obd_export *exp)
 {
-	int rc;
         ENTRY;
 
         exp->exp_lock_hash =
@@ -2795,14 +2823,7 @@ int ldlm_init_export(struct obd_export *exp)
         if (!exp->exp_lock_hash)
                 RETURN(-ENOMEM);
 
-	rc = ldlm_init_flock_export(exp);
-	if (rc)
-		GOTO(err, rc);
-
         RETURN(0);
-err:
-	ldlm_destroy_export(exp);
-	RETURN(rc);
 }
 EXPORT_SYMBOL(ldlm_init_export);
 
@@ -2811,8 +2832,6 @@ void ldlm_destroy_export(struct obd_export *exp)
         ENTRY;
         cfs_hash_putref(exp->exp_lock_hash);
         exp->exp_lock_hash = NULL;
-
-	ldlm_destroy_flock_export(exp);
         EXIT;
 }
 EXPORT_SYMBOL(ldlm_destroy_export);
@@ -3085,13 +3104,15 @@ void ldlm_exit(void)
 {
 	if (ldlm_refcount)
 		CERROR("ldlm_refcount is %d in ldlm_exit!\n", ldlm_refcount);
-	kmem_cache_destroy(ldlm_resource_slab);
 #ifdef __KERNEL__
 	/* ldlm_lock_put() use RCU to call ldlm_lock_free, so need call
 	 * synchronize_rcu() to wait a grace period elapsed, so that
 	 * ldlm_lock_free() get a chance to be called. */
 	synchronize_rcu();
+	/* resources are freed by call_rcu(), wait for pending callbacks */
+	rcu_barrier();
 #endif
+	kmem_cache_destroy(ldlm_resource_slab);
 	kmem_cache_destroy(ldlm_lock_slab);
 	kmem_cache_destroy(ldlm_interval_slab);
 }
@@ -87,6 +87,19 @@
  * pl_grant_speed - Grant speed (GR - CR) for last T (calculated);
  * pl_grant_plan - Planned number of granted locks for next T (calculated);
  * pl_server_lock_volume - Current server lock volume (calculated);
+ * pl_slv_goal - Number of granted locks SLV controller aims at (calculated);
+ * pl_slv_target - pl_slv_goal in % of pl_limit without memory pressure
+ * (tunable);
+ * pl_slv_kp, pl_slv_ki, pl_slv_kd - SLV controller gains (tunable);
+ * pl_mem_pressure - Locks recently asked by the shrinker (calculated);
+ *
+ * SLV on server is driven by a PID controller: each period the relative
+ * distance of pl_granted from pl_slv_goal is fed to the controller, whose
+ * output is the relative SLV change for the next period. Integral term
+ * removes the steady-state error which made the old grant plan formula
+ * oscillate around the plan, derivative term damps reaction to bursts and
+ * the step is bounded by pl_slv_max_step. Memory pressure seen by the
+ * shrinker lowers pl_slv_goal, so SLV drops while VM is short of memory.
  *
  * As it may be seen from list above, we have few possible tunables which may
  * affect behavior much. They all may be modified via proc. However, they also
@@ -147,6 +160,35 @@
  */
 #define LDLM_POOL_SLV_SHIFT (10)
 
+/*
+ * Default SLV controller gains, in %.
+ */
+#define LDLM_POOL_SLV_KP (50)
+#define LDLM_POOL_SLV_KI (10)
+#define LDLM_POOL_SLV_KD (20)
+
+/*
+ * Default target of granted locks in % of limit.
+ */
+#define LDLM_POOL_SLV_TARGET (90)
+
+/*
+ * Default max SLV change per period, 25%.
+ */
+#define LDLM_POOL_SLV_MAX_STEP (1 << (LDLM_POOL_SLV_SHIFT - 2))
+
+/*
+ * Bound of the integral term to avoid windup while SLV is clamped.
+ */
+#define LDLM_POOL_SLV_IMAX (4 << LDLM_POOL_SLV_SHIFT)
+
+/*
+ * Upper bound of the controller gains, in %.  With |error| <= 1 << SHIFT,
+ * |error delta| <= 2 << SHIFT and |integral| <= IMAX the weighted sum of
+ * the three terms stays well inside an int.
+ */
+#define LDLM_POOL_SLV_KMAX (10000)
+
 #ifdef __KERNEL__
 extern cfs_proc_dir_entry_t *ldlm_ns_proc_dir;
 #endif
@@ -250,42 +292,74 @@ static void ldlm_pool_recalc_grant_plan(struct ldlm_pool *pl)
  */
 static void ldlm_pool_recalc_slv(struct ldlm_pool *pl)
 {
-        int granted;
-        int grant_plan;
-        int round_up;
-        __u64 slv;
-        __u64 slv_factor;
-        __u64 grant_usage;
-        __u32 limit;
+	int granted;
+	int goal;
+	int diff;
+	int error;
+	int output;
+	int max_step;
+	__u64 slv;
+	__u64 tmp;
+	__u32 limit;
 
-        slv = pl->pl_server_lock_volume;
-        grant_plan = pl->pl_grant_plan;
-        limit = ldlm_pool_get_limit(pl);
-        granted = cfs_atomic_read(&pl->pl_granted);
-        round_up = granted < limit;
+	slv = pl->pl_server_lock_volume;
+	limit = ldlm_pool_get_limit(pl);
+	granted = cfs_atomic_read(&pl->pl_granted);
 
-        grant_usage = max_t(int, limit - (granted - grant_plan), 1);
+	/*
+	 * Smooth what shrinker asked for during last period, a single
+	 * shrink call should not make SLV collapse.
+	 */
+	pl->pl_mem_pressure = (pl->pl_mem_pressure + pl->pl_shrink_nr) >> 1;
+	pl->pl_shrink_nr = 0;
 
-        /*
-         * Find out SLV change factor which is the ratio of grant usage
-         * from limit. SLV changes as fast as the ratio of grant plan
-         * consumption. The more locks from grant plan are not consumed
-         * by clients in last interval (idle time), the faster grows
-         * SLV. And the opposite, the more grant plan is over-consumed
-         * (load time) the faster drops SLV.
-         */
-        slv_factor = (grant_usage << LDLM_POOL_SLV_SHIFT);
-        do_div(slv_factor, limit);
-        slv = slv * slv_factor;
-        slv = dru(slv, LDLM_POOL_SLV_SHIFT, round_up);
-
-        if (slv > ldlm_pool_slv_max(limit)) {
-                slv = ldlm_pool_slv_max(limit);
-        } else if (slv < ldlm_pool_slv_min(limit)) {
-                slv = ldlm_pool_slv_min(limit);
-        }
+	tmp = (__u64)limit * pl->pl_slv_target;
+	do_div(tmp, 100);
+	goal = tmp;
+	goal -= min(pl->pl_mem_pressure, goal >> 1);
+	goal = max(goal, 1);
+	pl->pl_slv_goal = goal;
 
-        pl->pl_server_lock_volume = slv;
+	/*
+	 * Relative error in 1/1024 units: positive means clients may cache
+	 * more locks, negative means too many locks are granted.
+	 */
+	diff = goal - granted;
+	if (diff < -goal)
+		diff = -goal;
+	tmp = (__u64)abs(diff) << LDLM_POOL_SLV_SHIFT;
+	do_div(tmp, goal);
+	error = diff < 0 ? -(int)tmp : (int)tmp;
+
+	pl->pl_slv_integral += error;
+	if (pl->pl_slv_integral > LDLM_POOL_SLV_IMAX)
+		pl->pl_slv_integral = LDLM_POOL_SLV_IMAX;
+	else if (pl->pl_slv_integral < -LDLM_POOL_SLV_IMAX)
+		pl->pl_slv_integral = -LDLM_POOL_SLV_IMAX;
+
+	output = (pl->pl_slv_kp * error +
+		  pl->pl_slv_ki * pl->pl_slv_integral +
+		  pl->pl_slv_kd * (error - pl->pl_slv_error)) / 100;
+
+	max_step = min(pl->pl_slv_max_step, (1 << LDLM_POOL_SLV_SHIFT) - 1);
+	if (output > max_step)
+		output = max_step;
+	else if (output < -max_step)
+		output = -max_step;
+
+	pl->pl_slv_error = error;
+	pl->pl_slv_output = output;
+
+	slv = slv * ((1 << LDLM_POOL_SLV_SHIFT) + output);
+	slv = dru(slv, LDLM_POOL_SLV_SHIFT, output > 0);
+
+	if (slv > ldlm_pool_slv_max(limit)) {
+		slv = ldlm_pool_slv_max(limit);
+	} else if (slv < ldlm_pool_slv_min(limit)) {
+		slv = ldlm_pool_slv_min(limit);
+	}
+
+	pl->pl_server_lock_volume = slv;
 }
 
 /**
@@ -405,6 +479,11 @@ static int ldlm_srv_pool_shrink(struct ldlm_pool *pl,
 
 	spin_lock(&pl->pl_lock);
 
+	/*
+	 * Let SLV controller lower its goal while memory is short.
+	 */
+	pl->pl_shrink_nr += nr;
+
         /*
          * We want shrinker to possibly cause cancellation of @nr locks from
          * clients or grant approximately @nr locks smaller next intervals.
@@ -503,6 +582,11 @@ static int ldlm_cli_pool_recalc(struct ldlm_pool *pl)
         ldlm_cli_pool_pop_slv(pl);
 	spin_unlock(&pl->pl_lock);
 
+	/*
+	 * Send the deferred cancels which waited long enough.
+	 */
+	ldlm_cancel_batch_flush(ldlm_pl2ns(pl), 1);
+
         /*
          * Do not cancel locks in case lru resize is disabled for this ns.
          */
@@ -678,6 +762,7 @@ static int lprocfs_rd_pool_state(char *page, char **start, off_t off,
 {
         int granted, grant_rate, cancel_rate, grant_step;
         int nr = 0, grant_speed, grant_plan, lvf;
+	int goal, error, integral, output, pressure;
         struct ldlm_pool *pl = data;
         __u64 slv, clv;
         __u32 limit;
@@ -693,6 +778,11 @@ static int lprocfs_rd_pool_state(char *page, char **start, off_t off,
         grant_speed = grant_rate - cancel_rate;
         lvf = cfs_atomic_read(&pl->pl_lock_volume_factor);
         grant_step = ldlm_pool_t2gsp(pl->pl_recalc_period);
+	goal = pl->pl_slv_goal;
+	error = pl->pl_slv_error;
+	integral = pl->pl_slv_integral;
+	output = pl->pl_slv_output;
+	pressure = pl->pl_mem_pressure;
 	spin_unlock(&pl->pl_lock);
 
         nr += snprintf(page + nr, count - nr, "LDLM pool state (%s):\n",
@@ -706,6 +796,11 @@ static int lprocfs_rd_pool_state(char *page, char **start, off_t off,
                                grant_step);
                 nr += snprintf(page + nr, count - nr, "  GP:  %d\n",
                                grant_plan);
+		nr += snprintf(page + nr, count - nr, "  TG:  %d\n", goal);
+		nr += snprintf(page + nr, count - nr, "  MP:  %d\n", pressure);
+		nr += snprintf(page + nr, count - nr,
+			       "  PID: error %d integral %d output %d\n",
+			       error, integral, output);
         }
         nr += snprintf(page + nr, count - nr, "  GR:  %d\n",
                        grant_rate);
@@ -737,6 +832,81 @@ static int lprocfs_rd_grant_speed(char *page, char **start, off_t off,
 LDLM_POOL_PROC_READER(grant_plan, int);
 LDLM_POOL_PROC_READER(recalc_period, int);
 LDLM_POOL_PROC_WRITER(recalc_period, int);
+LDLM_POOL_PROC_READER(slv_kp, int);
+LDLM_POOL_PROC_READER(slv_ki, int);
+LDLM_POOL_PROC_READER(slv_kd, int);
+LDLM_POOL_PROC_READER(slv_target, int);
+LDLM_POOL_PROC_READER(slv_max_step, int);
+
+/**
+ * Parses an SLV controller tunable from \a buffer and stores it to \a var
+ * under ->pl_lock if it is within [\a min, \a max].
+ */
+static int ldlm_pool_wr_slv_param(struct ldlm_pool *pl, int *var,
+				  const char *buffer, unsigned long count,
+				  int min, int max)
+{
+	int val;
+	int rc;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val < min || val > max)
+		return -ERANGE;
+
+	spin_lock(&pl->pl_lock);
+	*var = val;
+	spin_unlock(&pl->pl_lock);
+
+	return count;
+}
+
+static int lprocfs_wr_slv_kp(struct file *file, const char *buffer,
+			     unsigned long count, void *data)
+{
+	struct ldlm_pool *pl = data;
+
+	return ldlm_pool_wr_slv_param(pl, &pl->pl_slv_kp, buffer, count,
+				      0, LDLM_POOL_SLV_KMAX);
+}
+
+static int lprocfs_wr_slv_ki(struct file *file, const char *buffer,
+			     unsigned long count, void *data)
+{
+	struct ldlm_pool *pl = data;
+
+	return ldlm_pool_wr_slv_param(pl, &pl->pl_slv_ki, buffer, count,
+				      0, LDLM_POOL_SLV_KMAX);
+}
+
+static int lprocfs_wr_slv_kd(struct file *file, const char *buffer,
+			     unsigned long count, void *data)
+{
+	struct ldlm_pool *pl = data;
+
+	return ldlm_pool_wr_slv_param(pl, &pl->pl_slv_kd, buffer, count,
+				      0, LDLM_POOL_SLV_KMAX);
+}
+
+static int lprocfs_wr_slv_target(struct file *file, const char *buffer,
+				 unsigned long count, void *data)
+{
+	struct ldlm_pool *pl = data;
+
+	return ldlm_pool_wr_slv_param(pl, &pl->pl_slv_target, buffer, count,
+				      1, 100);
+}
+
+static int lprocfs_wr_slv_max_step(struct file *file, const char *buffer,
+				   unsigned long count, void *data)
+{
+	struct ldlm_pool *pl = data;
+
+	return ldlm_pool_wr_slv_param(pl, &pl->pl_slv_max_step, buffer, count,
+				      0, (1 << LDLM_POOL_SLV_SHIFT) - 1);
+}
 
 static int ldlm_pool_proc_init(struct ldlm_pool *pl)
 {
@@ -825,6 +995,34 @@ static int ldlm_pool_proc_init(struct ldlm_pool *pl)
         pool_vars[0].read_fptr = lprocfs_rd_pool_state;
         lprocfs_add_vars(pl->pl_proc_dir, pool_vars, 0);
 
+	if (ns_is_server(ns)) {
+		snprintf(var_name, MAX_STRING_SIZE, "slv_kp");
+		pool_vars[0].data = pl;
+		pool_vars[0].read_fptr = lprocfs_rd_slv_kp;
+		pool_vars[0].write_fptr = lprocfs_wr_slv_kp;
+		lprocfs_add_vars(pl->pl_proc_dir, pool_vars, 0);
+
+		snprintf(var_name, MAX_STRING_SIZE, "slv_ki");
+		pool_vars[0].read_fptr = lprocfs_rd_slv_ki;
+		pool_vars[0].write_fptr = lprocfs_wr_slv_ki;
+		lprocfs_add_vars(pl->pl_proc_dir, pool_vars, 0);
+
+		snprintf(var_name, MAX_STRING_SIZE, "slv_kd");
+		pool_vars[0].read_fptr = lprocfs_rd_slv_kd;
+		pool_vars[0].write_fptr = lprocfs_wr_slv_kd;
+		lprocfs_add_vars(pl->pl_proc_dir, pool_vars, 0);
+
+		snprintf(var_name, MAX_STRING_SIZE, "slv_target");
+		pool_vars[0].read_fptr = lprocfs_rd_slv_target;
+		pool_vars[0].write_fptr = lprocfs_wr_slv_target;
+		lprocfs_add_vars(pl->pl_proc_dir, pool_vars, 0);
+
+		snprintf(var_name, MAX_STRING_SIZE, "slv_max_step");
+		pool_vars[0].read_fptr = lprocfs_rd_slv_max_step;
+		pool_vars[0].write_fptr = lprocfs_wr_slv_max_step;
+		lprocfs_add_vars(pl->pl_proc_dir, pool_vars, 0);
+	}
+
         pl->pl_stats = lprocfs_alloc_stats(LDLM_POOL_LAST_STAT -
                                            LDLM_POOL_FIRST_STAT, 0);
         if (!pl->pl_stats)
@@ -910,6 +1108,11 @@ int ldlm_pool_init(struct ldlm_pool *pl, struct ldlm_namespace *ns,
                 ldlm_pool_set_limit(pl, LDLM_POOL_HOST_L);
                 pl->pl_recalc_period = LDLM_POOL_SRV_DEF_RECALC_PERIOD;
                 pl->pl_server_lock_volume = ldlm_pool_slv_max(LDLM_POOL_HOST_L);
+		pl->pl_slv_kp = LDLM_POOL_SLV_KP;
+		pl->pl_slv_ki = LDLM_POOL_SLV_KI;
+		pl->pl_slv_kd = LDLM_POOL_SLV_KD;
+		pl->pl_slv_target = LDLM_POOL_SLV_TARGET;
+		pl->pl_slv_max_step = LDLM_POOL_SLV_MAX_STEP;
         } else {
                 ldlm_pool_set_limit(pl, 1);
                 pl->pl_server_lock_volume = 0;
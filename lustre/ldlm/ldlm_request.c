@@ -433,8 +433,8 @@ int ldlm_cli_enqueue_local(struct ldlm_namespace *ns,
 
 	lock = ldlm_lock_create(ns, res_id, type, mode, &cbs, data, lvb_len,
 				lvb_type);
-        if (unlikely(!lock))
-                GOTO(out_nolock, err = -ENOMEM);
+	if (unlikely(IS_ERR(lock)))
+		GOTO(out_nolock, err = PTR_ERR(lock));
 
         ldlm_lock2handle(lock, lockh);
 
@@ -743,6 +743,98 @@ static inline int ldlm_format_handles_avail(struct obd_import *imp,
         return ldlm_req_handles_avail(size, off);
 }
 
+/**
+ * Deferred cancel batch.
+ *
+ * Locks cancelled with LCF_DEFER are cancelled locally at once, but the
+ * server is not told right away. They are queued on the namespace batch
+ * and their handles are sent with the next request carrying early lock
+ * cancels to the same target (see ldlm_prep_elc_req()), or in one batched
+ * CANCEL RPC when the batch is full or older than LDLM_CANCEL_BATCH_AGE.
+ * E.g. "rm -rf" then sends a few CANCEL RPCs to each OST instead of
+ * getting one blocking AST and sending one CANCEL per object destroyed.
+ */
+static int ldlm_cancel_batch_take(struct ldlm_namespace *ns,
+				  cfs_list_t *cancels, int max)
+{
+	struct ldlm_lock *lock;
+	int count = 0;
+
+	if (ns->ns_cancel_batch_nr == 0)
+		return 0;
+
+	spin_lock(&ns->ns_lock);
+	while (count < max && !cfs_list_empty(&ns->ns_cancel_batch)) {
+		lock = cfs_list_entry(ns->ns_cancel_batch.next,
+				      struct ldlm_lock, l_bl_ast);
+		cfs_list_move_tail(&lock->l_bl_ast, cancels);
+		ns->ns_cancel_batch_nr--;
+		count++;
+	}
+	spin_unlock(&ns->ns_lock);
+
+	return count;
+}
+
+/**
+ * Add \a count locks from \a cancels, already cancelled locally, to the
+ * deferred cancel batch of \a ns. Sends the batch if it became full or too
+ * old. If batching is disabled, the cancels are sent at once.
+ */
+void ldlm_cancel_batch_add(struct ldlm_namespace *ns, cfs_list_t *cancels,
+			   int count)
+{
+	int flush;
+
+	if (count == 0)
+		return;
+
+	spin_lock(&ns->ns_lock);
+	if (ns->ns_cancel_batch_max == 0 || ns->ns_stopping) {
+		spin_unlock(&ns->ns_lock);
+		ldlm_cli_cancel_list(cancels, count, NULL, LCF_ASYNC);
+		return;
+	}
+
+	if (ns->ns_cancel_batch_nr == 0)
+		ns->ns_cancel_batch_time = cfs_time_current();
+	cfs_list_splice_init(cancels, ns->ns_cancel_batch.prev);
+	ns->ns_cancel_batch_nr += count;
+	flush = ns->ns_cancel_batch_nr >= ns->ns_cancel_batch_max;
+	spin_unlock(&ns->ns_lock);
+
+	ldlm_cancel_batch_flush(ns, !flush);
+}
+EXPORT_SYMBOL(ldlm_cancel_batch_add);
+
+/**
+ * Send all deferred cancels of \a ns to the server. If \a aged_only is set,
+ * do that only if the oldest one has waited longer than
+ * LDLM_CANCEL_BATCH_AGE.
+ *
+ * \retval number of lock handles sent
+ */
+int ldlm_cancel_batch_flush(struct ldlm_namespace *ns, int aged_only)
+{
+	CFS_LIST_HEAD(cancels);
+	int count;
+
+	if (ns->ns_cancel_batch_nr == 0)
+		return 0;
+
+	if (aged_only &&
+	    cfs_time_before(cfs_time_current(),
+			    cfs_time_add(ns->ns_cancel_batch_time,
+					 LDLM_CANCEL_BATCH_AGE)))
+		return 0;
+
+	count = ldlm_cancel_batch_take(ns, &cancels, INT_MAX);
+	ldlm_cli_cancel_list(&cancels, count, NULL, LCF_ASYNC);
+
+	return count;
+}
+EXPORT_SYMBOL(ldlm_cancel_batch_flush);
+
 /**
  * Cancel LRU locks and pack them into the enqueue request. Pack there the given
  * \a count locks in \a cancels.
@@ -778,6 +870,11 @@ int ldlm_prep_elc_req(struct obd_export *exp, struct ptlrpc_request *req,
 		/* Cancel LRU locks here _only_ if the server supports
 		 * EARLY_CANCEL. Otherwise we have to send extra CANCEL
 		 * RPC, which will make us slower. */
+		/* Deferred cancels are already done locally, send them
+		 * first, then top up with LRU locks. */
+		if (avail > count)
+			count += ldlm_cancel_batch_take(ns, cancels,
+							avail - count);
                 if (avail > count)
                         count += ldlm_cancel_lru_local(ns, cancels, to_free,
                                                        avail - count, 0, flags);
@@ -892,8 +989,8 @@ int ldlm_cli_enqueue(struct obd_export *exp, struct ptlrpc_request **reqp,
 		lock = ldlm_lock_create(ns, res_id, einfo->ei_type,
 					einfo->ei_mode, &cbs, einfo->ei_cbdata,
 					lvb_len, lvb_type);
-		if (lock == NULL)
-			RETURN(-ENOMEM);
+		if (IS_ERR(lock))
+			RETURN(PTR_ERR(lock));
                 /* for the local lock, add the reference */
                 ldlm_lock_addref_internal(lock, einfo->ei_mode);
                 ldlm_lock2handle(lock, lockh);
@@ -1950,9 +2047,16 @@ int ldlm_cli_cancel_unused_resource(struct ldlm_namespace *ns,
         }
 
         LDLM_RESOURCE_ADDREF(res);
-        count = ldlm_cancel_resource_local(res, &cancels, policy, mode,
-                                           0, flags | LCF_BL_AST, opaque);
-        rc = ldlm_cli_cancel_list(&cancels, count, NULL, flags);
+	count = ldlm_cancel_resource_local(res, &cancels, policy, mode,
+					   flags & LCF_DISCARD_DATA ?
+					   LDLM_FL_DISCARD_DATA : 0,
+					   flags | LCF_BL_AST, opaque);
+	if (flags & LCF_DEFER) {
+		ldlm_cancel_batch_add(ns, &cancels, count);
+		rc = ELDLM_OK;
+	} else {
+		rc = ldlm_cli_cancel_list(&cancels, count, NULL, flags);
+	}
         if (rc != ELDLM_OK)
 		CERROR("canceling unused lock "DLDLMRES": rc = %d\n",
 		       PLDLMRES(res), rc);
@@ -50,6 +50,11 @@
 #include <obd_class.h>
 #include "ldlm_internal.h"
 
+#ifndef __KERNEL__
+# define rcu_read_lock()		do {} while (0)
+# define rcu_read_unlock()		do {} while (0)
+#endif
+
 struct kmem_cache *ldlm_resource_slab, *ldlm_lock_slab;
 
 int ldlm_srv_namespace_nr = 0;
@@ -377,6 +382,20 @@ int ldlm_namespace_proc_register(struct ldlm_namespace *ns)
 		lock_vars[0].read_fptr = lprocfs_rd_elc;
 		lock_vars[0].write_fptr = lprocfs_wr_elc;
 		lprocfs_add_vars(ldlm_ns_proc_dir, lock_vars, 0);
+
+		snprintf(lock_name, MAX_STRING_SIZE, "%s/cancel_batch",
+			 ldlm_ns_name(ns));
+		lock_vars[0].data = &ns->ns_cancel_batch_max;
+		lock_vars[0].read_fptr = lprocfs_rd_uint;
+		lock_vars[0].write_fptr = lprocfs_wr_uint;
+		lprocfs_add_vars(ldlm_ns_proc_dir, lock_vars, 0);
+
+		snprintf(lock_name, MAX_STRING_SIZE, "%s/cancel_batch_count",
+			 ldlm_ns_name(ns));
+		lock_vars[0].data = &ns->ns_cancel_batch_nr;
+		lock_vars[0].read_fptr = lprocfs_rd_uint;
+		lock_vars[0].write_fptr = NULL;
+		lprocfs_add_vars(ldlm_ns_proc_dir, lock_vars, 0);
         } else {
                 snprintf(lock_name, MAX_STRING_SIZE, "%s/ctime_age_limit",
                          ldlm_ns_name(ns));
@@ -641,7 +660,8 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
                                          CFS_HASH_DEPTH |
                                          CFS_HASH_BIGNAME |
                                          CFS_HASH_SPIN_BKTLOCK |
-                                         CFS_HASH_NO_ITEMREF);
+                                         CFS_HASH_NO_ITEMREF |
+                                         CFS_HASH_RCU_LOOKUP);
         if (ns->ns_rs_hash == NULL)
                 GOTO(out_ns, NULL);
 
@@ -657,6 +677,7 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 
 	CFS_INIT_LIST_HEAD(&ns->ns_list_chain);
 	CFS_INIT_LIST_HEAD(&ns->ns_unused_list);
+	CFS_INIT_LIST_HEAD(&ns->ns_cancel_batch);
 	spin_lock_init(&ns->ns_lock);
 	cfs_atomic_set(&ns->ns_bref, 0);
 	init_waitqueue_head(&ns->ns_waitq);
@@ -669,11 +690,20 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
         ns->ns_nr_unused          = 0;
         ns->ns_max_unused         = LDLM_DEFAULT_LRU_SIZE;
         ns->ns_max_age            = LDLM_DEFAULT_MAX_ALIVE;
+	ns->ns_cancel_batch_nr    = 0;
+	ns->ns_cancel_batch_max   = LDLM_DEFAULT_CANCEL_BATCH;
         ns->ns_ctime_age_limit    = LDLM_CTIME_AGE_LIMIT;
         ns->ns_timeouts           = 0;
         ns->ns_orig_connect_flags = 0;
         ns->ns_connect_flags      = 0;
         ns->ns_stopping           = 0;
+	/* POSIX locks are only served by the MDT. */
+	if (!client && ns_type == LDLM_NS_TYPE_MDT) {
+		rc = ldlm_init_flock_wfg(ns);
+		if (rc != 0)
+			GOTO(out_hash, rc);
+	}
+
         rc = ldlm_namespace_proc_register(ns);
         if (rc != 0) {
                 CERROR("Can't initialize ns proc, rc %d\n", rc);
@@ -693,6 +723,7 @@ out_proc:
         ldlm_namespace_proc_unregister(ns);
         ldlm_namespace_cleanup(ns, 0);
 out_hash:
+	ldlm_fini_flock_wfg(ns);
         cfs_hash_putref(ns->ns_rs_hash);
 out_ns:
         OBD_FREE_PTR(ns);
@@ -906,6 +937,10 @@ void ldlm_namespace_free_prior(struct ldlm_namespace *ns,
 	ns->ns_stopping = 1;
 	spin_unlock(&ns->ns_lock);
 
+	/* Deferred cancels hold lock and so resource references. */
+	if (ns_is_client(ns))
+		ldlm_cancel_batch_flush(ns, 0);
+
         /*
          * Can fail with -EINTR when force == 0 in which case try harder.
          */
@@ -947,6 +982,7 @@ void ldlm_namespace_free_post(struct ldlm_namespace *ns)
 	ldlm_pool_fini(&ns->ns_pool);
 
 	ldlm_namespace_proc_unregister(ns);
+	ldlm_fini_flock_wfg(ns);
 	cfs_hash_putref(ns->ns_rs_hash);
 	/* Namespace \a ns should be not on list at this time, otherwise
 	 * this will cause issues related to using freed \a ns in poold
@@ -1089,10 +1125,87 @@ static struct ldlm_resource *ldlm_resource_new(void)
 	return res;
 }
 
+#ifdef __KERNEL__
+static void ldlm_resource_free_rcu(cfs_rcu_head_t *head)
+{
+	struct ldlm_resource *res;
+
+	res = container_of(head, struct ldlm_resource, lr_rcu);
+	OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof(*res));
+}
+#endif
+
+/**
+ * Free a resource which has been removed from the namespace hash.
+ *
+ * ldlm_resource_find_rcu() may still be looking at \a res, so the memory
+ * can only be released after a RCU grace period.
+ */
+static void ldlm_resource_free(struct ldlm_resource *res)
+{
+#ifdef __KERNEL__
+	call_rcu(&res->lr_rcu, ldlm_resource_free_rcu);
+#else
+	OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof(*res));
+#endif
+}
+
+/**
+ * Lockless lookup of an existing resource.
+ *
+ * The namespace hash is walked under rcu_read_lock() instead of the bucket
+ * lock, so concurrent lookups of a hot resource do not bounce the bucket
+ * spinlock between CPUs. A resource whose refcount already dropped to zero
+ * is being removed, NULL is returned and caller falls back to the locked
+ * path.
+ */
+static struct ldlm_resource *
+ldlm_resource_find_rcu(struct ldlm_namespace *ns, cfs_hash_bd_t *bd,
+		       const struct ldlm_res_id *name)
+{
+	cfs_hlist_node_t     *hnode;
+	struct ldlm_resource *res = NULL;
+
+	rcu_read_lock();
+	hnode = cfs_hash_bd_peek_rcu(ns->ns_rs_hash, bd, (void *)name);
+	if (hnode != NULL) {
+		res = cfs_hlist_entry(hnode, struct ldlm_resource, lr_hash);
+		if (!cfs_atomic_inc_not_zero(&res->lr_refcount))
+			res = NULL;
+	}
+	rcu_read_unlock();
+
+	if (res != NULL)
+		CDEBUG(D_INFO, "getref res: %p count: %d\n", res,
+		       cfs_atomic_read(&res->lr_refcount));
+	return res;
+}
+
+/**
+ * Wait until the creator of existing resource \a res is done initializing
+ * its LVB.  Drops the reference and returns NULL if that failed.
+ */
+static struct ldlm_resource *
+ldlm_resource_found(struct ldlm_namespace *ns, struct ldlm_resource *res)
+{
+	/* Synchronize with regard to resource creation. */
+	if (ns->ns_lvbo && ns->ns_lvbo->lvbo_init) {
+		mutex_lock(&res->lr_lvb_mutex);
+		mutex_unlock(&res->lr_lvb_mutex);
+	}
+
+	if (unlikely(res->lr_lvb_len < 0)) {
+		ldlm_resource_putref(res);
+		res = NULL;
+	}
+	return res;
+}
+
 /**
  * Return a reference to resource with given name, creating it if necessary.
  * Args: namespace with ns_lock unlocked
- * Locks: takes and releases NS hash-lock and res->lr_lock
+ * Locks: lookup of an existing resource is lockless (RCU), creation takes
+ *        and releases NS hash-lock
  * Returns: referenced, unlocked ldlm_resource or NULL
  */
 struct ldlm_resource *
@@ -1110,22 +1223,18 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
         LASSERT(ns->ns_rs_hash != NULL);
         LASSERT(name->name[0] != 0);
 
-        cfs_hash_bd_get_and_lock(ns->ns_rs_hash, (void *)name, &bd, 0);
+	/* ns_rs_hash never rehashes, so the bucket of @name is stable */
+	cfs_hash_bd_get(ns->ns_rs_hash, (void *)name, &bd);
+	res = ldlm_resource_find_rcu(ns, &bd, name);
+	if (res != NULL)
+		return ldlm_resource_found(ns, res);
+
+        cfs_hash_bd_lock(ns->ns_rs_hash, &bd, 0);
         hnode = cfs_hash_bd_lookup_locked(ns->ns_rs_hash, &bd, (void *)name);
         if (hnode != NULL) {
                 cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 0);
                 res = cfs_hlist_entry(hnode, struct ldlm_resource, lr_hash);
-		/* Synchronize with regard to resource creation. */
-                if (ns->ns_lvbo && ns->ns_lvbo->lvbo_init) {
-			mutex_lock(&res->lr_lvb_mutex);
-			mutex_unlock(&res->lr_lvb_mutex);
-                }
-
-		if (unlikely(res->lr_lvb_len < 0)) {
-			ldlm_resource_putref(res);
-			res = NULL;
-		}
-                return res;
+                return ldlm_resource_found(ns, res);
         }
 
         version = cfs_hash_bd_version_get(&bd);
@@ -1159,17 +1268,7 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
 		OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
 
 		res = cfs_hlist_entry(hnode, struct ldlm_resource, lr_hash);
-		/* Synchronize with regard to resource creation. */
-		if (ns->ns_lvbo && ns->ns_lvbo->lvbo_init) {
-			mutex_lock(&res->lr_lvb_mutex);
-			mutex_unlock(&res->lr_lvb_mutex);
-		}
-
-		if (unlikely(res->lr_lvb_len < 0)) {
-			ldlm_resource_putref(res);
-			res = NULL;
-		}
-		return res;
+		return ldlm_resource_found(ns, res);
 	}
 	/* We won! Let's add the resource. */
         cfs_hash_bd_add_locked(ns->ns_rs_hash, &bd, &res->lr_hash);
@@ -1267,7 +1366,7 @@ int ldlm_resource_putref(struct ldlm_resource *res)
                 cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
                 if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
                         ns->ns_lvbo->lvbo_free(res);
-                OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+		ldlm_resource_free(res);
                 return 1;
         }
         return 0;
@@ -1297,7 +1396,7 @@ int ldlm_resource_putref_locked(struct ldlm_resource *res)
                  */
                 if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
                         ns->ns_lvbo->lvbo_free(res);
-                OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+		ldlm_resource_free(res);
 
                 cfs_hash_bd_lock(ns->ns_rs_hash, &bd, 1);
                 return 1;
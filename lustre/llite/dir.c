@@ -808,37 +808,18 @@ end:
 	RETURN(rc);
 }
 
-int ll_dir_getstripe(struct inode *inode, struct lov_mds_md **lmmp,
-                     int *lmm_size, struct ptlrpc_request **request)
+/**
+ * Get the default striping of a directory out of the reply \a req to the
+ * getattr of OBD_MD_FLEASIZE | OBD_MD_FLDIREA.
+ */
+int ll_dir_getstripe_reply(struct ptlrpc_request *req,
+			   struct lov_mds_md **lmmp, int *lmm_size)
 {
-        struct ll_sb_info *sbi = ll_i2sbi(inode);
         struct mdt_body   *body;
         struct lov_mds_md *lmm = NULL;
-        struct ptlrpc_request *req = NULL;
-        int rc, lmmsize;
-        struct md_op_data *op_data;
+        int rc = 0, lmmsize;
 	ENTRY;
 
-	rc = ll_get_default_mdsize(sbi, &lmmsize);
-	if (rc)
-		RETURN(rc);
-
-        op_data = ll_prep_md_op_data(NULL, inode, NULL, NULL,
-                                     0, lmmsize, LUSTRE_OPC_ANY,
-                                     NULL);
-        if (IS_ERR(op_data))
-                RETURN(PTR_ERR(op_data));
-
-        op_data->op_valid = OBD_MD_FLEASIZE | OBD_MD_FLDIREA;
-        rc = md_getattr(sbi->ll_md_exp, op_data, &req);
-        ll_finish_md_op_data(op_data);
-        if (rc < 0) {
-                CDEBUG(D_INFO, "md_getattr failed on inode "
-                       "%lu/%u: rc %d\n", inode->i_ino,
-                       inode->i_generation, rc);
-                GOTO(out, rc);
-        }
-
         body = req_capsule_server_get(&req->rq_pill, &RMF_MDT_BODY);
         LASSERT(body != NULL);
 
@@ -872,6 +853,43 @@ int ll_dir_getstripe(struct inode *inode, struct lov_mds_md **lmmp,
                 CERROR("unknown magic: %lX\n", (unsigned long)lmm->lmm_magic);
                 rc = -EPROTO;
         }
+out:
+        *lmmp = lmm;
+        *lmm_size = lmmsize;
+        RETURN(rc);
+}
+
+int ll_dir_getstripe(struct inode *inode, struct lov_mds_md **lmmp,
+                     int *lmm_size, struct ptlrpc_request **request)
+{
+        struct ll_sb_info *sbi = ll_i2sbi(inode);
+        struct lov_mds_md *lmm = NULL;
+        struct ptlrpc_request *req = NULL;
+        int rc, lmmsize;
+        struct md_op_data *op_data;
+	ENTRY;
+
+	rc = ll_get_default_mdsize(sbi, &lmmsize);
+	if (rc)
+		RETURN(rc);
+
+        op_data = ll_prep_md_op_data(NULL, inode, NULL, NULL,
+                                     0, lmmsize, LUSTRE_OPC_ANY,
+                                     NULL);
+        if (IS_ERR(op_data))
+                RETURN(PTR_ERR(op_data));
+
+        op_data->op_valid = OBD_MD_FLEASIZE | OBD_MD_FLDIREA;
+        rc = md_getattr(sbi->ll_md_exp, op_data, &req);
+        ll_finish_md_op_data(op_data);
+        if (rc < 0) {
+                CDEBUG(D_INFO, "md_getattr failed on inode "
+                       "%lu/%u: rc %d\n", inode->i_ino,
+                       inode->i_generation, rc);
+                GOTO(out, rc);
+        }
+
+	rc = ll_dir_getstripe_reply(req, &lmm, &lmmsize);
 out:
         *lmmp = lmm;
         *lmm_size = lmmsize;
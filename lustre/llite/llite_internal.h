@@ -841,6 +841,8 @@ int ll_lov_getstripe_ea_info(struct inode *inode, const char *filename,
                              struct ptlrpc_request **request);
 int ll_dir_setstripe(struct inode *inode, struct lov_user_md *lump,
                      int set_default);
+int ll_dir_getstripe_reply(struct ptlrpc_request *req,
+			   struct lov_mds_md **lmmp, int *lmm_size);
 int ll_dir_getstripe(struct inode *inode, struct lov_mds_md **lmmp,
                      int *lmm_size, struct ptlrpc_request **request);
 #ifdef HAVE_FILE_FSYNC_4ARGS
@@ -1242,6 +1242,42 @@ out:
 	return rc;
 }
 
+/* Cancel unused OST locks of a regular file whose last link was removed by
+ * the successful unlink or rename \a request, so the OSTs need not send a
+ * blocking AST for each of them when the MDT destroys the objects. As with
+ * the destroy AST, cached pages are discarded rather than written back. The
+ * CANCEL RPCs are batched with those of other unlinked files, see
+ * ldlm_cancel_batch_add(). */
+static void ll_unlink_cancel_dt_locks(struct inode *inode,
+				      struct ptlrpc_request *request)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct lov_stripe_md *lsm;
+	struct mdt_body *body;
+
+	if (!S_ISREG(inode->i_mode))
+		return;
+
+	/* The reply carries the attributes of the unlinked object. */
+	body = req_capsule_server_get(&request->rq_pill, &RMF_MDT_BODY);
+	if (body == NULL || !(body->valid & OBD_MD_FLNLINK) ||
+	    body->nlink != 0 || !lu_fid_eq(&body->fid1, ll_inode2fid(inode)))
+		return;
+
+	/* Keep the locks for local users of an open-unlinked file. */
+	if (lli->lli_open_fd_read_count || lli->lli_open_fd_write_count ||
+	    lli->lli_open_fd_exec_count)
+		return;
+
+	lsm = ccc_inode_lsm_get(inode);
+	if (lsm == NULL)
+		return;
+
+	obd_cancel_unused(ll_i2dtexp(inode), lsm,
+			  LCF_DEFER | LCF_DISCARD_DATA, NULL);
+	ccc_inode_lsm_put(inode, lsm);
+}
+
 /* ll_unlink_generic() doesn't update the inode with the new link count.
  * Instead, ll_ddelete() and ll_d_iput() will update it based upon if there
  * is any lock existing. They will recycle dentries and inodes based upon locks
@@ -1279,6 +1315,8 @@ static int ll_unlink_generic(struct inode *dir, struct dentry *dparent,
 
         ll_update_times(request, dir);
         ll_stats_ops_tally(ll_i2sbi(dir), LPROC_LL_UNLINK, 1);
+	if (dchild != NULL && dchild->d_inode != NULL)
+		ll_unlink_cancel_dt_locks(dchild->d_inode, request);
 
         rc = ll_objects_destroy(request, dir);
  out:
@@ -1323,6 +1361,9 @@ static int ll_rename_generic(struct inode *src, struct dentry *src_dparent,
                 ll_update_times(request, src);
                 ll_update_times(request, tgt);
                 ll_stats_ops_tally(sbi, LPROC_LL_RENAME, 1);
+		if (tgt_dchild != NULL && tgt_dchild->d_inode != NULL)
+			ll_unlink_cancel_dt_locks(tgt_dchild->d_inode,
+						  request);
                 err = ll_objects_destroy(request, src);
         }
 
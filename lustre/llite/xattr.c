@@ -284,15 +284,46 @@ int ll_removexattr(struct dentry *dentry, const char *name)
                                   OBD_MD_FLXATTRRM);
 }
 
+/* copy the value carried by getxattr reply \a req into \a buffer */
+static int ll_getxattr_reply(struct ptlrpc_request *req, void *buffer,
+			     size_t size)
+{
+	struct mdt_body *body;
+	void *xdata;
+
+	body = req_capsule_server_get(&req->rq_pill, &RMF_MDT_BODY);
+	LASSERT(body);
+
+	/* only detect the xattr size */
+	if (size == 0)
+		return body->eadatasize;
+
+	if (size < body->eadatasize) {
+		CERROR("server bug: replied size %u > %u\n",
+			body->eadatasize, (int)size);
+		return -ERANGE;
+	}
+
+	if (body->eadatasize == 0)
+		return -ENODATA;
+
+	/* do not need swab xattr data */
+	xdata = req_capsule_server_sized_get(&req->rq_pill, &RMF_EADATA,
+						body->eadatasize);
+	if (!xdata)
+		return -EFAULT;
+
+	memcpy(buffer, xdata, body->eadatasize);
+	return body->eadatasize;
+}
+
 static
 int ll_getxattr_common(struct inode *inode, const char *name,
                        void *buffer, size_t size, __u64 valid)
 {
         struct ll_sb_info *sbi = ll_i2sbi(inode);
         struct ptlrpc_request *req = NULL;
-        struct mdt_body *body;
         int xattr_type, rc;
-        void *xdata;
         struct obd_capa *oc;
         struct rmtacl_ctl_entry *rce = NULL;
 	struct ll_inode_info *lli = ll_i2info(inode);
@@ -393,30 +424,9 @@ getxattr_nocache:
 		if (rc < 0)
 			GOTO(out_xattr, rc);
 
-		body = req_capsule_server_get(&req->rq_pill, &RMF_MDT_BODY);
-		LASSERT(body);
-
-		/* only detect the xattr size */
-		if (size == 0)
-			GOTO(out, rc = body->eadatasize);
-
-		if (size < body->eadatasize) {
-			CERROR("server bug: replied size %u > %u\n",
-				body->eadatasize, (int)size);
-			GOTO(out, rc = -ERANGE);
-		}
-
-		if (body->eadatasize == 0)
-			GOTO(out, rc = -ENODATA);
-
-		/* do not need swab xattr data */
-		xdata = req_capsule_server_sized_get(&req->rq_pill, &RMF_EADATA,
-							body->eadatasize);
-		if (!xdata)
-			GOTO(out, rc = -EFAULT);
-
-		memcpy(buffer, xdata, body->eadatasize);
-		rc = body->eadatasize;
+		rc = ll_getxattr_reply(req, buffer, size);
+		if (rc < 0 || size == 0)
+			GOTO(out, rc);
 	}
 
 #ifdef CONFIG_FS_POSIX_ACL
@@ -530,27 +540,82 @@ out:
         return ll_getxattr_common(inode, name, buffer, size, OBD_MD_FLXATTR);
 }
 
+/*
+ * Without the xattr cache, listing the xattrs of a directory takes a
+ * getxattr for the names and a getattr for the default striping, listed as
+ * lustre.lov.  Get both in one compound RPC, the result of the getattr is
+ * returned in \a stripe_rc.
+ */
+static int ll_dir_listxattr(struct inode *inode, char *buffer, size_t size,
+			    int *stripe_rc)
+{
+	struct ll_sb_info	*sbi = ll_i2sbi(inode);
+	struct ptlrpc_request	*req;
+	struct ptlrpc_request	*xattr_req;
+	struct md_op_data	*op_data;
+	struct lov_mds_md	*lmm;
+	int			 lmmsize;
+	int			 rc;
+	ENTRY;
+
+	rc = ll_get_default_mdsize(sbi, &lmmsize);
+	if (rc)
+		RETURN(rc);
+
+	op_data = ll_prep_md_op_data(NULL, inode, NULL, NULL, 0, lmmsize,
+				     LUSTRE_OPC_ANY, NULL);
+	if (IS_ERR(op_data))
+		RETURN(PTR_ERR(op_data));
+
+	op_data->op_valid = OBD_MD_FLEASIZE | OBD_MD_FLDIREA;
+	rc = md_getattr_xattr(sbi->ll_md_exp, op_data, OBD_MD_FLXATTRLS, NULL,
+			      size, &req, &xattr_req);
+	ll_finish_md_op_data(op_data);
+	if (rc)
+		RETURN(rc);
+
+	*stripe_rc = req->rq_status;
+	if (*stripe_rc == 0)
+		*stripe_rc = ll_dir_getstripe_reply(req, &lmm, &lmmsize);
+
+	rc = xattr_req->rq_status;
+	if (rc == 0)
+		rc = ll_getxattr_reply(xattr_req, buffer, size);
+
+	ptlrpc_req_finished(xattr_req);
+	ptlrpc_req_finished(req);
+	RETURN(rc);
+}
+
 ssize_t ll_listxattr(struct dentry *dentry, char *buffer, size_t size)
 {
         struct inode *inode = dentry->d_inode;
+	struct ll_sb_info *sbi;
         int rc = 0, rc2 = 0;
+	int stripe_rc = 0;
         struct lov_mds_md *lmm = NULL;
         struct ptlrpc_request *request = NULL;
         int lmmsize;
+	bool batched;
 
         LASSERT(inode);
 
         CDEBUG(D_VFSTRACE, "VFS Op:inode=%lu/%u(%p)\n",
                inode->i_ino, inode->i_generation, inode);
 
-        ll_stats_ops_tally(ll_i2sbi(inode), LPROC_LL_LISTXATTR, 1);
+	sbi = ll_i2sbi(inode);
+	ll_stats_ops_tally(sbi, LPROC_LL_LISTXATTR, 1);
 
-        rc = ll_getxattr_common(inode, NULL, buffer, size, OBD_MD_FLXATTRLS);
+	batched = S_ISDIR(inode->i_mode) && !sbi->ll_xattr_cache_enabled;
+	if (batched)
+		rc = ll_dir_listxattr(inode, buffer, size, &stripe_rc);
+	else
+		rc = ll_getxattr_common(inode, NULL, buffer, size,
+					OBD_MD_FLXATTRLS);
         if (rc < 0)
                 GOTO(out, rc);
 
 	if (buffer != NULL) {
-		struct ll_sb_info *sbi = ll_i2sbi(inode);
 		char *xattr_name = buffer;
 		int xlen, rem = rc;
 
@@ -575,6 +640,8 @@ ssize_t ll_listxattr(struct dentry *dentry, char *buffer, size_t size)
 	if (S_ISREG(inode->i_mode)) {
 		if (!ll_i2info(inode)->lli_has_smd)
                         rc2 = -1;
+	} else if (batched) {
+		rc2 = stripe_rc;
         } else if (S_ISDIR(inode->i_mode)) {
                 rc2 = ll_dir_getstripe(inode, &lmm, &lmmsize, &request);
         }
@@ -1648,6 +1648,31 @@ static int lmv_getattr(struct obd_export *exp, struct md_op_data *op_data,
         RETURN(rc);
 }
 
+static int lmv_getattr_xattr(struct obd_export *exp,
+			     struct md_op_data *op_data,
+			     obd_valid xattr_valid, const char *xattr_name,
+			     int xattr_size, struct ptlrpc_request **request,
+			     struct ptlrpc_request **xattr_req)
+{
+	struct obd_device	*obd = exp->exp_obd;
+	struct lmv_obd		*lmv = &obd->u.lmv;
+	struct lmv_tgt_desc	*tgt;
+	int			 rc;
+	ENTRY;
+
+	rc = lmv_check_connect(obd);
+	if (rc)
+		RETURN(rc);
+
+	tgt = lmv_find_target(lmv, &op_data->op_fid1);
+	if (IS_ERR(tgt))
+		RETURN(PTR_ERR(tgt));
+
+	rc = md_getattr_xattr(tgt->ltd_exp, op_data, xattr_valid, xattr_name,
+			      xattr_size, request, xattr_req);
+	RETURN(rc);
+}
+
 static int lmv_null_inode(struct obd_export *exp, const struct lu_fid *fid)
 {
         struct obd_device   *obd = exp->exp_obd;
@@ -2964,6 +2989,7 @@ struct md_ops lmv_md_ops = {
         .m_enqueue              = lmv_enqueue,
         .m_getattr              = lmv_getattr,
         .m_getxattr             = lmv_getxattr,
+	.m_getattr_xattr	= lmv_getattr_xattr,
         .m_getattr_name         = lmv_getattr_name,
         .m_intent_lock          = lmv_intent_lock,
         .m_link                 = lmv_link,
@@ -104,6 +104,8 @@ static struct lprocfs_vars lprocfs_mdc_obd_vars[] = {
         { "state",           lprocfs_rd_state,       0, 0 },
         { "pinger_recov",    lprocfs_rd_pinger_recov,
                              lprocfs_wr_pinger_recov, 0, 0 },
+	{ "idle_timeout",    lprocfs_rd_idle_timeout,
+			     lprocfs_wr_idle_timeout, 0, 0 },
         { 0 }
 };
 
@@ -169,20 +169,14 @@ int mdc_getstatus(struct obd_export *exp, struct lu_fid *rootfid,
  * of fields. This issue will be fixed later when client gets aware of RPC
  * layouts.  --umka
  */
-static int mdc_getattr_common(struct obd_export *exp,
-                              struct ptlrpc_request *req)
+static int mdc_getattr_reply(struct obd_export *exp,
+			     struct ptlrpc_request *req)
 {
         struct req_capsule *pill = &req->rq_pill;
         struct mdt_body    *body;
         void               *eadata;
-        int                 rc;
         ENTRY;
 
-        /* Request message already built. */
-        rc = ptlrpc_queue_wait(req);
-        if (rc != 0)
-                RETURN(rc);
-
         /* sanity check for the reply */
         body = req_capsule_server_get(pill, &RMF_MDT_BODY);
         if (body == NULL)
@@ -218,18 +212,26 @@ static int mdc_getattr_common(struct obd_export *exp,
         RETURN(0);
 }
 
-int mdc_getattr(struct obd_export *exp, struct md_op_data *op_data,
-                struct ptlrpc_request **request)
+static int mdc_getattr_common(struct obd_export *exp,
+                              struct ptlrpc_request *req)
+{
+        int rc;
+
+        /* Request message already built. */
+        rc = ptlrpc_queue_wait(req);
+        if (rc != 0)
+                return rc;
+
+        return mdc_getattr_reply(exp, req);
+}
+
+static int mdc_getattr_prep(struct obd_export *exp, struct md_op_data *op_data,
+			    struct ptlrpc_request **request)
 {
         struct ptlrpc_request *req;
         int                    rc;
         ENTRY;
 
-	/* Single MDS without an LMV case */
-	if (op_data->op_flags & MF_GET_MDT_IDX) {
-		op_data->op_mds = 0;
-		RETURN(0);
-	}
         *request = NULL;
         req = ptlrpc_request_alloc(class_exp2cliimp(exp), &RQF_MDS_GETATTR);
         if (req == NULL)
@@ -255,6 +257,28 @@ int mdc_getattr(struct obd_export *exp, struct md_op_data *op_data,
         }
         ptlrpc_request_set_replen(req);
 
+	*request = req;
+	RETURN(0);
+}
+
+int mdc_getattr(struct obd_export *exp, struct md_op_data *op_data,
+                struct ptlrpc_request **request)
+{
+        struct ptlrpc_request *req;
+        int                    rc;
+        ENTRY;
+
+	/* Single MDS without an LMV case */
+	if (op_data->op_flags & MF_GET_MDT_IDX) {
+		op_data->op_mds = 0;
+		RETURN(0);
+	}
+
+        *request = NULL;
+	rc = mdc_getattr_prep(exp, op_data, &req);
+	if (rc)
+		RETURN(rc);
+
         rc = mdc_getattr_common(exp, req);
         if (rc)
                 ptlrpc_req_finished(req);
@@ -309,6 +333,86 @@ int mdc_getattr_name(struct obd_export *exp, struct md_op_data *op_data,
         RETURN(rc);
 }
 
+static int mdc_batch_send(struct obd_export *exp,
+			  struct ptlrpc_request **subs, int count)
+{
+	struct ptlrpc_request *req;
+	int		       rc;
+	ENTRY;
+
+	req = ptlrpc_request_alloc(class_exp2cliimp(exp), &RQF_MDS_BATCH);
+	if (req == NULL)
+		RETURN(-ENOMEM);
+
+	ptlrpc_batch_set_size(req, subs, count);
+	rc = ptlrpc_request_pack(req, LUSTRE_MDS_VERSION, MDS_BATCH);
+	if (rc) {
+		ptlrpc_request_free(req);
+		RETURN(rc);
+	}
+
+	ptlrpc_batch_pack(req, subs, count);
+	ptlrpc_request_set_replen(req);
+	/* see mdc_batch() */
+	req->rq_no_resend = 1;
+
+	rc = mdc_queue_wait(req);
+	if (rc == 0)
+		rc = ptlrpc_batch_unpack(req, subs, count);
+	ptlrpc_req_finished(req);
+	RETURN(rc);
+}
+
+/**
+ * Send the \a count packed, but not yet sent, requests \a subs to the MDT
+ * of \a exp in one compound MDS_BATCH RPC, saving a round trip per request
+ * for a series of independent lookups.  The MDT handles them one after the
+ * other in a single service thread; the reply of each one is unpacked into
+ * it and its result is in its rq_status.
+ *
+ * The compound RPC is never resent nor replayed, the MDT could not
+ * reconstruct the replies of its sub-requests.  If it fails, the
+ * sub-requests are sent one by one instead, each with the usual recovery.
+ * So only requests which do not change the file system may be batched.
+ * Requests are also sent one by one to an MDT without compound RPC support.
+ */
+static int mdc_batch(struct obd_export *exp, struct ptlrpc_request **subs,
+		     int count)
+{
+	int rc;
+	int i;
+	ENTRY;
+
+	if (count <= 0 || count > BATCH_MAX_OPS)
+		RETURN(-EINVAL);
+
+	for (i = 0; i < count; i++) {
+		switch (lustre_msg_get_opc(subs[i]->rq_reqmsg)) {
+		case MDS_GETATTR:
+		case MDS_GETATTR_NAME:
+		case MDS_GETXATTR:
+		case MDS_STATFS:
+			break;
+		default:
+			RETURN(-EINVAL);
+		}
+	}
+
+	if (count > 1 &&
+	    (exp_connect_flags2(exp) & OBD_CONNECT2_BATCH_RPCS)) {
+		rc = mdc_batch_send(exp, subs, count);
+		if (rc == 0)
+			RETURN(0);
+		CDEBUG(D_HA, "%s: compound RPC of %d requests failed, "
+		       "sending them one by one: rc = %d\n",
+		       exp->exp_obd->obd_name, count, rc);
+	}
+
+	for (i = 0; i < count; i++)
+		subs[i]->rq_status = mdc_queue_wait(subs[i]);
+	RETURN(0);
+}
+
 static int mdc_is_subdir(struct obd_export *exp,
                          const struct lu_fid *pfid,
                          const struct lu_fid *cfid,
@@ -337,12 +441,12 @@ static int mdc_is_subdir(struct obd_export *exp,
         RETURN(rc);
 }
 
-static int mdc_xattr_common(struct obd_export *exp,const struct req_format *fmt,
-                            const struct lu_fid *fid,
-                            struct obd_capa *oc, int opcode, obd_valid valid,
-                            const char *xattr_name, const char *input,
-                            int input_size, int output_size, int flags,
-                            __u32 suppgid, struct ptlrpc_request **request)
+static int mdc_xattr_prep(struct obd_export *exp, const struct req_format *fmt,
+			  const struct lu_fid *fid,
+			  struct obd_capa *oc, int opcode, obd_valid valid,
+			  const char *xattr_name, const char *input,
+			  int input_size, int output_size, int flags,
+			  __u32 suppgid, struct ptlrpc_request **request)
 {
         struct ptlrpc_request *req;
         int   xattr_namelen = 0;
@@ -432,6 +536,28 @@ static int mdc_xattr_common(struct obd_export *exp,const struct req_format *fmt,
                                      RCL_SERVER, output_size);
         ptlrpc_request_set_replen(req);
 
+	*request = req;
+	RETURN(0);
+}
+
+static int mdc_xattr_common(struct obd_export *exp,const struct req_format *fmt,
+                            const struct lu_fid *fid,
+                            struct obd_capa *oc, int opcode, obd_valid valid,
+                            const char *xattr_name, const char *input,
+                            int input_size, int output_size, int flags,
+                            __u32 suppgid, struct ptlrpc_request **request)
+{
+        struct ptlrpc_request *req;
+        int   rc;
+        ENTRY;
+
+	*request = NULL;
+	rc = mdc_xattr_prep(exp, fmt, fid, oc, opcode, valid, xattr_name,
+			    input, input_size, output_size, flags, suppgid,
+			    &req);
+	if (rc)
+		RETURN(rc);
+
         /* make rpc */
         if (opcode == MDS_REINT)
                 mdc_get_rpc_lock(exp->exp_obd->u.cli.cl_rpc_lock, NULL);
@@ -470,6 +596,53 @@ int mdc_getxattr(struct obd_export *exp, const struct lu_fid *fid,
                                 -1, request);
 }
 
+/**
+ * Get the attributes of op_data->op_fid1 as mdc_getattr() does, together
+ * with its extended attribute \a xattr_name as mdc_getxattr() does, in a
+ * single compound RPC when the MDT supports it.
+ *
+ * On success both replies are returned, in \a request and \a xattr_req,
+ * and the result of each operation is in the rq_status of its request.
+ */
+int mdc_getattr_xattr(struct obd_export *exp, struct md_op_data *op_data,
+		      obd_valid xattr_valid, const char *xattr_name,
+		      int xattr_size, struct ptlrpc_request **request,
+		      struct ptlrpc_request **xattr_req)
+{
+	struct ptlrpc_request *subs[2];
+	int		       rc;
+	ENTRY;
+
+	*request = NULL;
+	*xattr_req = NULL;
+
+	rc = mdc_getattr_prep(exp, op_data, &subs[0]);
+	if (rc)
+		RETURN(rc);
+
+	rc = mdc_xattr_prep(exp, &RQF_MDS_GETXATTR, &op_data->op_fid1,
+			    op_data->op_capa1, MDS_GETXATTR, xattr_valid,
+			    xattr_name, NULL, 0, xattr_size, 0, -1, &subs[1]);
+	if (rc) {
+		ptlrpc_req_finished(subs[0]);
+		RETURN(rc);
+	}
+
+	rc = mdc_batch(exp, subs, ARRAY_SIZE(subs));
+	if (rc) {
+		ptlrpc_req_finished(subs[0]);
+		ptlrpc_req_finished(subs[1]);
+		RETURN(rc);
+	}
+
+	if (subs[0]->rq_status == 0)
+		subs[0]->rq_status = mdc_getattr_reply(exp, subs[0]);
+
+	*request = subs[0];
+	*xattr_req = subs[1];
+	RETURN(0);
+}
+
 #ifdef CONFIG_FS_POSIX_ACL
 static int mdc_unpack_acl(struct ptlrpc_request *req, struct lustre_md *md)
 {
@@ -2832,6 +3005,7 @@ struct md_ops mdc_md_ops = {
         .m_setattr          = mdc_setattr,
         .m_setxattr         = mdc_setxattr,
         .m_getxattr         = mdc_getxattr,
+	.m_getattr_xattr    = mdc_getattr_xattr,
 	.m_fsync	    = mdc_fsync,
         .m_readpage         = mdc_readpage,
         .m_unlink           = mdc_unlink,
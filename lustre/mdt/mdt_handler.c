@@ -3458,6 +3458,7 @@ static int mdt_msg_check_version(struct lustre_msg *msg)
         case MDS_QUOTACTL:
 	case UPDATE_OBJ:
 	case MDS_SWAP_LAYOUTS:
+	case MDS_BATCH:
         case QUOTA_DQACQ:
         case QUOTA_DQREL:
         case SEQ_QUERY:
@@ -3580,6 +3581,84 @@ int mdt_handle_common(struct ptlrpc_request *req,
         RETURN(rc);
 }
 
+/*
+ * Compound MDS_BATCH RPC: handle the sub-requests one after the other in
+ * this service thread, each one as if it had arrived on its own, and pack
+ * their replies into the reply of the compound request.
+ *
+ * Only the handlers of mdt_batch_handlers[] are reachable that way: those
+ * neither change the file system nor save locks in their reply, since the
+ * reply of a sub-request can be neither reconstructed nor replayed.  For the
+ * same reason clients never resend a compound request, but send its
+ * sub-requests one by one instead, see mdc_batch().
+ */
+int mdt_batch(struct mdt_thread_info *info)
+{
+	struct ptlrpc_request	*req = mdt_info_req(info);
+	struct ptlrpc_request	*subs[BATCH_MAX_OPS];
+	struct batch_buf	*bb;
+	__u32			 lens[BATCH_MAX_OPS];
+	int			 count;
+	int			 nr;
+	int			 rc;
+	int			 i;
+	ENTRY;
+
+	if (lustre_msg_get_flags(req->rq_reqmsg) & (MSG_RESENT | MSG_REPLAY)) {
+		DEBUG_REQ(D_ERROR, req, "compound request cannot be resent");
+		RETURN(err_serious(-EPROTO));
+	}
+
+	bb = req_capsule_client_get(info->mti_pill, &RMF_BATCH_BUF);
+	if (bb == NULL)
+		RETURN(err_serious(-EPROTO));
+
+	rc = lustre_batch_buf_check(bb, req_capsule_get_size(info->mti_pill,
+							     &RMF_BATCH_BUF,
+							     RCL_CLIENT),
+				    ptlrpc_req_need_swab(req));
+	if (rc)
+		RETURN(err_serious(rc));
+	count = bb->bb_count;
+
+	/* the sub-requests take the thread info over in turn */
+	mdt_thread_info_fini(info);
+	for (nr = 0; nr < count; nr++) {
+		subs[nr] = ptlrpc_batch_sub_init(req, bb, nr);
+		if (IS_ERR(subs[nr])) {
+			rc = PTR_ERR(subs[nr]);
+			break;
+		}
+
+		mdt_handle_common(subs[nr], mdt_batch_handlers);
+		/* no reply if a fail_loc dropped it */
+		lens[nr] = subs[nr]->rq_repmsg != NULL ? subs[nr]->rq_replen : 0;
+	}
+	mdt_thread_info_init(req, info);
+
+	if (rc == 0) {
+		req_capsule_set_size(info->mti_pill, &RMF_BATCH_REPLY,
+				     RCL_SERVER,
+				     lustre_batch_buf_size(count, lens));
+		rc = req_capsule_server_pack(info->mti_pill);
+	}
+
+	if (rc == 0) {
+		bb = req_capsule_server_get(info->mti_pill, &RMF_BATCH_REPLY);
+		LASSERT(bb != NULL);
+
+		lustre_batch_buf_init(bb, count);
+		for (i = 0; i < count; i++)
+			lustre_batch_buf_add(bb, i, subs[i]->rq_repmsg,
+					     lens[i]);
+	}
+
+	for (i = 0; i < nr; i++)
+		ptlrpc_batch_sub_fini(subs[i]);
+
+	RETURN(rc ? err_serious(rc) : 0);
+}
+
 /*
  * This is called from recovery code as handler of _all_ RPC types, FLD and SEQ
  * as well.
@@ -5475,6 +5554,8 @@ static int mdt_connect_internal(struct obd_export *exp,
 	LASSERT(data != NULL);
 
 	data->ocd_connect_flags &= MDT_CONNECT_SUPPORTED;
+	if (data->ocd_connect_flags & OBD_CONNECT_FLAGS2)
+		data->ocd_connect_flags2 &= MDT_CONNECT_SUPPORTED2;
 	data->ocd_ibits_known &= MDS_INODELOCK_FULL;
 
 	/* If no known bits (which should not happen, probably,
@@ -875,12 +875,14 @@ int mdt_llog_prev_block(struct mdt_thread_info *info);
 int mdt_sec_ctx_handle(struct mdt_thread_info *info);
 int mdt_readpage(struct mdt_thread_info *info);
 int mdt_obd_idx_read(struct mdt_thread_info *info);
+int mdt_batch(struct mdt_thread_info *info);
 int mdt_tgt_connect(struct tgt_session_info *tsi);
 void mdt_thread_info_init(struct ptlrpc_request *req,
 			  struct mdt_thread_info *mti);
 void mdt_thread_info_fini(struct mdt_thread_info *mti);
 
 extern struct mdt_opc_slice mdt_regular_handlers[];
+extern struct mdt_opc_slice mdt_batch_handlers[];
 extern struct mdt_opc_slice mdt_seq_handlers[];
 extern struct mdt_opc_slice mdt_fld_handlers[];
 
@@ -152,6 +152,7 @@ DEF_MDT_HDL(HABEO_CORPUS | HABEO_REFERO, MDS_HSM_ACTION, mdt_hsm_action),
 DEF_MDT_HDL(HABEO_CORPUS | HABEO_REFERO, MDS_HSM_REQUEST, mdt_hsm_request),
 DEF_MDT_HDL(HABEO_CORPUS | HABEO_REFERO | MUTABOR, MDS_SWAP_LAYOUTS,
 	    mdt_swap_layouts),
+DEF_MDT_HDL(0,				MDS_BATCH,	  mdt_batch),
 };
 
 #define DEF_OBD_HDL(flags, name, fn)					\
@@ -243,6 +244,26 @@ struct mdt_opc_slice mdt_regular_handlers[] = {
 	}
 };
 
+/* Requests which may be sent inside a compound MDS_BATCH RPC, see
+ * mdt_batch() */
+static struct mdt_handler mdt_batch_ops[] = {
+DEF_MDT_HDL(HABEO_CORPUS,		MDS_GETATTR,	  mdt_getattr),
+DEF_MDT_HDL(HABEO_CORPUS| HABEO_REFERO,	MDS_GETATTR_NAME, mdt_getattr_name),
+DEF_MDT_HDL(HABEO_CORPUS,		MDS_GETXATTR,	  mdt_getxattr),
+DEF_MDT_HDL(0		| HABEO_REFERO,	MDS_STATFS,	  mdt_statfs),
+};
+
+struct mdt_opc_slice mdt_batch_handlers[] = {
+	{
+		.mos_opc_start	= MDS_GETATTR,
+		.mos_opc_end	= MDS_STATFS + 1,
+		.mos_hs		= mdt_batch_ops
+	},
+	{
+		.mos_hs		= NULL
+	}
+};
+
 /* Readpage/readdir handlers */
 static struct mdt_handler mdt_readpage_ops[] = {
 DEF_MDT_HDL(0,			MDS_CONNECT,  mdt_connect),
@@ -778,6 +778,7 @@ static void class_export_destroy(struct obd_export *exp)
 
         LASSERT(cfs_list_empty(&exp->exp_outstanding_replies));
         LASSERT(cfs_list_empty(&exp->exp_uncommitted_replies));
+	LASSERT(cfs_list_empty(&exp->exp_commit_list));
         LASSERT(cfs_list_empty(&exp->exp_req_replay_queue));
         LASSERT(cfs_list_empty(&exp->exp_hp_rpcs));
         obd_destroy_export(exp);
@@ -843,7 +844,6 @@ struct obd_export *class_new_export(struct obd_device *obd,
 
         export->exp_conn_cnt = 0;
         export->exp_lock_hash = NULL;
-	export->exp_flock_hash = NULL;
         cfs_atomic_set(&export->exp_refcount, 2);
         cfs_atomic_set(&export->exp_rpc_count, 0);
         cfs_atomic_set(&export->exp_cb_count, 0);
@@ -857,6 +857,7 @@ struct obd_export *class_new_export(struct obd_device *obd,
 	CFS_INIT_LIST_HEAD(&export->exp_outstanding_replies);
 	spin_lock_init(&export->exp_uncommitted_replies_lock);
 	CFS_INIT_LIST_HEAD(&export->exp_uncommitted_replies);
+	CFS_INIT_LIST_HEAD(&export->exp_commit_list);
 	CFS_INIT_LIST_HEAD(&export->exp_req_replay_queue);
 	CFS_INIT_LIST_HEAD(&export->exp_handle.h_link);
 	CFS_INIT_LIST_HEAD(&export->exp_hp_rpcs);
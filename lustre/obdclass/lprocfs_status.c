@@ -887,11 +887,23 @@ static const char *obd_connect_names[] = {
 	"pingless",
 	"flock_deadlock",
 	"disp_stripe",
+	"open_by_fid",
+	"lfsck",
+	"ast_alive",
 	"unknown",
 	NULL
 };
 
-int obd_connect_flags2str(char *page, int count, __u64 flags, char *sep)
+/* ocd_connect_flags2, sparse since most of its bits are not used here */
+static const struct {
+	__u64		 flag;
+	const char	*name;
+} obd_connect_names2[] = {
+	{ OBD_CONNECT2_BATCH_RPCS,	"batch_rpc" },
+};
+
+int obd_connect_flags2str(char *page, int count, __u64 flags, __u64 flags2,
+			  char *sep)
 {
 	__u64 mask = 1;
 	int i, ret = 0;
@@ -901,10 +913,26 @@ int obd_connect_flags2str(char *page, int count, __u64 flags, char *sep)
 			ret += snprintf(page + ret, count - ret, "%s%s",
 					ret ? sep : "", obd_connect_names[i]);
 	}
-	if (flags & ~(mask - 1))
+	if (flags & ~(mask - 1) & ~OBD_CONNECT_FLAGS2)
 		ret += snprintf(page + ret, count - ret,
 				"%sunknown_"LPX64,
-				ret ? sep : "", flags & ~(mask - 1));
+				ret ? sep : "",
+				flags & ~(mask - 1) & ~OBD_CONNECT_FLAGS2);
+
+	if (!(flags & OBD_CONNECT_FLAGS2))
+		return ret;
+
+	for (i = 0; i < ARRAY_SIZE(obd_connect_names2); i++) {
+		if (flags2 & obd_connect_names2[i].flag) {
+			ret += snprintf(page + ret, count - ret, "%s%s",
+					ret ? sep : "",
+					obd_connect_names2[i].name);
+			flags2 &= ~obd_connect_names2[i].flag;
+		}
+	}
+	if (flags2 != 0)
+		ret += snprintf(page + ret, count - ret,
+				"%sunknown2_"LPX64, ret ? sep : "", flags2);
 	return ret;
 }
 EXPORT_SYMBOL(obd_connect_flags2str);
@@ -1010,7 +1038,7 @@ int lprocfs_rd_import(char *page, char **start, off_t off, int count,
 		     ptlrpc_import_state_name(imp->imp_state));
 	i += obd_connect_flags2str(page + i, count - i,
 				   ocd->ocd_connect_flags,
-				   ", ");
+				   ocd->ocd_connect_flags2, ", ");
 	i += snprintf(page + i, count - i, " ]\n");
 	i += obd_connect_data_print(page + i, count - i, ocd);
 	i += snprintf(page + i, count - i,
@@ -1230,13 +1258,16 @@ int lprocfs_rd_connect_flags(char *page, char **start, off_t off,
                              int count, int *eof, void *data)
 {
         struct obd_device *obd = data;
+	struct obd_connect_data *ocd;
         __u64 flags;
         int ret = 0;
 
         LPROCFS_CLIMP_CHECK(obd);
-        flags = obd->u.cli.cl_import->imp_connect_data.ocd_connect_flags;
+	ocd = &obd->u.cli.cl_import->imp_connect_data;
+	flags = ocd->ocd_connect_flags;
         ret = snprintf(page, count, "flags="LPX64"\n", flags);
-        ret += obd_connect_flags2str(page + ret, count - ret, flags, "\n");
+	ret += obd_connect_flags2str(page + ret, count - ret, flags,
+				     ocd->ocd_connect_flags2, "\n");
         ret += snprintf(page + ret, count - ret, "\n");
         LPROCFS_CLIMP_EXIT(obd);
         return ret;
@@ -1782,6 +1813,7 @@ void lprocfs_init_mps_stats(int num_private_stats, struct lprocfs_stats *stats)
         LPROCFS_MD_OP_INIT(num_private_stats, stats, unlink);
         LPROCFS_MD_OP_INIT(num_private_stats, stats, setxattr);
         LPROCFS_MD_OP_INIT(num_private_stats, stats, getxattr);
+	LPROCFS_MD_OP_INIT(num_private_stats, stats, getattr_xattr);
         LPROCFS_MD_OP_INIT(num_private_stats, stats, init_ea_size);
         LPROCFS_MD_OP_INIT(num_private_stats, stats, get_lustre_md);
         LPROCFS_MD_OP_INIT(num_private_stats, stats, free_lustre_md);
@@ -0,0 +1,155 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * GPL HEADER END
+ */
+/*
+ * lustre/ptlrpc/at_estimate.c
+ *
+ * Adaptive timeout estimators, used by at_measured().
+ *
+ * Only libcfs is needed here, tests/at_sim.c includes this file to replay
+ * recorded service times through the estimators.
+ */
+
+#define DEBUG_SUBSYSTEM S_RPC
+
+#include <libcfs/libcfs.h>
+#include <lustre_import.h>
+
+extern unsigned int at_history;
+
+static inline unsigned int at_pct_val2bin(unsigned int val)
+{
+	unsigned int bits;
+
+	if (val < 8)
+		return val;
+	if (val >= AT_PCT_VAL_MAX)
+		val = AT_PCT_VAL_MAX - 1;
+
+	bits = fls(val);
+	return 8 + 4 * (bits - 4) + ((val >> (bits - 3)) & 3);
+}
+
+/* largest value counted in \a bin */
+static inline unsigned int at_pct_bin2val(unsigned int bin)
+{
+	if (bin < 8)
+		return bin;
+
+	return ((5 + (bin - 8) % 4) << ((bin - 8) / 4 + 1)) - 1;
+}
+
+static unsigned int at_pct_estimate(struct at_pct *ap, unsigned int val,
+				    time_t now, time_t binlimit)
+{
+	__u64	total = 0;
+	__u64	tail = 0;
+	time_t	shift;
+	int	i;
+
+	if (unlikely(ap->ap_decay_time == 0))
+		ap->ap_decay_time = now;
+
+	shift = (now - ap->ap_decay_time) / binlimit;
+	if (shift > 0) {
+		for (i = 0; i < AT_PCT_BINS; i++)
+			ap->ap_weight[i] = shift < 32 ?
+					   ap->ap_weight[i] >> shift : 0;
+		ap->ap_decay_time += shift * binlimit;
+	}
+
+	ap->ap_weight[at_pct_val2bin(val)] += AT_PCT_ONE;
+
+	for (i = 0; i < AT_PCT_BINS; i++)
+		total += ap->ap_weight[i];
+
+	/* walk down until more than (100 - ap_pct)% of the weight is above */
+	for (i = AT_PCT_BINS - 1; i > 0; i--) {
+		tail += ap->ap_weight[i];
+		if (tail * 100 > total * (100 - ap->ap_pct))
+			break;
+	}
+
+	return at_pct_bin2val(i);
+}
+
+/**
+ * Account \a val measured at \a now in \a at and set at_current, not bounded
+ * by at_min and at_max yet.  Caller holds at_lock.
+ *
+ *  - Bin into timeslices using AT_BINS bins.
+ *  - This gives us a max of the last at_history seconds without the storage,
+ *    but still smoothing out a return to normalcy from a slow response.
+ *  - (E.g. remember the maximum latency in each minute of the last 4 minutes.)
+ *  - With a percentile estimator the bins are kept for /proc, and at_current
+ *    is the percentile of values seen over about the same history instead.
+ */
+void at_update(struct adaptive_timeout *at, unsigned int val, time_t now)
+{
+	time_t binlimit = at_history / AT_BINS;
+
+	if (binlimit == 0)
+		binlimit = 1;
+
+	if (unlikely(at->at_binstart == 0)) {
+		/* Special case to remove default from history */
+		at->at_current = val;
+		at->at_worst_ever = val;
+		at->at_worst_time = now;
+		at->at_hist[0] = val;
+		at->at_binstart = now;
+	} else if (now - at->at_binstart < binlimit) {
+		/* in bin 0 */
+		at->at_hist[0] = max(val, at->at_hist[0]);
+		at->at_current = max(val, at->at_current);
+	} else {
+		int i, shift;
+		unsigned int maxv = val;
+		/* move bins over */
+		shift = (now - at->at_binstart) / binlimit;
+		LASSERT(shift > 0);
+		for (i = AT_BINS - 1; i >= 0; i--) {
+			if (i >= shift) {
+				at->at_hist[i] = at->at_hist[i - shift];
+				maxv = max(maxv, at->at_hist[i]);
+			} else {
+				at->at_hist[i] = 0;
+			}
+		}
+		at->at_hist[0] = val;
+		at->at_current = maxv;
+		at->at_binstart += shift * binlimit;
+	}
+
+	if (at->at_pct != NULL)
+		at->at_current = at_pct_estimate(at->at_pct, val, now,
+						 binlimit);
+
+	if (at->at_current > at->at_worst_ever) {
+		at->at_worst_ever = at->at_current;
+		at->at_worst_time = now;
+	}
+
+	if (at->at_flags & AT_FLG_NOHIST)
+		/* Only keep last reported val; keeping the rest of the history
+		   for proc only */
+		at->at_current = val;
+}
@@ -628,6 +628,7 @@ static int __ptlrpc_request_bufs_pack(struct ptlrpc_request *request,
 	CFS_INIT_LIST_HEAD(&request->rq_replay_list);
 	CFS_INIT_LIST_HEAD(&request->rq_ctx_chain);
 	CFS_INIT_LIST_HEAD(&request->rq_set_chain);
+	CFS_INIT_LIST_HEAD(&request->rq_ready_chain);
 	CFS_INIT_LIST_HEAD(&request->rq_history_list);
 	CFS_INIT_LIST_HEAD(&request->rq_exp_list);
 	init_waitqueue_head(&request->rq_reply_waitq);
@@ -874,6 +875,10 @@ struct ptlrpc_request_set *ptlrpc_prep_set(void)
 	set->set_producer     = NULL;
 	set->set_producer_arg = NULL;
 	set->set_rc           = 0;
+	set->set_events       = 0;
+	spin_lock_init(&set->set_ready_lock);
+	CFS_INIT_LIST_HEAD(&set->set_ready);
+	set->set_rescan_time  = 0;
 
 	RETURN(set);
 }
@@ -941,6 +946,7 @@ void ptlrpc_set_destroy(struct ptlrpc_request_set *set)
                 struct ptlrpc_request *req =
                         cfs_list_entry(tmp, struct ptlrpc_request,
                                        rq_set_chain);
+		ptlrpc_set_req_unready(set, req);
                 cfs_list_del_init(&req->rq_set_chain);
 
                 LASSERT(req->rq_phase == expected_phase);
@@ -1001,6 +1007,7 @@ void ptlrpc_set_add_req(struct ptlrpc_request_set *set,
 	req->rq_set = set;
 	cfs_atomic_inc(&set->set_remaining);
 	req->rq_queued_time = cfs_time_current();
+	ptlrpc_set_req_ready(set, req);
 
 	if (req->rq_reqmsg != NULL)
 		lustre_msg_set_jobid(req->rq_reqmsg, NULL);
@@ -1082,6 +1089,9 @@ static int ptlrpc_import_delay_req(struct obd_import *imp,
                 /* probably doesn't need to be a D_ERROR after initial testing */
                 DEBUG_REQ(D_ERROR, req, "send limit expired ");
                 *status = -EIO;
+	} else if (imp->imp_state == LUSTRE_IMP_IDLE) {
+		/* wait for ptlrpc_send_new_req() to connect it again */
+		delay = 1;
         } else if (req->rq_send_state == LUSTRE_IMP_CONNECTING &&
                    imp->imp_state == LUSTRE_IMP_CONNECTING) {
                 /* allow CONNECT even if import is invalid */ ;
@@ -1101,7 +1111,8 @@ static int ptlrpc_import_delay_req(struct obd_import *imp,
                 if (cfs_atomic_read(&imp->imp_inval_count) != 0) {
                         DEBUG_REQ(D_ERROR, req, "invalidate in flight");
                         *status = -EIO;
-                } else if (imp->imp_dlm_fake || req->rq_no_delay) {
+		} else if (imp->imp_dlm_fake ||
+			   (req->rq_no_delay && !imp->imp_idle_connect)) {
                         *status = -EWOULDBLOCK;
 		} else if (req->rq_allow_replay &&
 			  (imp->imp_state == LUSTRE_IMP_REPLAY ||
@@ -1411,6 +1422,7 @@ static int after_reply(struct ptlrpc_request *req)
 static int ptlrpc_send_new_req(struct ptlrpc_request *req)
 {
         struct obd_import     *imp = req->rq_import;
+	int connect = 0;
         int rc;
         ENTRY;
 
@@ -1428,6 +1440,13 @@ static int ptlrpc_send_new_req(struct ptlrpc_request *req)
 		req->rq_import_generation = imp->imp_generation;
 
 	if (ptlrpc_import_delay_req(imp, req, &rc)) {
+		/* the first request on an idle import connects it again */
+		if (imp->imp_state == LUSTRE_IMP_IDLE &&
+		    !imp->imp_idle_connect) {
+			imp->imp_idle_connect = 1;
+			connect = 1;
+		}
+
 		spin_lock(&req->rq_lock);
 		req->rq_waiting = 1;
 		spin_unlock(&req->rq_lock);
@@ -1440,6 +1459,11 @@ static int ptlrpc_send_new_req(struct ptlrpc_request *req)
 		cfs_list_add_tail(&req->rq_list, &imp->imp_delayed_list);
 		cfs_atomic_inc(&req->rq_import->imp_inflight);
 		spin_unlock(&imp->imp_lock);
+
+		if (connect) {
+			DEBUG_REQ(D_HA, req, "reconnecting idle import");
+			ptlrpc_connect_import(imp);
+		}
 		RETURN(0);
 	}
 
@@ -1519,19 +1543,55 @@ static inline int ptlrpc_set_producer(struct ptlrpc_request_set *set)
 int ptlrpc_check_set(const struct lu_env *env, struct ptlrpc_request_set *set)
 {
         cfs_list_t *tmp, *next;
+	cfs_list_t *head = &set->set_requests;
+	cfs_list_t  ready;
+	int events = 0;
         int force_timer_recalc = 0;
         ENTRY;
 
         if (cfs_atomic_read(&set->set_remaining) == 0)
                 RETURN(1);
 
-        cfs_list_for_each_safe(tmp, next, &set->set_requests) {
-                struct ptlrpc_request *req =
-                        cfs_list_entry(tmp, struct ptlrpc_request,
-                                       rq_set_chain);
-                struct obd_import *imp = req->rq_import;
-                int unregistered = 0;
-                int rc = 0;
+	if (set->set_events) {
+		time_t now = cfs_time_current_sec();
+
+		/* Look at all requests once a second for timeouts and delayed
+		 * sends, and only at the requests with new events otherwise,
+		 * which keeps this cheap with thousands of RPCs in flight. */
+		if (now >= set->set_rescan_time) {
+			set->set_rescan_time = now + 1;
+			ptlrpc_expired_set(set);
+		} else {
+			events = 1;
+		}
+
+		CFS_INIT_LIST_HEAD(&ready);
+		spin_lock(&set->set_ready_lock);
+		cfs_list_splice_init(&set->set_ready, &ready);
+		while (!events && !cfs_list_empty(&ready))
+			cfs_list_del_init(ready.next);
+		spin_unlock(&set->set_ready_lock);
+
+		if (events)
+			head = &ready;
+	}
+
+	for (tmp = head->next; tmp != head; tmp = next) {
+		struct ptlrpc_request *req;
+		struct obd_import *imp;
+		int unregistered = 0;
+		int rc = 0;
+
+		next = tmp->next;
+		if (events) {
+			req = cfs_list_entry(tmp, struct ptlrpc_request,
+					     rq_ready_chain);
+			ptlrpc_set_req_unready(set, req);
+		} else {
+			req = cfs_list_entry(tmp, struct ptlrpc_request,
+					     rq_set_chain);
+		}
+		imp = req->rq_import;
 
 		/* This schedule point is mainly for the ptlrpcd caller of this
 		 * function.  Most ptlrpc sets are not long-lived and unbounded
@@ -1740,6 +1800,7 @@ int ptlrpc_check_set(const struct lu_env *env, struct ptlrpc_request_set *set)
 						spin_lock(&req->rq_lock);
 						req->rq_wait_ctx = 0;
 						spin_unlock(&req->rq_lock);
+						ptlrpc_set_req_ready(set, req);
 						force_timer_recalc = 1;
 					} else {
 						spin_lock(&req->rq_lock);
@@ -1762,6 +1823,7 @@ int ptlrpc_check_set(const struct lu_env *env, struct ptlrpc_request_set *set)
 					spin_lock(&req->rq_lock);
 					req->rq_net_err = 1;
 					spin_unlock(&req->rq_lock);
+					ptlrpc_set_req_ready(set, req);
 					continue;
 				}
 				/* need to reset the timeout */
@@ -1853,6 +1915,10 @@ int ptlrpc_check_set(const struct lu_env *env, struct ptlrpc_request_set *set)
 			continue;
 		}
 		ptlrpc_rqphase_move(req, RQ_PHASE_COMPLETE);
+		/* keep completed requests at the head of sets processed on
+		 * events, ptlrpcd_check() prunes them from there */
+		if (set->set_events)
+			cfs_list_move(&req->rq_set_chain, &set->set_requests);
 
 		CDEBUG(req->rq_reqmsg != NULL ? D_RPCTRACE : 0,
 			"Completed RPC pname:cluuid:pid:xid:nid:"
@@ -2045,6 +2111,7 @@ int ptlrpc_expired_set(void *data)
                 /* Deal with this guy. Do it asynchronously to not block
                  * ptlrpcd thread. */
                 ptlrpc_expire_one_request(req, 1);
+		ptlrpc_set_req_ready(set, req);
         }
 
         /*
@@ -2089,6 +2156,7 @@ void ptlrpc_interrupted_set(void *data)
                         continue;
 
                 ptlrpc_mark_interrupted(req);
+		ptlrpc_set_req_ready(set, req);
         }
 }
 EXPORT_SYMBOL(ptlrpc_interrupted_set);
@@ -2762,6 +2830,144 @@ int ptlrpc_queue_wait(struct ptlrpc_request *req)
 }
 EXPORT_SYMBOL(ptlrpc_queue_wait);
 
+/**
+ * Compound requests.
+ *
+ * The sub-requests are allocated and packed as usual, but are never sent:
+ * their messages travel in the RMF_BATCH_BUF of one compound request to
+ * the same target, and their replies come back in its RMF_BATCH_REPLY.
+ * Once unpacked, every sub-request looks as if it had been sent and replied
+ * on its own.
+ */
+
+/**
+ * Size the batch buffers of compound request \a req for the \a count
+ * packed sub-requests \a subs, before \a req gets packed.
+ */
+void ptlrpc_batch_set_size(struct ptlrpc_request *req,
+			   struct ptlrpc_request **subs, int count)
+{
+	__u32 lens[BATCH_MAX_OPS];
+	int   i;
+
+	LASSERT(count > 0 && count <= BATCH_MAX_OPS);
+
+	for (i = 0; i < count; i++)
+		lens[i] = subs[i]->rq_reqlen;
+	req_capsule_set_size(&req->rq_pill, &RMF_BATCH_BUF, RCL_CLIENT,
+			     lustre_batch_buf_size(count, lens));
+
+	for (i = 0; i < count; i++)
+		lens[i] = subs[i]->rq_replen;
+	req_capsule_set_size(&req->rq_pill, &RMF_BATCH_REPLY, RCL_SERVER,
+			     lustre_batch_buf_size(count, lens));
+}
+EXPORT_SYMBOL(ptlrpc_batch_set_size);
+
+/**
+ * Copy the messages of the sub-requests \a subs into the packed compound
+ * request \a req, stamped as ptl_send_rpc() would have done.
+ */
+void ptlrpc_batch_pack(struct ptlrpc_request *req,
+		       struct ptlrpc_request **subs, int count)
+{
+	struct obd_import *imp = req->rq_import;
+	struct batch_buf  *bb;
+	int		   i;
+
+	bb = req_capsule_client_get(&req->rq_pill, &RMF_BATCH_BUF);
+	LASSERT(bb != NULL);
+
+	lustre_batch_buf_init(bb, count);
+	for (i = 0; i < count; i++) {
+		struct lustre_msg *msg = subs[i]->rq_reqmsg;
+
+		LASSERT(subs[i]->rq_import == imp);
+		lustre_msg_set_handle(msg, &imp->imp_remote_handle);
+		lustre_msg_set_type(msg, PTL_RPC_MSG_REQUEST);
+		lustre_msg_set_conn_cnt(msg, imp->imp_conn_cnt);
+		lustre_msg_set_jobid(msg, NULL);
+		lustre_batch_buf_add(bb, i, msg, subs[i]->rq_reqlen);
+	}
+}
+EXPORT_SYMBOL(ptlrpc_batch_pack);
+
+static int ptlrpc_batch_unpack_one(struct ptlrpc_request *req,
+				   struct lustre_msg *msg, int len)
+{
+	int rc;
+
+	LASSERT(req->rq_repbuf == NULL);
+
+	rc = sptlrpc_cli_alloc_repbuf(req, len);
+	if (rc)
+		return rc;
+
+	memcpy(req->rq_repbuf, msg, len);
+	req->rq_repdata = (struct lustre_msg *)req->rq_repbuf;
+	req->rq_repdata_len = len;
+	req->rq_repmsg = req->rq_repdata;
+	req->rq_replen = len;
+	req->rq_nob_received = len;
+
+	rc = ptlrpc_unpack_rep_msg(req, len);
+	if (rc == 0)
+		rc = lustre_unpack_rep_ptlrpc_body(req, MSG_PTLRPC_BODY_OFF);
+	if (rc == 0 &&
+	    lustre_msg_get_type(req->rq_repmsg) != PTL_RPC_MSG_REPLY &&
+	    lustre_msg_get_type(req->rq_repmsg) != PTL_RPC_MSG_ERR)
+		rc = -EPROTO;
+	if (rc) {
+		DEBUG_REQ(D_ERROR, req, "bad reply in compound RPC: rc = %d",
+			  rc);
+		return -EPROTO;
+	}
+
+	req->rq_replied = 1;
+	return ptlrpc_check_status(req);
+}
+
+/**
+ * Hand the replies carried by the compound reply of \a req over to the
+ * sub-requests \a subs.  The outcome of each sub-request is left in its
+ * rq_status, the return value only tells whether the compound reply could
+ * be parsed at all.
+ */
+int ptlrpc_batch_unpack(struct ptlrpc_request *req,
+			struct ptlrpc_request **subs, int count)
+{
+	struct batch_buf  *bb;
+	struct lustre_msg *msg;
+	int		   len;
+	int		   i;
+	ENTRY;
+
+	bb = req_capsule_server_get(&req->rq_pill, &RMF_BATCH_REPLY);
+	if (bb == NULL)
+		RETURN(-EPROTO);
+
+	len = req_capsule_get_size(&req->rq_pill, &RMF_BATCH_REPLY,
+				   RCL_SERVER);
+	if (lustre_batch_buf_check(bb, len, ptlrpc_rep_need_swab(req)) != 0 ||
+	    bb->bb_count != count) {
+		DEBUG_REQ(D_ERROR, req, "bad compound reply of %d requests",
+			  count);
+		RETURN(-EPROTO);
+	}
+
+	for (i = 0; i < count; i++) {
+		msg = lustre_batch_buf_msg(bb, i, &len);
+		if (msg == NULL)
+			/* dropped by the server, as a lost reply would be */
+			subs[i]->rq_status = -EIO;
+		else
+			subs[i]->rq_status = ptlrpc_batch_unpack_one(subs[i],
+								     msg, len);
+	}
+	RETURN(0);
+}
+EXPORT_SYMBOL(ptlrpc_batch_unpack);
+
 struct ptlrpc_replay_async_args {
         int praa_old_state;
         int praa_old_status;
@@ -3122,6 +3328,7 @@ static int work_interpreter(const struct lu_env *env,
 
 	rc = arg->cb(env, arg->cbdata);
 
+	ptlrpc_set_req_unready(req->rq_set, req);
 	cfs_list_del_init(&req->rq_set_chain);
 	req->rq_set = NULL;
 
@@ -3176,6 +3383,7 @@ void *ptlrpcd_alloc_work(struct obd_import *imp,
 	CFS_INIT_LIST_HEAD(&req->rq_list);
 	CFS_INIT_LIST_HEAD(&req->rq_replay_list);
 	CFS_INIT_LIST_HEAD(&req->rq_set_chain);
+	CFS_INIT_LIST_HEAD(&req->rq_ready_chain);
 	CFS_INIT_LIST_HEAD(&req->rq_history_list);
 	CFS_INIT_LIST_HEAD(&req->rq_exp_list);
 	init_waitqueue_head(&req->rq_reply_waitq);
@@ -166,6 +166,10 @@ void reply_in_callback(lnet_event_t *ev)
         }
 
         req->rq_import->imp_last_reply_time = cfs_time_current_sec();
+	/* pings do not make an import busy, see ptlrpc_import_is_idle() */
+	if (lustre_msg_get_opc(req->rq_reqmsg) != OBD_PING)
+		req->rq_import->imp_last_use =
+			req->rq_import->imp_last_reply_time;
 
 out_wake:
         /* NB don't unlock till after wakeup; req can disappear under us
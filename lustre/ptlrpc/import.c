@@ -71,6 +71,7 @@ static void __import_set_state(struct obd_import *imp,
 	case LUSTRE_IMP_NEW:
 	case LUSTRE_IMP_DISCON:
 	case LUSTRE_IMP_CONNECTING:
+	case LUSTRE_IMP_IDLE:
 		break;
 	case LUSTRE_IMP_REPLAY_WAIT:
 		imp->imp_replay_state = LUSTRE_IMP_REPLAY_LOCKS;
@@ -78,6 +79,10 @@ static void __import_set_state(struct obd_import *imp,
 	default:
 		imp->imp_replay_state = LUSTRE_IMP_REPLAY;
 	}
+	/* the disconnect to or reconnect from IDLE is over once the import
+	 * is idle or usable again, or had to fall back to recovery */
+	if (state != LUSTRE_IMP_CONNECTING && state != LUSTRE_IMP_RECOVER)
+		imp->imp_idle_connect = 0;
         imp->imp_state = state;
         imp->imp_state_hist[imp->imp_state_hist_idx].ish_state = state;
         imp->imp_state_hist[imp->imp_state_hist_idx].ish_time =
@@ -674,6 +679,7 @@ int ptlrpc_connect_import(struct obd_import *imp)
         /* Reset connect flags to the originally requested flags, in case
          * the server is updated on-the-fly we will get the new features. */
         imp->imp_connect_data.ocd_connect_flags = imp->imp_connect_flags_orig;
+	imp->imp_connect_data.ocd_connect_flags2 = imp->imp_connect_flags2_orig;
 	/* Reset ocd_version each time so the server knows the exact versions */
 	imp->imp_connect_data.ocd_version = LUSTRE_VERSION_CODE;
         imp->imp_msghdr_flags &= ~MSGHDR_AT_SUPPORT;
@@ -980,6 +986,10 @@ static int ptlrpc_connect_interpret(const struct lu_env *env,
         imp->imp_force_verify = 0;
 
 	imp->imp_connect_data = *ocd;
+	/* an older server echoes ocd_connect_flags2 back untouched, it is
+	 * only meaningful with OBD_CONNECT_FLAGS2 granted */
+	if (!(ocd->ocd_connect_flags & OBD_CONNECT_FLAGS2))
+		imp->imp_connect_data.ocd_connect_flags2 = 0;
 
 	CDEBUG(D_HA, "%s: connect to target with instance %u\n",
 	       imp->imp_obd->obd_name, ocd->ocd_instance);
@@ -997,6 +1007,16 @@ static int ptlrpc_connect_interpret(const struct lu_env *env,
 		GOTO(out, rc = -EPROTO);
 	}
 
+	if ((ocd->ocd_connect_flags & OBD_CONNECT_FLAGS2) &&
+	    (ocd->ocd_connect_flags2 & imp->imp_connect_flags2_orig) !=
+	    ocd->ocd_connect_flags2) {
+		CERROR("%s: Server didn't grant asked subset of flags2: "
+		       "asked="LPX64" granted="LPX64"\n",
+		       imp->imp_obd->obd_name, imp->imp_connect_flags2_orig,
+		       ocd->ocd_connect_flags2);
+		GOTO(out, rc = -EPROTO);
+	}
+
 	if (!exp) {
 		/* This could happen if export is cleaned during the
 		   connect attempt */
@@ -1430,6 +1450,8 @@ int ptlrpc_import_recovery_state_machine(struct obd_import *imp)
         }
 
         if (imp->imp_state == LUSTRE_IMP_RECOVER) {
+		int idle = imp->imp_idle_connect;
+
                 CDEBUG(D_HA, "reconnected to %s@%s\n",
                        obd2cli_tgt(imp->imp_obd),
                        imp->imp_connection->c_remote_uuid.uuid);
@@ -1440,12 +1462,16 @@ int ptlrpc_import_recovery_state_machine(struct obd_import *imp)
                 IMPORT_SET_STATE(imp, LUSTRE_IMP_FULL);
                 ptlrpc_activate_import(imp);
 
-                deuuidify(obd2cli_tgt(imp->imp_obd), NULL,
-                          &target_start, &target_len);
-                LCONSOLE_INFO("%s: Connection restored to %.*s (at %s)\n",
-                              imp->imp_obd->obd_name,
-                              target_len, target_start,
-                              libcfs_nid2str(imp->imp_connection->c_peer.nid));
+		/* coming back from IDLE is routine, not worth a message */
+		if (!idle) {
+			deuuidify(obd2cli_tgt(imp->imp_obd), NULL,
+				  &target_start, &target_len);
+			LCONSOLE_INFO("%s: Connection restored to %.*s "
+				      "(at %s)\n", imp->imp_obd->obd_name,
+				      target_len, target_start,
+				      libcfs_nid2str(
+					imp->imp_connection->c_peer.nid));
+		}
         }
 
 	if (imp->imp_state == LUSTRE_IMP_FULL) {
@@ -1541,6 +1567,93 @@ out:
 }
 EXPORT_SYMBOL(ptlrpc_disconnect_import);
 
+static int ptlrpc_disconnect_idle_interpret(const struct lu_env *env,
+					    struct ptlrpc_request *req,
+					    void *data, int rc)
+{
+	struct obd_import *imp = req->rq_import;
+	int connect = 0;
+	ENTRY;
+
+	DEBUG_REQ(D_HA, req, "idle disconnect done: rc = %d", rc);
+
+	spin_lock(&imp->imp_lock);
+	/* closed or failed meanwhile, they know what to do */
+	if (imp->imp_state != LUSTRE_IMP_CONNECTING) {
+		spin_unlock(&imp->imp_lock);
+		RETURN(0);
+	}
+
+	/* Even if the DISCONNECT got lost the next connect is an initial
+	 * one, the target replaces the old export of this client then. */
+	memset(&imp->imp_remote_handle, 0, sizeof(imp->imp_remote_handle));
+	IMPORT_SET_STATE_NOLOCK(imp, LUSTRE_IMP_IDLE);
+
+	/* requests sent meanwhile wait for a new connection */
+	if (!cfs_list_empty(&imp->imp_delayed_list)) {
+		imp->imp_idle_connect = 1;
+		connect = 1;
+	}
+	spin_unlock(&imp->imp_lock);
+
+	if (connect)
+		ptlrpc_connect_import(imp);
+
+	RETURN(0);
+}
+
+/**
+ * Disconnect \a imp which has had nothing to do for a while, so that the
+ * target frees the export and everything it keeps for it.  The import is
+ * left LUSTRE_IMP_IDLE, and ptlrpc_send_new_req() connects it again for
+ * the next request.
+ */
+int ptlrpc_disconnect_idle_import(struct obd_import *imp)
+{
+	struct ptlrpc_request *req;
+	int rq_opc;
+	ENTRY;
+
+	switch (imp->imp_connect_op) {
+	case OST_CONNECT: rq_opc = OST_DISCONNECT; break;
+	case MDS_CONNECT: rq_opc = MDS_DISCONNECT; break;
+	default:
+		RETURN(-EOPNOTSUPP);
+	}
+
+	req = ptlrpc_request_alloc_pack(imp, &RQF_MDS_DISCONNECT,
+					LUSTRE_OBD_VERSION, rq_opc);
+	if (req == NULL)
+		RETURN(-ENOMEM);
+
+	/* a lost DISCONNECT does not matter, see the interpret callback */
+	req->rq_no_resend = 1;
+	req->rq_timeout = min_t(int, req->rq_timeout, INITIAL_CONNECT_TIMEOUT);
+	req->rq_send_state = LUSTRE_IMP_CONNECTING;
+	req->rq_interpret_reply = ptlrpc_disconnect_idle_interpret;
+	ptlrpc_request_set_replen(req);
+
+	spin_lock(&imp->imp_lock);
+	if (imp->imp_state != LUSTRE_IMP_FULL ||
+	    cfs_atomic_read(&imp->imp_inflight) > 0) {
+		spin_unlock(&imp->imp_lock);
+		ptlrpc_req_finished(req);
+		RETURN(-EBUSY);
+	}
+	IMPORT_SET_STATE_NOLOCK(imp, LUSTRE_IMP_CONNECTING);
+	/* requests sent meanwhile wait for the reconnect after it, even
+	 * no_delay ones, see ptlrpc_disconnect_idle_interpret() */
+	imp->imp_idle_connect = 1;
+	spin_unlock(&imp->imp_lock);
+
+	CDEBUG(D_HA, "%s: disconnect from %s after %lds idle\n",
+	       imp->imp_obd->obd_name, obd2cli_tgt(imp->imp_obd),
+	       cfs_time_current_sec() - imp->imp_last_use);
+
+	ptlrpcd_add_req(req, PDL_POLICY_ROUND, -1);
+	RETURN(0);
+}
+
 void ptlrpc_cleanup_imp(struct obd_import *imp)
 {
 	ENTRY;
@@ -1556,20 +1669,14 @@ void ptlrpc_cleanup_imp(struct obd_import *imp)
 EXPORT_SYMBOL(ptlrpc_cleanup_imp);
 
 /* Adaptive Timeout utils */
-extern unsigned int at_min, at_max, at_history;
+extern unsigned int at_min, at_max;
 
 /* Update at_current with the specified value (bounded by at_min and at_max),
- * as well as the AT history "bins".
- *  - Bin into timeslices using AT_BINS bins.
- *  - This gives us a max of the last at_history seconds without the storage,
- *    but still smoothing out a return to normalcy from a slow response.
- *  - (E.g. remember the maximum latency in each minute of the last 4 minutes.)
- */
+ * as well as the AT history, see at_update(). */
 int at_measured(struct adaptive_timeout *at, unsigned int val)
 {
         unsigned int old = at->at_current;
         time_t now = cfs_time_current_sec();
-        time_t binlimit = max_t(time_t, at_history / AT_BINS, 1);
 
         LASSERT(at);
         CDEBUG(D_OTHER, "add %u to %p time=%lu v=%u (%u %u %u %u)\n",
@@ -1583,45 +1690,7 @@ int at_measured(struct adaptive_timeout *at, unsigned int val)
 
 	spin_lock(&at->at_lock);
 
-        if (unlikely(at->at_binstart == 0)) {
-                /* Special case to remove default from history */
-                at->at_current = val;
-                at->at_worst_ever = val;
-                at->at_worst_time = now;
-                at->at_hist[0] = val;
-                at->at_binstart = now;
-        } else if (now - at->at_binstart < binlimit ) {
-                /* in bin 0 */
-                at->at_hist[0] = max(val, at->at_hist[0]);
-                at->at_current = max(val, at->at_current);
-        } else {
-                int i, shift;
-                unsigned int maxv = val;
-                /* move bins over */
-                shift = (now - at->at_binstart) / binlimit;
-                LASSERT(shift > 0);
-                for(i = AT_BINS - 1; i >= 0; i--) {
-                        if (i >= shift) {
-                                at->at_hist[i] = at->at_hist[i - shift];
-                                maxv = max(maxv, at->at_hist[i]);
-                        } else {
-                                at->at_hist[i] = 0;
-                        }
-                }
-                at->at_hist[0] = val;
-                at->at_current = maxv;
-                at->at_binstart += shift * binlimit;
-        }
-
-        if (at->at_current > at->at_worst_ever) {
-                at->at_worst_ever = at->at_current;
-                at->at_worst_time = now;
-        }
-
-        if (at->at_flags & AT_FLG_NOHIST)
-                /* Only keep last reported val; keeping the rest of the history
-                   for proc only */
-                at->at_current = val;
+	at_update(at, val, now);
 
         if (at_max > 0)
                 at->at_current =  min(at->at_current, at_max);
@@ -1641,6 +1710,35 @@ int at_measured(struct adaptive_timeout *at, unsigned int val)
         return old;
 }
 
+/**
+ * Estimate the \a pct percentile of the values measured in \a at instead of
+ * the maximum of its history bins; 0 goes back to the maximum.
+ */
+int at_set_percentile(struct adaptive_timeout *at, unsigned int pct)
+{
+	struct at_pct *ap = NULL;
+	struct at_pct *old;
+
+	if (pct >= 100)
+		return -ERANGE;
+
+	if (pct != 0) {
+		OBD_ALLOC_PTR(ap);
+		if (ap == NULL)
+			return -ENOMEM;
+		ap->ap_pct = pct;
+	}
+
+	spin_lock(&at->at_lock);
+	old = at->at_pct;
+	at->at_pct = ap;
+	spin_unlock(&at->at_lock);
+
+	if (old != NULL)
+		OBD_FREE_PTR(old);
+	return 0;
+}
+
 /* Find the imp_at index for a given portal; assign if space available */
 int import_at_get_index(struct obd_import *imp, int portal)
 {
@@ -528,6 +528,16 @@ static const struct req_msg_field *mds_update_server[] = {
 	&RMF_UPDATE_REPLY,
 };
 
+static const struct req_msg_field *mds_batch_client[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_BATCH_BUF,
+};
+
+static const struct req_msg_field *mds_batch_server[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_BATCH_REPLY,
+};
+
 static const struct req_msg_field *llog_origin_handle_create_client[] = {
         &RMF_PTLRPC_BODY,
         &RMF_LLOGD_BODY,
@@ -727,6 +737,7 @@ static struct req_format *req_formats[] = {
 	&RQF_MDS_HSM_REQUEST,
 	&RQF_MDS_SWAP_LAYOUTS,
 	&RQF_UPDATE_OBJ,
+	&RQF_MDS_BATCH,
 	&RQF_QC_CALLBACK,
         &RQF_OST_CONNECT,
         &RQF_OST_DISCONNECT,
@@ -1170,6 +1181,14 @@ struct req_msg_field RMF_UPDATE_REPLY = DEFINE_MSGF("update_reply", 0, -1,
 						    NULL);
 EXPORT_SYMBOL(RMF_UPDATE_REPLY);
 
+struct req_msg_field RMF_BATCH_BUF = DEFINE_MSGF("batch_buf", 0, -1,
+						 lustre_swab_batch_buf, NULL);
+EXPORT_SYMBOL(RMF_BATCH_BUF);
+
+struct req_msg_field RMF_BATCH_REPLY = DEFINE_MSGF("batch_reply", 0, -1,
+						   lustre_swab_batch_buf, NULL);
+EXPORT_SYMBOL(RMF_BATCH_REPLY);
+
 struct req_msg_field RMF_SWAP_LAYOUTS =
 	DEFINE_MSGF("swap_layouts", 0, sizeof(struct  mdc_swap_layouts),
 		    lustre_swab_swap_layouts, NULL);
@@ -1378,6 +1397,10 @@ struct req_format RQF_UPDATE_OBJ =
 			mds_update_server);
 EXPORT_SYMBOL(RQF_UPDATE_OBJ);
 
+struct req_format RQF_MDS_BATCH =
+	DEFINE_REQ_FMT0("MDS_BATCH", mds_batch_client, mds_batch_server);
+EXPORT_SYMBOL(RQF_MDS_BATCH);
+
 struct req_format RQF_LDLM_ENQUEUE =
         DEFINE_REQ_FMT0("LDLM_ENQUEUE",
                         ldlm_enqueue_client, ldlm_enqueue_lvb_server);
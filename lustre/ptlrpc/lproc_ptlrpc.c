@@ -102,6 +102,8 @@ struct ll_rpc_opcode {
 	{ MDS_HSM_CT_REGISTER, "mds_hsm_ct_register" },
 	{ MDS_HSM_CT_UNREGISTER, "mds_hsm_ct_unregister" },
 	{ MDS_SWAP_LAYOUTS,	"mds_swap_layouts" },
+	{ MDS_RMFID,		"mds_rmfid" },
+	{ MDS_BATCH,		"mds_batch" },
         { LDLM_ENQUEUE,     "ldlm_enqueue" },
         { LDLM_CONVERT,     "ldlm_convert" },
         { LDLM_CANCEL,      "ldlm_cancel" },
@@ -273,6 +275,34 @@ ptlrpc_lprocfs_read_req_history_len(char *page, char **start, off_t off,
 	return snprintf(page, count, "%d\n", total);
 }
 
+/**
+ * Request buffers of the service and the memory they take, see
+ * ptlrpc_grow_req_bufs()
+ */
+static int
+ptlrpc_lprocfs_rd_req_buffers(char *page, char **start, off_t off,
+			      int count, int *eof, void *data)
+{
+	struct ptlrpc_service *svc = data;
+	struct ptlrpc_service_part *svcpt;
+	int	total = 0;
+	int	posted = 0;
+	int	grow = 0;
+	int	i;
+
+	*eof = 1;
+
+	ptlrpc_service_for_each_part(svcpt, i, svc) {
+		total += svcpt->scp_nrqbds_total;
+		posted += svcpt->scp_nrqbds_posted;
+		grow += svcpt->scp_rqbd_grow;
+	}
+
+	return snprintf(page, count,
+			"total: %d\nposted: %d\ngrow: %d\nbytes: "LPU64"\n",
+			total, posted, grow, (__u64)total * svc->srv_buf_size);
+}
+
 static int
 ptlrpc_lprocfs_read_req_history_max(char *page, char **start, off_t off,
                                     int count, int *eof, void *data)
@@ -377,6 +407,22 @@ ptlrpc_lprocfs_rd_threads_started(char *page, char **start, off_t off,
 	return snprintf(page, count, "%d\n", total);
 }
 
+/* replies kept until they are committed and acked */
+static int
+ptlrpc_lprocfs_rd_difficult_replies(char *page, char **start, off_t off,
+				    int count, int *eof, void *data)
+{
+	struct ptlrpc_service *svc = data;
+	struct ptlrpc_service_part *svcpt;
+	int	total = 0;
+	int	i;
+
+	ptlrpc_service_for_each_part(svcpt, i, svc)
+		total += cfs_atomic_read(&svcpt->scp_nreps_difficult);
+
+	return snprintf(page, count, "%d\n", total);
+}
+
 static int
 ptlrpc_lprocfs_rd_threads_max(char *page, char **start, off_t off,
 			      int count, int *eof, void *data)
@@ -414,6 +460,99 @@ ptlrpc_lprocfs_wr_threads_max(struct file *file, const char *buffer,
 	return count;
 }
 
+static int
+ptlrpc_lprocfs_rd_threads_wait_target(char *page, char **start, off_t off,
+				      int count, int *eof, void *data)
+{
+	struct ptlrpc_service *svc = data;
+
+	return snprintf(page, count, "%d\n", svc->srv_thrs_wait_target);
+}
+
+/**
+ * Target of request wait time in usec for thread autoscaling; 0 disables
+ * it and threads are only started on queue depth, as they used to be.
+ */
+static int
+ptlrpc_lprocfs_wr_threads_wait_target(struct file *file, const char *buffer,
+				      unsigned long count, void *data)
+{
+	struct ptlrpc_service *svc = data;
+	int	val;
+	int	rc = lprocfs_write_helper(buffer, count, &val);
+
+	if (rc < 0)
+		return rc;
+
+	if (val < 0)
+		return -ERANGE;
+
+	spin_lock(&svc->srv_lock);
+	svc->srv_thrs_wait_target = val;
+	spin_unlock(&svc->srv_lock);
+
+	return count;
+}
+
+static int
+ptlrpc_lprocfs_rd_at_estimator(char *page, char **start, off_t off,
+			       int count, int *eof, void *data)
+{
+	struct ptlrpc_service *svc = data;
+
+	if (svc->srv_at_pct == 0)
+		return snprintf(page, count, "max\n");
+
+	return snprintf(page, count, "p%d\n", svc->srv_at_pct);
+}
+
+/**
+ * Choose how the service time estimate of adaptive timeouts is computed:
+ * "max" of the history bins, or a percentile like "p99".
+ */
+static int
+ptlrpc_lprocfs_wr_at_estimator(struct file *file, const char *buffer,
+			       unsigned long count, void *data)
+{
+	struct ptlrpc_service		*svc = data;
+	struct ptlrpc_service_part	*svcpt;
+	char				kbuf[8];
+	char				*end;
+	unsigned long			pct;
+	int				rc;
+	int				i;
+
+	if (count >= sizeof(kbuf))
+		return -EINVAL;
+
+	if (copy_from_user(kbuf, buffer, count))
+		return -EFAULT;
+
+	kbuf[count] = '\0';
+
+	if (strncmp(kbuf, "max", 3) == 0) {
+		pct = 0;
+	} else if (kbuf[0] == 'p') {
+		pct = simple_strtoul(kbuf + 1, &end, 10);
+		if (end == kbuf + 1 || (*end != '\0' && *end != '\n'))
+			return -EINVAL;
+		if (pct == 0 || pct >= 100)
+			return -ERANGE;
+	} else {
+		return -EINVAL;
+	}
+
+	ptlrpc_service_for_each_part(svcpt, i, svc) {
+		rc = at_set_percentile(&svcpt->scp_at_estimate, pct);
+		if (rc != 0)
+			return rc;
+	}
+
+	svc->srv_at_pct = pct;
+
+	return count;
+}
+
 /**
  * \addtogoup nrs
  * @{
@@ -1101,6 +1240,9 @@ void ptlrpc_lprocfs_register_service(struct proc_dir_entry *entry,
                  .write_fptr = ptlrpc_lprocfs_write_req_history_max,
                  .read_fptr  = ptlrpc_lprocfs_read_req_history_max,
                  .data       = svc},
+		{.name	     = "req_buffers",
+		 .read_fptr  = ptlrpc_lprocfs_rd_req_buffers,
+		 .data	     = svc},
                 {.name       = "threads_min",
                  .read_fptr  = ptlrpc_lprocfs_rd_threads_min,
                  .write_fptr = ptlrpc_lprocfs_wr_threads_min,
@@ -1112,9 +1254,20 @@ void ptlrpc_lprocfs_register_service(struct proc_dir_entry *entry,
                 {.name       = "threads_started",
                  .read_fptr  = ptlrpc_lprocfs_rd_threads_started,
                  .data       = svc},
+		{.name	     = "threads_wait_target",
+		 .read_fptr  = ptlrpc_lprocfs_rd_threads_wait_target,
+		 .write_fptr = ptlrpc_lprocfs_wr_threads_wait_target,
+		 .data	     = svc},
                 {.name       = "timeouts",
                  .read_fptr  = ptlrpc_lprocfs_rd_timeouts,
                  .data       = svc},
+		{.name	     = "difficult_replies",
+		 .read_fptr  = ptlrpc_lprocfs_rd_difficult_replies,
+		 .data	     = svc},
+		{.name	     = "at_estimator",
+		 .read_fptr  = ptlrpc_lprocfs_rd_at_estimator,
+		 .write_fptr = ptlrpc_lprocfs_wr_at_estimator,
+		 .data	     = svc},
                 {.name       = "nrs_policies",
 		 .read_fptr  = ptlrpc_lprocfs_rd_nrs,
 		 .write_fptr = ptlrpc_lprocfs_wr_nrs,
@@ -1391,4 +1544,47 @@ int lprocfs_wr_pinger_recov(struct file *file, const char *buffer,
 }
 EXPORT_SYMBOL(lprocfs_wr_pinger_recov);
 
+int lprocfs_rd_idle_timeout(char *page, char **start, off_t off,
+			    int count, int *eof, void *data)
+{
+	struct obd_device *obd = data;
+	struct obd_import *imp = obd->u.cli.cl_import;
+	int rc;
+
+	LPROCFS_CLIMP_CHECK(obd);
+	rc = snprintf(page, count, "%d\n", imp->imp_idle_timeout);
+	LPROCFS_CLIMP_EXIT(obd);
+
+	return rc;
+}
+EXPORT_SYMBOL(lprocfs_rd_idle_timeout);
+
+/**
+ * Seconds without use after which the import disconnects from the target,
+ * until the next request connects it again.  0 keeps it connected.
+ */
+int lprocfs_wr_idle_timeout(struct file *file, const char *buffer,
+			    unsigned long count, void *data)
+{
+	struct obd_device *obd = data;
+	struct obd_import *imp = obd->u.cli.cl_import;
+	int rc, val;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc < 0)
+		return rc;
+
+	if (val < 0)
+		return -ERANGE;
+
+	LPROCFS_CLIMP_CHECK(obd);
+	spin_lock(&imp->imp_lock);
+	imp->imp_idle_timeout = val;
+	spin_unlock(&imp->imp_lock);
+	LPROCFS_CLIMP_EXIT(obd);
+
+	return count;
+}
+EXPORT_SYMBOL(lprocfs_wr_idle_timeout);
+
 #endif /* LPROCFS */
@@ -586,6 +586,11 @@ int ptlrpc_send_reply(struct ptlrpc_request *req, int flags)
         lustre_msg_set_opc(req->rq_repmsg,
                 req->rq_reqmsg ? lustre_msg_get_opc(req->rq_reqmsg) : 0);
 
+	/* the reply of a sub-request goes back inside the reply of its
+	 * compound request, packed by the handler of the latter */
+	if (req->rq_batch_sub)
+		return 0;
+
         target_pack_pool_reply(req);
 
         ptlrpc_at_set_reply(req, flags);
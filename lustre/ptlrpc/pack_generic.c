@@ -1713,7 +1713,8 @@ void lustre_swab_connect(struct obd_connect_data *ocd)
                 __swab32s(&ocd->ocd_max_easize);
         if (ocd->ocd_connect_flags & OBD_CONNECT_MAXBYTES)
                 __swab64s(&ocd->ocd_maxbytes);
-        CLASSERT(offsetof(typeof(*ocd), padding1) != 0);
+	if (ocd->ocd_connect_flags & OBD_CONNECT_FLAGS2)
+		__swab64s(&ocd->ocd_connect_flags2);
         CLASSERT(offsetof(typeof(*ocd), padding2) != 0);
         CLASSERT(offsetof(typeof(*ocd), padding3) != 0);
         CLASSERT(offsetof(typeof(*ocd), padding4) != 0);
@@ -2576,6 +2577,125 @@ void lustre_swab_update_reply_buf(struct update_reply *ur)
 }
 EXPORT_SYMBOL(lustre_swab_update_reply_buf);
 
+/* bb_lens are swabbed by lustre_batch_buf_check() once they are known to be
+ * inside the buffer */
+void lustre_swab_batch_buf(struct batch_buf *bb)
+{
+	__swab32s(&bb->bb_magic);
+	__swab32s(&bb->bb_count);
+}
+EXPORT_SYMBOL(lustre_swab_batch_buf);
+
+static inline int lustre_batch_hdr_size(int count)
+{
+	return cfs_size_round(offsetof(struct batch_buf, bb_lens[count]));
+}
+
+/**
+ * Size of a batch buffer carrying \a count messages of \a lens bytes.
+ */
+int lustre_batch_buf_size(int count, __u32 *lens)
+{
+	int size = lustre_batch_hdr_size(count);
+	int i;
+
+	for (i = 0; i < count; i++)
+		size += cfs_size_round(lens[i]);
+	return size;
+}
+EXPORT_SYMBOL(lustre_batch_buf_size);
+
+void lustre_batch_buf_init(struct batch_buf *bb, int count)
+{
+	LASSERT(count > 0 && count <= BATCH_MAX_OPS);
+
+	bb->bb_magic = BATCH_BUFFER_MAGIC;
+	bb->bb_count = count;
+	memset(bb->bb_lens, 0, count * sizeof(bb->bb_lens[0]));
+}
+EXPORT_SYMBOL(lustre_batch_buf_init);
+
+static char *lustre_batch_buf_slot(struct batch_buf *bb, int idx)
+{
+	char *ptr = (char *)bb + lustre_batch_hdr_size(bb->bb_count);
+	int   i;
+
+	for (i = 0; i < idx; i++)
+		ptr += cfs_size_round(bb->bb_lens[i]);
+	return ptr;
+}
+
+/**
+ * Copy message \a msg of \a len bytes into slot \a idx of \a bb, slots
+ * have to be filled in order.  \a len is 0 for a sub-request without reply.
+ */
+void lustre_batch_buf_add(struct batch_buf *bb, int idx,
+			  struct lustre_msg *msg, int len)
+{
+	LASSERT(idx < bb->bb_count);
+
+	bb->bb_lens[idx] = len;
+	if (len > 0)
+		memcpy(lustre_batch_buf_slot(bb, idx), msg, len);
+}
+EXPORT_SYMBOL(lustre_batch_buf_add);
+
+/**
+ * Return the message in slot \a idx of \a bb and its length in \a len,
+ * NULL if the slot is empty.  \a bb must have passed
+ * lustre_batch_buf_check().
+ */
+struct lustre_msg *lustre_batch_buf_msg(struct batch_buf *bb, int idx,
+					int *len)
+{
+	LASSERT(idx < bb->bb_count);
+
+	*len = bb->bb_lens[idx];
+	if (*len == 0)
+		return NULL;
+	return (struct lustre_msg *)lustre_batch_buf_slot(bb, idx);
+}
+EXPORT_SYMBOL(lustre_batch_buf_msg);
+
+/**
+ * Sanity check of a batch buffer of \a len bytes received from the peer:
+ * all the messages it announces must fit into it.  \a swab tells whether
+ * the message lengths still have to be swabbed, the header has been by
+ * lustre_swab_batch_buf() already.
+ */
+int lustre_batch_buf_check(struct batch_buf *bb, int len, int swab)
+{
+	__u64 size;
+	int   i;
+
+	if (len < sizeof(*bb) || bb->bb_magic != BATCH_BUFFER_MAGIC) {
+		CERROR("bad batch buffer: magic %#x, len %d\n",
+		       len < sizeof(*bb) ? 0 : bb->bb_magic, len);
+		return -EPROTO;
+	}
+
+	if (bb->bb_count == 0 || bb->bb_count > BATCH_MAX_OPS ||
+	    lustre_batch_hdr_size(bb->bb_count) > len) {
+		CERROR("bad batch buffer: count %u, len %d\n",
+		       bb->bb_count, len);
+		return -EPROTO;
+	}
+
+	size = lustre_batch_hdr_size(bb->bb_count);
+	for (i = 0; i < bb->bb_count; i++) {
+		if (swab)
+			__swab32s(&bb->bb_lens[i]);
+		size += cfs_size_round((__u64)bb->bb_lens[i]);
+	}
+	if (size > len) {
+		CERROR("bad batch buffer: messages %llu overflow len %d\n",
+		       (unsigned long long)size, len);
+		return -EPROTO;
+	}
+	return 0;
+}
+EXPORT_SYMBOL(lustre_batch_buf_check);
+
 void lustre_swab_swap_layouts(struct mdc_swap_layouts *msl)
 {
 	__swab64s(&msl->msl_flags);
@@ -185,6 +185,34 @@ void ptlrpc_pinger_ir_down(void)
 }
 EXPORT_SYMBOL(ptlrpc_pinger_ir_down);
 
+/**
+ * Check if \a imp has had nothing to do for imp_idle_timeout seconds: no
+ * lock, no RPC in flight or waiting and nothing to replay, open files
+ * included.  Dirty pages are covered by their locks.
+ */
+static int ptlrpc_import_is_idle(struct obd_import *imp)
+{
+	struct ldlm_namespace *ns = imp->imp_obd->obd_namespace;
+	int idle;
+
+	if (imp->imp_idle_timeout == 0 ||
+	    cfs_time_current_sec() - imp->imp_last_use <
+	    imp->imp_idle_timeout)
+		return 0;
+
+	/* any lock holds its resource, which holds the namespace */
+	if (ns != NULL && cfs_atomic_read(&ns->ns_bref) > 0)
+		return 0;
+
+	spin_lock(&imp->imp_lock);
+	idle = cfs_atomic_read(&imp->imp_inflight) == 0 &&
+	       cfs_list_empty(&imp->imp_replay_list) &&
+	       cfs_list_empty(&imp->imp_committed_list);
+	spin_unlock(&imp->imp_lock);
+
+	return idle;
+}
+
 static void ptlrpc_pinger_process_import(struct obd_import *imp,
                                          unsigned long this_ping)
 {
@@ -226,6 +254,9 @@ static void ptlrpc_pinger_process_import(struct obd_import *imp,
                 imp->imp_next_ping = ptlrpc_next_reconnect(imp);
                 if (!imp->imp_no_pinger_recover)
                         ptlrpc_initiate_recovery(imp);
+	} else if (level == LUSTRE_IMP_IDLE) {
+		CDEBUG(D_INFO, "%s->%s: idle, not pinging\n",
+		       imp->imp_obd->obd_uuid.uuid, obd2cli_tgt(imp->imp_obd));
         } else if (level != LUSTRE_IMP_FULL ||
                    imp->imp_obd->obd_no_recov ||
                    imp_is_deactive(imp)) {
@@ -233,6 +264,9 @@ static void ptlrpc_pinger_process_import(struct obd_import *imp,
 		       "or recovery disabled: %s)\n",
 		       imp->imp_obd->obd_uuid.uuid, obd2cli_tgt(imp->imp_obd),
 		       ptlrpc_import_state_name(level));
+	} else if (!force && !force_next && ptlrpc_import_is_idle(imp) &&
+		   ptlrpc_disconnect_idle_import(imp) == 0) {
+		/* the DISCONNECT is as good as a ping */
 	} else if ((imp->imp_pingable && !suppress) || force_next || force) {
 		ptlrpc_ping(imp);
 	}
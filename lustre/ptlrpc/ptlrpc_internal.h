@@ -72,6 +72,7 @@ int ptlrpc_set_import_discon(struct obd_import *imp, __u32 conn_cnt);
 void ptlrpc_handle_failed_import(struct obd_import *imp);
 int ptlrpc_replay_next(struct obd_import *imp, int *inflight);
 void ptlrpc_initiate_recovery(struct obd_import *imp);
+int ptlrpc_disconnect_idle_import(struct obd_import *imp);
 
 int lustre_unpack_req_ptlrpc_body(struct ptlrpc_request *req, int offset);
 int lustre_unpack_rep_ptlrpc_body(struct ptlrpc_request *req, int offset);
@@ -247,7 +248,6 @@ void lustre_put_emerg_rs(struct ptlrpc_reply_state *rs);
 /* pinger.c */
 int ptlrpc_start_pinger(void);
 int ptlrpc_stop_pinger(void);
-void ptlrpc_pinger_sending_on_import(struct obd_import *imp);
 void ptlrpc_pinger_commit_expected(struct obd_import *imp);
 void ptlrpc_pinger_wake_up(void);
 void ptlrpc_ping_import_soon(struct obd_import *imp);
@@ -270,6 +270,10 @@ int  sptlrpc_enc_pool_init(void);
 void sptlrpc_enc_pool_fini(void);
 int sptlrpc_proc_read_enc_pool(char *page, char **start, off_t off, int count,
                                int *eof, void *data);
+int  sptlrpc_msg_pool_init(void);
+void sptlrpc_msg_pool_fini(void);
+int sptlrpc_proc_read_msg_pool(char *page, char **start, off_t off, int count,
+			       int *eof, void *data);
 
 /* sec_lproc.c */
 int  sptlrpc_lproc_init(void);
@@ -89,6 +89,15 @@ CFS_MODULE_PARM(max_ptlrpcds, "i", int, 0644,
 static int ptlrpcd_bind_policy = PDB_POLICY_PAIR;
 CFS_MODULE_PARM(ptlrpcd_bind_policy, "i", int, 0644,
                 "Ptlrpcd threads binding mode.");
+
+static int ptlrpcd_steal = 1;
+CFS_MODULE_PARM(ptlrpcd_steal, "i", int, 0644,
+		"Let idle ptlrpcd threads take RPCs queued on non-partners.");
+
+/* Backlog a ptlrpcd thread of another CPU partition must have before an idle
+ * thread takes some of its RPCs, below that the cost of handling them away
+ * from their partition is not worth it. */
+#define PTLRPCD_STEAL_REMOTE_MIN	4
 #endif
 static struct ptlrpcd *ptlrpcds;
 
@@ -105,6 +114,31 @@ void ptlrpcd_wake(struct ptlrpc_request *req)
 }
 EXPORT_SYMBOL(ptlrpcd_wake);
 
+#ifdef __KERNEL__
+/**
+ * Return the index of the next ptlrpcd thread bound to CPU partition \a cpt,
+ * or -1 if there is none.
+ */
+static int ptlrpcd_select_cpt(int cpt)
+{
+	int idx = ptlrpcds->pd_index;
+	int i;
+
+	if (cpt == CFS_CPT_ANY)
+		return -1;
+
+	for (i = 0; i < ptlrpcds->pd_nthreads; i++) {
+		if (++idx >= ptlrpcds->pd_nthreads)
+			idx = 0;
+		if (ptlrpcds->pd_threads[idx].pc_cpt == cpt) {
+			ptlrpcds->pd_index = idx;
+			return idx;
+		}
+	}
+	return -1;
+}
+#endif
+
 static struct ptlrpcd_ctl *
 ptlrpcd_select_pc(struct ptlrpc_request *req, pdl_policy_t policy, int index)
 {
@@ -118,15 +152,15 @@ ptlrpcd_select_pc(struct ptlrpc_request *req, pdl_policy_t policy, int index)
 	case PDL_POLICY_SAME:
 		idx = smp_processor_id() % ptlrpcds->pd_nthreads;
 		break;
-        case PDL_POLICY_LOCAL:
-                /* Before CPU partition patches available, process it the same
-                 * as "PDL_POLICY_ROUND". */
-# ifdef CFS_CPU_MODE_NUMA
-# warning "fix this code to use new CPU partition APIs"
-# endif
-                /* Fall through to PDL_POLICY_ROUND until the CPU
-                 * CPU partition patches are available. */
-                index = -1;
+	case PDL_POLICY_LOCAL:
+		/* Prefer a thread bound to the CPU partition of the caller,
+		 * idle threads elsewhere steal from it if it falls behind. */
+		idx = ptlrpcd_select_cpt(cfs_cpt_current(cfs_cpt_table, 0));
+		if (idx >= 0)
+			break;
+		/* Fall through to PDL_POLICY_ROUND if no thread is bound to
+		 * this partition. */
+		index = -1;
         case PDL_POLICY_PREFERRED:
 		if (index >= 0 && index < num_online_cpus()) {
                         idx = index % ptlrpcds->pd_nthreads;
@@ -202,35 +236,6 @@ void ptlrpcd_add_rqset(struct ptlrpc_request_set *set)
 }
 EXPORT_SYMBOL(ptlrpcd_add_rqset);
 
-#ifdef __KERNEL__
-/**
- * Return transferred RPCs count.
- */
-static int ptlrpcd_steal_rqset(struct ptlrpc_request_set *des,
-                               struct ptlrpc_request_set *src)
-{
-        cfs_list_t *tmp, *pos;
-        struct ptlrpc_request *req;
-        int rc = 0;
-
-	spin_lock(&src->set_new_req_lock);
-        if (likely(!cfs_list_empty(&src->set_new_requests))) {
-                cfs_list_for_each_safe(pos, tmp, &src->set_new_requests) {
-                        req = cfs_list_entry(pos, struct ptlrpc_request,
-                                             rq_set_chain);
-                        req->rq_set = des;
-                }
-                cfs_list_splice_init(&src->set_new_requests,
-                                     &des->set_requests);
-                rc = cfs_atomic_read(&src->set_new_count);
-                cfs_atomic_add(rc, &des->set_remaining);
-                cfs_atomic_set(&src->set_new_count, 0);
-        }
-	spin_unlock(&src->set_new_req_lock);
-	return rc;
-}
-#endif
-
 /**
  * Requests that are added to the ptlrpcd queue are sent via
  * ptlrpcd_check->ptlrpc_check_set().
@@ -259,7 +264,7 @@ void ptlrpcd_add_req(struct ptlrpc_request *req, pdl_policy_t policy, int idx)
                 /* ptlrpc_check_set will decrease the count */
                 cfs_atomic_inc(&req->rq_set->set_remaining);
 		spin_unlock(&req->rq_lock);
-		wake_up(&req->rq_set->set_waitq);
+		ptlrpc_client_wake_req(req);
 		return;
 	} else {
 		spin_unlock(&req->rq_lock);
@@ -279,13 +284,125 @@ static inline void ptlrpc_reqset_get(struct ptlrpc_request_set *set)
         cfs_atomic_inc(&set->set_refcount);
 }
 
+#ifdef __KERNEL__
+/**
+ * Move the older half of the RPCs queued on \a src, and not picked up by its
+ * thread yet, to \a des if there are at least \a min of them.
+ * Return transferred RPCs count.
+ */
+static int ptlrpcd_steal_reqs(struct ptlrpc_request_set *des,
+			      struct ptlrpc_request_set *src, int min)
+{
+	struct ptlrpc_request *req;
+	int count;
+	int rc = 0;
+
+	spin_lock(&src->set_new_req_lock);
+	count = cfs_atomic_read(&src->set_new_count);
+	if (count >= min) {
+		/* the owner gets to the newer ones as soon as it is
+		 * scheduled again */
+		count = (count + 1) / 2;
+		while (rc < count && !cfs_list_empty(&src->set_new_requests)) {
+			req = cfs_list_entry(src->set_new_requests.next,
+					     struct ptlrpc_request,
+					     rq_set_chain);
+			req->rq_set = des;
+			cfs_list_move_tail(&req->rq_set_chain,
+					   &des->set_requests);
+			ptlrpc_set_req_ready(des, req);
+			rc++;
+		}
+		cfs_atomic_sub(rc, &src->set_new_count);
+		cfs_atomic_add(rc, &des->set_remaining);
+	}
+	spin_unlock(&src->set_new_req_lock);
+	return rc;
+}
+
+static int ptlrpcd_steal_from(struct ptlrpcd_ctl *pc,
+			      struct ptlrpcd_ctl *victim, int min)
+{
+	struct ptlrpc_request_set *ps;
+	int rc = 0;
+
+	spin_lock(&victim->pc_lock);
+	ps = victim->pc_set;
+	if (ps == NULL) {
+		spin_unlock(&victim->pc_lock);
+		return 0;
+	}
+
+	ptlrpc_reqset_get(ps);
+	spin_unlock(&victim->pc_lock);
+
+	if (cfs_atomic_read(&ps->set_new_count) >= min) {
+		rc = ptlrpcd_steal_reqs(pc->pc_set, ps, min);
+		if (rc > 0)
+			CDEBUG(D_RPCTRACE, "transfer %d async RPCs [%d->%d]\n",
+			       rc, victim->pc_index, pc->pc_index);
+	}
+	ptlrpc_reqset_put(ps);
+	return rc;
+}
+
+/**
+ * Take some RPCs queued on other ptlrpcd threads for idle \a pc: from its
+ * partners first, then from the threads of its CPU partition, and at last
+ * from the threads of other partitions with a real backlog.
+ * Return transferred RPCs count.
+ */
+static int ptlrpcd_steal_work(struct ptlrpcd_ctl *pc)
+{
+	struct ptlrpcd_ctl *victim;
+	int first;
+	int local;
+	int pass;
+	int cpt;
+	int rc = 0;
+	int i;
+
+	if (pc->pc_npartners > 0) {
+		first = pc->pc_cursor;
+		do {
+			victim = pc->pc_partners[pc->pc_cursor++];
+			if (pc->pc_cursor >= pc->pc_npartners)
+				pc->pc_cursor = 0;
+			if (victim != NULL)
+				rc = ptlrpcd_steal_from(pc, victim, 1);
+		} while (rc == 0 && pc->pc_cursor != first);
+	}
+
+	if (rc != 0 || !ptlrpcd_steal)
+		return rc;
+
+	cpt = pc->pc_cpt;
+	if (cpt == CFS_CPT_ANY)
+		cpt = cfs_cpt_current(cfs_cpt_table, 1);
+
+	for (pass = 0; pass < 2 && rc == 0; pass++) {
+		for (i = 1; i < ptlrpcds->pd_nthreads && rc == 0; i++) {
+			victim = &ptlrpcds->pd_threads[(pc->pc_index + i) %
+						       ptlrpcds->pd_nthreads];
+			local = victim->pc_cpt == CFS_CPT_ANY ||
+				victim->pc_cpt == cpt;
+			if (local != (pass == 0))
+				continue;
+
+			rc = ptlrpcd_steal_from(pc, victim, local ? 1 :
+						PTLRPCD_STEAL_REMOTE_MIN);
+		}
+	}
+	return rc;
+}
+#endif
+
 /**
  * Check if there is more work to do on ptlrpcd set.
  * Returns 1 if yes.
  */
 static int ptlrpcd_check(struct lu_env *env, struct ptlrpcd_ctl *pc)
 {
-        cfs_list_t *tmp, *pos;
         struct ptlrpc_request *req;
         struct ptlrpc_request_set *set = pc->pc_set;
         int rc = 0;
@@ -295,6 +412,9 @@ static int ptlrpcd_check(struct lu_env *env, struct ptlrpcd_ctl *pc)
         if (cfs_atomic_read(&set->set_new_count)) {
 		spin_lock(&set->set_new_req_lock);
                 if (likely(!cfs_list_empty(&set->set_new_requests))) {
+			cfs_list_for_each_entry(req, &set->set_new_requests,
+						rq_set_chain)
+				ptlrpc_set_req_ready(set, req);
                         cfs_list_splice_init(&set->set_new_requests,
                                              &set->set_requests);
                         cfs_atomic_add(cfs_atomic_read(&set->set_new_count),
@@ -330,22 +450,21 @@ static int ptlrpcd_check(struct lu_env *env, struct ptlrpcd_ctl *pc)
         if (cfs_atomic_read(&set->set_remaining))
                 rc |= ptlrpc_check_set(env, set);
 
-        if (!cfs_list_empty(&set->set_requests)) {
-                /*
-                 * XXX: our set never completes, so we prune the completed
-                 * reqs after each iteration. boy could this be smarter.
-                 */
-                cfs_list_for_each_safe(pos, tmp, &set->set_requests) {
-                        req = cfs_list_entry(pos, struct ptlrpc_request,
-                                             rq_set_chain);
-                        if (req->rq_phase != RQ_PHASE_COMPLETE)
-                                continue;
-
-                        cfs_list_del_init(&req->rq_set_chain);
-                        req->rq_set = NULL;
-                        ptlrpc_req_finished(req);
-                }
-        }
+	/*
+	 * Our set never completes, so we prune the completed reqs after each
+	 * iteration, ptlrpc_check_set() keeps them at the head of the set.
+	 */
+	while (!cfs_list_empty(&set->set_requests)) {
+		req = cfs_list_entry(set->set_requests.next,
+				     struct ptlrpc_request, rq_set_chain);
+		if (req->rq_phase != RQ_PHASE_COMPLETE)
+			break;
+
+		ptlrpc_set_req_unready(set, req);
+		cfs_list_del_init(&req->rq_set_chain);
+		req->rq_set = NULL;
+		ptlrpc_req_finished(req);
+	}
 
         if (rc == 0) {
                 /*
@@ -354,41 +473,12 @@ static int ptlrpcd_check(struct lu_env *env, struct ptlrpcd_ctl *pc)
                 rc = cfs_atomic_read(&set->set_new_count);
 
 #ifdef __KERNEL__
-                /* If we have nothing to do, check whether we can take some
-                 * work from our partner threads. */
-                if (rc == 0 && pc->pc_npartners > 0) {
-                        struct ptlrpcd_ctl *partner;
-                        struct ptlrpc_request_set *ps;
-                        int first = pc->pc_cursor;
-
-                        do {
-                                partner = pc->pc_partners[pc->pc_cursor++];
-                                if (pc->pc_cursor >= pc->pc_npartners)
-                                        pc->pc_cursor = 0;
-                                if (partner == NULL)
-                                        continue;
-
-				spin_lock(&partner->pc_lock);
-				ps = partner->pc_set;
-				if (ps == NULL) {
-					spin_unlock(&partner->pc_lock);
-					continue;
-				}
-
-				ptlrpc_reqset_get(ps);
-				spin_unlock(&partner->pc_lock);
-
-                                if (cfs_atomic_read(&ps->set_new_count)) {
-                                        rc = ptlrpcd_steal_rqset(set, ps);
-                                        if (rc > 0)
-                                                CDEBUG(D_RPCTRACE, "transfer %d"
-                                                       " async RPCs [%d->%d]\n",
-                                                        rc, partner->pc_index,
-                                                        pc->pc_index);
-                                }
-                                ptlrpc_reqset_put(ps);
-                        } while (rc == 0 && pc->pc_cursor != first);
-                }
+		/* If we have nothing to do, check whether we can take some
+		 * work from other threads. The recovery thread only handles
+		 * its own RPCs. */
+		if (rc == 0 && pc->pc_index >= 0 &&
+		    !test_bit(LIOD_STOP, &pc->pc_flags))
+			rc = ptlrpcd_steal_work(pc);
 #endif
         }
 
@@ -445,11 +535,10 @@ static int ptlrpcd(void *arg)
          */
         do {
                 struct l_wait_info lwi;
-                int timeout;
 
-                timeout = ptlrpc_set_next_timeout(set);
-                lwi = LWI_TIMEOUT(cfs_time_seconds(timeout ? timeout : 1),
-                                  ptlrpc_expired_set, set);
+		/* ptlrpc_check_set() looks at the whole set once a second,
+		 * walking it for the next timeout is not worth it */
+		lwi = LWI_TIMEOUT(cfs_time_seconds(1), ptlrpc_expired_set, set);
 
                 lu_context_enter(&env.le_ctx);
                 l_wait_event(set->set_waitq,
@@ -621,6 +710,10 @@ static int ptlrpcd_bind(int index, int max)
                 }
         }
 
+	if (rc == 0 && test_bit(LIOD_BIND, &pc->pc_flags) &&
+	    index < num_possible_cpus())
+		pc->pc_cpt = cfs_cpt_of_cpu(cfs_cpt_table, index);
+
         RETURN(rc);
 }
 
@@ -686,6 +779,7 @@ int ptlrpcd_start(int index, int max, const char *name, struct ptlrpcd_ctl *pc)
 	}
 
 	pc->pc_index = index;
+	pc->pc_cpt = CFS_CPT_ANY;
 	init_completion(&pc->pc_starting);
 	init_completion(&pc->pc_finishing);
 	spin_lock_init(&pc->pc_lock);
@@ -693,6 +787,7 @@ int ptlrpcd_start(int index, int max, const char *name, struct ptlrpcd_ctl *pc)
         pc->pc_set = ptlrpc_prep_set();
         if (pc->pc_set == NULL)
                 GOTO(out, rc = -ENOMEM);
+	pc->pc_set->set_events = 1;
 
 #ifndef __KERNEL__
         pc->pc_wait_callback =
@@ -389,7 +389,8 @@ int ptlrpc_import_in_recovery(struct obd_import *imp)
 	spin_lock(&imp->imp_lock);
 	if (imp->imp_state == LUSTRE_IMP_FULL ||
 	    imp->imp_state == LUSTRE_IMP_CLOSED ||
-	    imp->imp_state == LUSTRE_IMP_DISCON)
+	    imp->imp_state == LUSTRE_IMP_DISCON ||
+	    imp->imp_state == LUSTRE_IMP_IDLE)
 		in_recovery = 0;
 	spin_unlock(&imp->imp_lock);
 	return in_recovery;
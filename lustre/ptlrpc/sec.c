@@ -2545,9 +2545,13 @@ int sptlrpc_init(void)
         if (rc)
                 goto out_conf;
 
+	rc = sptlrpc_msg_pool_init();
+	if (rc)
+		goto out_pool;
+
         rc = sptlrpc_null_init();
         if (rc)
-                goto out_pool;
+                goto out_msg_pool;
 
         rc = sptlrpc_plain_init();
         if (rc)
@@ -2563,6 +2567,8 @@ out_plain:
         sptlrpc_plain_fini();
 out_null:
         sptlrpc_null_fini();
+out_msg_pool:
+	sptlrpc_msg_pool_fini();
 out_pool:
         sptlrpc_enc_pool_fini();
 out_conf:
@@ -2578,6 +2584,7 @@ void sptlrpc_fini(void)
         sptlrpc_lproc_fini();
         sptlrpc_plain_fini();
         sptlrpc_null_fini();
+	sptlrpc_msg_pool_fini();
         sptlrpc_enc_pool_fini();
         sptlrpc_conf_fini();
         sptlrpc_gc_fini();
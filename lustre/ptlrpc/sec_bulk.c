@@ -781,8 +781,252 @@ void sptlrpc_enc_pool_fini(void)
 	}
 }
 
+/****************************************
+ * message buffer pools                 *
+ ****************************************/
+
+/*
+ * Request and reply message buffers are allocated with power of 2 sizes by
+ * the security policies, one for each RPC. Keep some free buffers of each
+ * size class from 1K to 64K, shared by all imports, so that most RPCs are
+ * prepared without any allocation; above 16K this also saves vmalloc().
+ */
+#define MSG_POOL_MIN_SHIFT      (10)
+#define MSG_POOL_MAX_SHIFT      (16)
+#define MSG_POOL_NCLASSES       (MSG_POOL_MAX_SHIFT - MSG_POOL_MIN_SHIFT + 1)
+/* memory kept free in each size class at most */
+#define MSG_POOL_CLASS_BYTES    (1 << 20)
+
+static struct ptlrpc_msg_pool {
+	spinlock_t       mp_lock;
+	cfs_list_t       mp_free;         /* free buffers */
+	int              mp_nfree;        /* # of free buffers */
+	int              mp_max;          /* max free buffers kept, const */
+
+	/*
+	 * statistics
+	 */
+	unsigned long    mp_st_hits;      /* # of gets served from the pool */
+	unsigned long    mp_st_misses;    /* # of gets which allocated */
+	unsigned long    mp_st_drops;     /* # of puts freed as pool is full */
+} msg_pools[MSG_POOL_NCLASSES];
+
+static struct shrinker *msg_pools_shrinker;
+
+static inline int msg_pool_index(int size)
+{
+	int shift;
+
+	if (size <= 0 || (size & (size - 1)) != 0)
+		return -1;
+
+	shift = ffs(size) - 1;
+	if (shift < MSG_POOL_MIN_SHIFT || shift > MSG_POOL_MAX_SHIFT)
+		return -1;
+
+	return shift - MSG_POOL_MIN_SHIFT;
+}
+
+/**
+ * Return a zeroed message buffer of \a size bytes, or NULL.
+ */
+void *sptlrpc_msg_pool_get(int size)
+{
+	struct ptlrpc_msg_pool *pool;
+	void                   *buf = NULL;
+	int                     idx = msg_pool_index(size);
+
+	if (idx >= 0) {
+		pool = &msg_pools[idx];
+
+		spin_lock(&pool->mp_lock);
+		if (!cfs_list_empty(&pool->mp_free)) {
+			buf = pool->mp_free.next;
+			cfs_list_del((cfs_list_t *)buf);
+			pool->mp_nfree--;
+			pool->mp_st_hits++;
+		} else {
+			pool->mp_st_misses++;
+		}
+		spin_unlock(&pool->mp_lock);
+
+		if (buf != NULL) {
+			memset(buf, 0, size);
+			return buf;
+		}
+	}
+
+	OBD_ALLOC_LARGE(buf, size);
+	return buf;
+}
+EXPORT_SYMBOL(sptlrpc_msg_pool_get);
+
+/**
+ * Release message buffer \a buf of \a size bytes got from
+ * sptlrpc_msg_pool_get().
+ */
+void sptlrpc_msg_pool_put(void *buf, int size)
+{
+	struct ptlrpc_msg_pool *pool;
+	int                     idx = msg_pool_index(size);
+
+	if (idx >= 0) {
+		pool = &msg_pools[idx];
+
+		spin_lock(&pool->mp_lock);
+		if (pool->mp_nfree < pool->mp_max) {
+			cfs_list_add((cfs_list_t *)buf, &pool->mp_free);
+			pool->mp_nfree++;
+			spin_unlock(&pool->mp_lock);
+			return;
+		}
+		pool->mp_st_drops++;
+		spin_unlock(&pool->mp_lock);
+	}
+
+	OBD_FREE_LARGE(buf, size);
+}
+EXPORT_SYMBOL(sptlrpc_msg_pool_put);
+
+/*
+ * free at most \a nr buffers of \a pool, return how many were freed.
+ */
+static int msg_pool_release(struct ptlrpc_msg_pool *pool, int size, int nr)
+{
+	CFS_LIST_HEAD(release);
+	cfs_list_t *buf;
+	int         n = 0;
+
+	spin_lock(&pool->mp_lock);
+	while (n < nr && !cfs_list_empty(&pool->mp_free)) {
+		cfs_list_move(pool->mp_free.next, &release);
+		pool->mp_nfree--;
+		n++;
+	}
+	spin_unlock(&pool->mp_lock);
+
+	while (!cfs_list_empty(&release)) {
+		buf = release.next;
+		cfs_list_del(buf);
+		OBD_FREE_LARGE(buf, size);
+	}
+	return n;
+}
+
+static int msg_pools_shrink(SHRINKER_ARGS(sc, nr_to_scan, gfp_mask))
+{
+	int nr = shrink_param(sc, nr_to_scan);
+	int total = 0;
+	int i;
+
+	for (i = MSG_POOL_NCLASSES - 1; i >= 0; i--) {
+		if (nr > 0)
+			nr -= msg_pool_release(&msg_pools[i],
+					       1 << (i + MSG_POOL_MIN_SHIFT), nr);
+		total += msg_pools[i].mp_nfree;
+	}
+	return total;
+}
+
+/*
+ * /proc/fs/lustre/sptlrpc/msg_buf_pools
+ */
+int sptlrpc_proc_read_msg_pool(char *page, char **start, off_t off, int count,
+			       int *eof, void *data)
+{
+	struct ptlrpc_msg_pool *pool;
+	int                     rc;
+	int                     i;
+
+	*eof = 1;
+	rc = snprintf(page, count, "%-8s %8s %8s %12s %12s %12s\n",
+		      "size", "free", "max", "hits", "misses", "drops");
+	for (i = 0; i < MSG_POOL_NCLASSES && rc < count; i++) {
+		pool = &msg_pools[i];
+
+		spin_lock(&pool->mp_lock);
+		rc += snprintf(page + rc, count - rc,
+			       "%-8d %8d %8d %12lu %12lu %12lu\n",
+			       1 << (i + MSG_POOL_MIN_SHIFT), pool->mp_nfree,
+			       pool->mp_max, pool->mp_st_hits,
+			       pool->mp_st_misses, pool->mp_st_drops);
+		spin_unlock(&pool->mp_lock);
+	}
+	return min(rc, count);
+}
+
+int sptlrpc_msg_pool_init(void)
+{
+	struct ptlrpc_msg_pool *pool;
+	int                     i;
+
+	for (i = 0; i < MSG_POOL_NCLASSES; i++) {
+		pool = &msg_pools[i];
+
+		spin_lock_init(&pool->mp_lock);
+		CFS_INIT_LIST_HEAD(&pool->mp_free);
+		pool->mp_nfree = 0;
+		pool->mp_max = MSG_POOL_CLASS_BYTES >> (i + MSG_POOL_MIN_SHIFT);
+		pool->mp_st_hits = 0;
+		pool->mp_st_misses = 0;
+		pool->mp_st_drops = 0;
+	}
+
+	msg_pools_shrinker = set_shrinker(pools_shrinker_seeks,
+					  msg_pools_shrink);
+	if (msg_pools_shrinker == NULL)
+		return -ENOMEM;
+
+	return 0;
+}
+
+void sptlrpc_msg_pool_fini(void)
+{
+	struct ptlrpc_msg_pool *pool;
+	int                     i;
+
+	LASSERT(msg_pools_shrinker);
+	remove_shrinker(msg_pools_shrinker);
+
+	for (i = 0; i < MSG_POOL_NCLASSES; i++) {
+		pool = &msg_pools[i];
+
+		msg_pool_release(pool, 1 << (i + MSG_POOL_MIN_SHIFT),
+				 pool->mp_nfree);
+		LASSERT(pool->mp_nfree == 0);
+
+		if (pool->mp_st_hits + pool->mp_st_misses > 0)
+			CDEBUG(D_SEC, "msg pool %d: hits %lu, misses %lu, "
+			       "drops %lu\n", 1 << (i + MSG_POOL_MIN_SHIFT),
+			       pool->mp_st_hits, pool->mp_st_misses,
+			       pool->mp_st_drops);
+	}
+}
+
 #else /* !__KERNEL__ */
 
+void *sptlrpc_msg_pool_get(int size)
+{
+	void *buf;
+
+	OBD_ALLOC_LARGE(buf, size);
+	return buf;
+}
+
+void sptlrpc_msg_pool_put(void *buf, int size)
+{
+	OBD_FREE_LARGE(buf, size);
+}
+
+int sptlrpc_msg_pool_init(void)
+{
+	return 0;
+}
+
+void sptlrpc_msg_pool_fini(void)
+{
+}
+
 int sptlrpc_enc_pool_get_pages(struct ptlrpc_bulk_desc *desc)
 {
         return 0;
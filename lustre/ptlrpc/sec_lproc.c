@@ -176,6 +176,7 @@ EXPORT_SYMBOL(sptlrpc_lprocfs_cliobd_attach);
 
 static struct lprocfs_vars sptlrpc_lprocfs_vars[] = {
         { "encrypt_page_pools", sptlrpc_proc_read_enc_pool, NULL, NULL },
+	{ "msg_buf_pools", sptlrpc_proc_read_msg_pool, NULL, NULL },
         { NULL }
 };
 
@@ -171,7 +171,7 @@ int null_alloc_reqbuf(struct ptlrpc_sec *sec,
                 int alloc_size = size_roundup_power2(msgsize);
 
                 LASSERT(!req->rq_pool);
-                OBD_ALLOC_LARGE(req->rq_reqbuf, alloc_size);
+		req->rq_reqbuf = sptlrpc_msg_pool_get(alloc_size);
                 if (!req->rq_reqbuf)
                         return -ENOMEM;
 
@@ -198,7 +198,7 @@ void null_free_reqbuf(struct ptlrpc_sec *sec,
                          "req %p: reqlen %d should smaller than buflen %d\n",
                          req, req->rq_reqlen, req->rq_reqbuf_len);
 
-                OBD_FREE_LARGE(req->rq_reqbuf, req->rq_reqbuf_len);
+		sptlrpc_msg_pool_put(req->rq_reqbuf, req->rq_reqbuf_len);
                 req->rq_reqbuf = NULL;
                 req->rq_reqbuf_len = 0;
         }
@@ -214,7 +214,7 @@ int null_alloc_repbuf(struct ptlrpc_sec *sec,
 
         msgsize = size_roundup_power2(msgsize);
 
-        OBD_ALLOC_LARGE(req->rq_repbuf, msgsize);
+	req->rq_repbuf = sptlrpc_msg_pool_get(msgsize);
         if (!req->rq_repbuf)
                 return -ENOMEM;
 
@@ -228,7 +228,7 @@ void null_free_repbuf(struct ptlrpc_sec *sec,
 {
         LASSERT(req->rq_repbuf);
 
-        OBD_FREE_LARGE(req->rq_repbuf, req->rq_repbuf_len);
+	sptlrpc_msg_pool_put(req->rq_repbuf, req->rq_repbuf_len);
         req->rq_repbuf = NULL;
         req->rq_repbuf_len = 0;
 }
@@ -259,7 +259,7 @@ int null_enlarge_reqbuf(struct ptlrpc_sec *sec,
         if (req->rq_reqbuf_len < newmsg_size) {
                 alloc_size = size_roundup_power2(newmsg_size);
 
-                OBD_ALLOC_LARGE(newbuf, alloc_size);
+		newbuf = sptlrpc_msg_pool_get(alloc_size);
                 if (newbuf == NULL)
                         return -ENOMEM;
 
@@ -273,7 +273,7 @@ int null_enlarge_reqbuf(struct ptlrpc_sec *sec,
 			spin_lock(&req->rq_import->imp_lock);
                 memcpy(newbuf, req->rq_reqbuf, req->rq_reqlen);
 
-                OBD_FREE_LARGE(req->rq_reqbuf, req->rq_reqbuf_len);
+		sptlrpc_msg_pool_put(req->rq_reqbuf, req->rq_reqbuf_len);
                 req->rq_reqbuf = req->rq_reqmsg = newbuf;
                 req->rq_reqbuf_len = alloc_size;
 
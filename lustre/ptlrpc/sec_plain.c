@@ -590,7 +590,7 @@ int plain_alloc_reqbuf(struct ptlrpc_sec *sec,
                 LASSERT(!req->rq_pool);
 
                 alloc_len = size_roundup_power2(alloc_len);
-                OBD_ALLOC_LARGE(req->rq_reqbuf, alloc_len);
+		req->rq_reqbuf = sptlrpc_msg_pool_get(alloc_len);
                 if (!req->rq_reqbuf)
                         RETURN(-ENOMEM);
 
@@ -616,7 +616,7 @@ void plain_free_reqbuf(struct ptlrpc_sec *sec,
 {
         ENTRY;
         if (!req->rq_pool) {
-                OBD_FREE_LARGE(req->rq_reqbuf, req->rq_reqbuf_len);
+		sptlrpc_msg_pool_put(req->rq_reqbuf, req->rq_reqbuf_len);
                 req->rq_reqbuf = NULL;
                 req->rq_reqbuf_len = 0;
         }
@@ -647,7 +647,7 @@ int plain_alloc_repbuf(struct ptlrpc_sec *sec,
 
         alloc_len = size_roundup_power2(alloc_len);
 
-        OBD_ALLOC_LARGE(req->rq_repbuf, alloc_len);
+	req->rq_repbuf = sptlrpc_msg_pool_get(alloc_len);
         if (!req->rq_repbuf)
                 RETURN(-ENOMEM);
 
@@ -660,7 +660,7 @@ void plain_free_repbuf(struct ptlrpc_sec *sec,
                        struct ptlrpc_request *req)
 {
         ENTRY;
-        OBD_FREE_LARGE(req->rq_repbuf, req->rq_repbuf_len);
+	sptlrpc_msg_pool_put(req->rq_repbuf, req->rq_repbuf_len);
         req->rq_repbuf = NULL;
         req->rq_repbuf_len = 0;
         EXIT;
@@ -701,7 +701,7 @@ int plain_enlarge_reqbuf(struct ptlrpc_sec *sec,
         if (req->rq_reqbuf_len < newbuf_size) {
                 newbuf_size = size_roundup_power2(newbuf_size);
 
-                OBD_ALLOC_LARGE(newbuf, newbuf_size);
+		newbuf = sptlrpc_msg_pool_get(newbuf_size);
                 if (newbuf == NULL)
                         RETURN(-ENOMEM);
 
@@ -716,7 +716,7 @@ int plain_enlarge_reqbuf(struct ptlrpc_sec *sec,
 
                 memcpy(newbuf, req->rq_reqbuf, req->rq_reqbuf_len);
 
-                OBD_FREE_LARGE(req->rq_reqbuf, req->rq_reqbuf_len);
+		sptlrpc_msg_pool_put(req->rq_reqbuf, req->rq_reqbuf_len);
                 req->rq_reqbuf = newbuf;
                 req->rq_reqbuf_len = newbuf_size;
                 req->rq_reqmsg = lustre_msg_buf(req->rq_reqbuf,
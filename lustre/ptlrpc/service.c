@@ -125,6 +125,7 @@ ptlrpc_grow_req_bufs(struct ptlrpc_service_part *svcpt, int post)
 	struct ptlrpc_service		  *svc = svcpt->scp_service;
         struct ptlrpc_request_buffer_desc *rqbd;
         int                                rc = 0;
+	int				   grow;
         int                                i;
 
 	if (svcpt->scp_rqbd_allocating)
@@ -140,13 +141,26 @@ ptlrpc_grow_req_bufs(struct ptlrpc_service_part *svcpt, int post)
 	}
 
 	svcpt->scp_rqbd_allocating++;
-	spin_unlock(&svcpt->scp_lock);
 
+	/* the pool ran low again soon after the last growth, grow faster */
+	if (svcpt->scp_nrqbds_total != 0 &&
+	    cfs_time_before(cfs_time_current(),
+			    cfs_time_add(svcpt->scp_rqbd_grow_time,
+				cfs_time_seconds(PTLRPC_RQBD_GROW_INTERVAL)))) {
+		svcpt->scp_rqbd_grow = min(svcpt->scp_rqbd_grow * 2,
+					   svc->srv_nbuf_per_group *
+					   PTLRPC_RQBD_GROW_MAX);
+	} else {
+		svcpt->scp_rqbd_grow = svc->srv_nbuf_per_group;
+	}
+	svcpt->scp_rqbd_grow_time = cfs_time_current();
+	grow = svcpt->scp_rqbd_grow;
+	spin_unlock(&svcpt->scp_lock);
 
-        for (i = 0; i < svc->srv_nbuf_per_group; i++) {
+	for (i = 0; i < grow; i++) {
                 /* NB: another thread might have recycled enough rqbds, we
 		 * need to make sure it wouldn't over-allocate, see LU-1212. */
-		if (svcpt->scp_nrqbds_posted >= svc->srv_nbuf_per_group)
+		if (svcpt->scp_nrqbds_posted >= grow)
 			break;
 
 		rqbd = ptlrpc_alloc_rqbd(svcpt);
@@ -213,6 +227,7 @@ struct ptlrpc_hr_thread {
 	spinlock_t			hrt_lock;
 	wait_queue_head_t		hrt_waitq;
 	cfs_list_t			hrt_queue;	/* RS queue */
+	cfs_list_t			hrt_exports;	/* commit queue */
 	struct ptlrpc_hr_partition	*hrt_partition;
 };
 
@@ -365,6 +380,53 @@ static void rs_batch_fini(struct rs_batch *b)
 
 #define DECLARE_RS_BATCH(b)     struct rs_batch b
 
+/**
+ * Choose the hr thread releasing committed replies of \a exp, always the
+ * same one so that its hrt_lock serializes queueing of the export.
+ */
+static struct ptlrpc_hr_thread *
+ptlrpc_hr_select_exp(struct obd_export *exp)
+{
+	struct ptlrpc_hr_partition	*hrp;
+	unsigned long			hash;
+	int				ncpts;
+
+	ncpts = cfs_cpt_number(ptlrpc_hr.hr_cpt_table);
+	hash = cfs_hash_long((unsigned long)exp, 16);
+	hrp = ptlrpc_hr.hr_partitions[hash % ncpts];
+	/* use the rest of the hash for the thread, "hash % hrp_nthrs" would
+	 * pick the same thread(s) for all exports of a partition whenever
+	 * hrp_nthrs and ncpts have a common factor */
+	return &hrp->hrp_thrs[(hash / ncpts) % hrp->hrp_nthrs];
+}
+
+/**
+ * Release committed replies of \a exp from an hr thread.
+ *
+ * Commit callbacks run one per transaction handle in the journal commit
+ * thread, calling ptlrpc_commit_replies() from each of them walks
+ * exp_uncommitted_replies once per handle under its lock.  Instead the
+ * export is queued once, and all the callbacks of a commit that run
+ * before the hr thread gets to it are served by a single pass up to the
+ * latest exp_last_committed.
+ */
+void ptlrpc_schedule_commit_replies(struct obd_export *exp)
+{
+	struct ptlrpc_hr_thread	*hrt = ptlrpc_hr_select_exp(exp);
+	int			queued = 0;
+
+	spin_lock(&hrt->hrt_lock);
+	if (cfs_list_empty(&exp->exp_commit_list)) {
+		cfs_list_add_tail(&exp->exp_commit_list, &hrt->hrt_exports);
+		class_export_get(exp);
+		queued = 1;
+	}
+	spin_unlock(&hrt->hrt_lock);
+
+	if (queued)
+		wake_up(&hrt->hrt_waitq);
+}
+
 #else /* __KERNEL__ */
 
 #define rs_batch_init(b)        do{}while(0)
@@ -372,7 +434,13 @@ static void rs_batch_fini(struct rs_batch *b)
 #define rs_batch_add(b, r)      ptlrpc_schedule_difficult_reply(r)
 #define DECLARE_RS_BATCH(b)
 
+void ptlrpc_schedule_commit_replies(struct obd_export *exp)
+{
+	ptlrpc_commit_replies(exp);
+}
+
 #endif /* __KERNEL__ */
+EXPORT_SYMBOL(ptlrpc_schedule_commit_replies);
 
 /**
  * Put reply state into a queue for processing because we received
@@ -467,6 +535,16 @@ ptlrpc_server_post_idle_rqbds(struct ptlrpc_service_part *svcpt)
 		rqbd = cfs_list_entry(svcpt->scp_rqbd_idle.next,
 				      struct ptlrpc_request_buffer_desc,
 				      rqbd_list);
+
+		/* enough buffers posted, give memory back after a burst */
+		if (svcpt->scp_nrqbds_posted >=
+		    svcpt->scp_rqbd_grow * PTLRPC_RQBD_SHRINK_FACTOR) {
+			cfs_list_del_init(&rqbd->rqbd_list);
+			spin_unlock(&svcpt->scp_lock);
+			ptlrpc_free_rqbd(rqbd);
+			continue;
+		}
+
 		cfs_list_del(&rqbd->rqbd_list);
 
 		/* assume we will post successfully */
@@ -625,6 +703,7 @@ ptlrpc_service_part_init(struct ptlrpc_service *svc,
 
 	svcpt->scp_cpt = cpt;
 	CFS_INIT_LIST_HEAD(&svcpt->scp_threads);
+	do_gettimeofday(&svcpt->scp_load_time);
 
 	/* rqbd and incoming request queue */
 	spin_lock_init(&svcpt->scp_lock);
@@ -780,6 +859,7 @@ ptlrpc_register_service(struct ptlrpc_service_conf *conf,
 	spin_lock_init(&service->srv_lock);
 	service->srv_name		= conf->psc_name;
 	service->srv_watchdog_factor	= conf->psc_watchdog_factor;
+	service->srv_thrs_wait_target	= PTLRPC_THRS_WAIT_TARGET;
 	CFS_INIT_LIST_HEAD(&service->srv_list); /* for safty of cleanup */
 
 	/* buffer configuration */
@@ -1013,6 +1093,78 @@ void ptlrpc_request_change_export(struct ptlrpc_request *req,
 	return;
 }
 
+/**
+ * Set up sub-request \a idx of the compound request \a req to be handled
+ * as if it had arrived on its own.  It shares the export, security context
+ * and service of \a req, but its reply is left in its rq_repmsg for the
+ * handler of \a req to collect instead of being sent, see
+ * ptlrpc_send_reply().  \a bb must have passed lustre_batch_buf_check().
+ */
+struct ptlrpc_request *ptlrpc_batch_sub_init(struct ptlrpc_request *req,
+					     struct batch_buf *bb, int idx)
+{
+	struct ptlrpc_request *sub;
+	struct lustre_msg     *msg;
+	int		       len;
+	int		       rc;
+	ENTRY;
+
+	msg = lustre_batch_buf_msg(bb, idx, &len);
+	if (msg == NULL)
+		RETURN(ERR_PTR(-EPROTO));
+
+	sub = ptlrpc_request_cache_alloc(GFP_NOFS);
+	if (sub == NULL)
+		RETURN(ERR_PTR(-ENOMEM));
+
+	*sub = *req;
+	spin_lock_init(&sub->rq_lock);
+	CFS_INIT_LIST_HEAD(&sub->rq_list);
+	CFS_INIT_LIST_HEAD(&sub->rq_timed_list);
+	CFS_INIT_LIST_HEAD(&sub->rq_exp_list);
+	CFS_INIT_LIST_HEAD(&sub->rq_history_list);
+	cfs_atomic_set(&sub->rq_refcount, 1);
+	sub->rq_reply_state = NULL;
+	sub->rq_repmsg = NULL;
+	sub->rq_status = 0;
+	sub->rq_req_swab_mask = 0;
+	sub->rq_rep_swab_mask = 0;
+	sub->rq_pack_bulk = 0;
+	sub->rq_pack_udesc = 0;
+	sub->rq_packed_final = 0;
+	sub->rq_pill_init = 0;
+	sub->rq_at_linked = 0;
+	sub->rq_batch_sub = 1;
+	sub->rq_reqmsg = msg;
+	sub->rq_reqlen = len;
+	sptlrpc_svc_ctx_addref(sub);
+	class_export_get(sub->rq_export);
+
+	rc = ptlrpc_unpack_req_msg(sub, len);
+	if (rc == 0)
+		rc = lustre_unpack_req_ptlrpc_body(sub, MSG_PTLRPC_BODY_OFF);
+	if (rc == 0 && lustre_msg_get_type(msg) != PTL_RPC_MSG_REQUEST)
+		rc = -EPROTO;
+	if (rc != 0) {
+		DEBUG_REQ(D_ERROR, req, "bad sub-request %d: rc = %d", idx, rc);
+		ptlrpc_batch_sub_fini(sub);
+		RETURN(ERR_PTR(-EPROTO));
+	}
+	RETURN(sub);
+}
+EXPORT_SYMBOL(ptlrpc_batch_sub_init);
+
+void ptlrpc_batch_sub_fini(struct ptlrpc_request *sub)
+{
+	LASSERT(sub->rq_batch_sub);
+
+	ptlrpc_req_drop_rs(sub);
+	sptlrpc_svc_ctx_decref(sub);
+	class_export_put(sub->rq_export);
+	ptlrpc_request_cache_free(sub);
+}
+EXPORT_SYMBOL(ptlrpc_batch_sub_fini);
+
 /**
  * to finish a request: stop sending more early replies, and release
  * the request.
@@ -1051,9 +1203,9 @@ static void ptlrpc_server_finish_active_request(
 /**
  * This function makes sure dead exports are evicted in a timely manner.
  * This function is only called when some export receives a message (i.e.,
- * the network is up.)
+ * the network is up), a request or the reply to a callback.
  */
-static void ptlrpc_update_export_timer(struct obd_export *exp, long extra_delay)
+void ptlrpc_update_export_timer(struct obd_export *exp, long extra_delay)
 {
         struct obd_export *oldest_exp;
         time_t oldest_time, new_time;
@@ -1131,6 +1283,7 @@ static void ptlrpc_update_export_timer(struct obd_export *exp, long extra_delay)
 
         EXIT;
 }
+EXPORT_SYMBOL(ptlrpc_update_export_timer);
 
 /**
  * Sanity check request \a req.
@@ -2025,6 +2178,10 @@ ptlrpc_server_handle_request(struct ptlrpc_service_part *svcpt,
 
 	do_gettimeofday(&work_start);
 	timediff = cfs_timeval_sub(&work_start, &request->rq_arrival_time,NULL);
+	if (thread != NULL && timediff > 0) {
+		thread->t_load.tl_nreqs++;
+		thread->t_load.tl_wait += timediff;
+	}
 	if (likely(svc->srv_stats != NULL)) {
                 lprocfs_counter_add(svc->srv_stats, PTLRPC_REQWAIT_CNTR,
                                     timediff);
@@ -2104,6 +2261,8 @@ put_conn:
 
 	do_gettimeofday(&work_end);
 	timediff = cfs_timeval_sub(&work_end, &work_start, NULL);
+	if (thread != NULL && timediff > 0)
+		thread->t_load.tl_busy += timediff;
 	CDEBUG(D_RPCTRACE, "Handled RPC pname:cluuid+ref:pid:xid:nid:opc "
 	       "%s:%s+%d:%d:x"LPU64":%s:%d Request procesed in "
 	       "%ldus (%ldus total) trans "LPU64" rc %d/%d\n",
@@ -2333,9 +2492,12 @@ liblustre_check_services (void *arg)
 static void
 ptlrpc_check_rqbd_pool(struct ptlrpc_service_part *svcpt)
 {
+	struct ptlrpc_service *svc = svcpt->scp_service;
 	int avail = svcpt->scp_nrqbds_posted;
 	int low_water = test_req_buffer_pressure ? 0 :
-			svcpt->scp_service->srv_nbuf_per_group / 2;
+			svcpt->scp_rqbd_grow / 2;
+	cfs_time_t decay = cfs_time_add(svcpt->scp_rqbd_grow_time,
+			cfs_time_seconds(PTLRPC_RQBD_GROW_INTERVAL));
 
         /* NB I'm not locking; just looking. */
 
@@ -2344,11 +2506,23 @@ ptlrpc_check_rqbd_pool(struct ptlrpc_service_part *svcpt)
          * sanity check on that here and cull some history if we need the
          * space. */
 
-        if (avail <= low_water)
+	if (avail <= low_water) {
 		ptlrpc_grow_req_bufs(svcpt, 1);
+	} else if (svcpt->scp_rqbd_grow > svc->srv_nbuf_per_group &&
+		   cfs_time_after(cfs_time_current(), decay)) {
+		/* the burst is over, halve the growth step each interval so
+		 * ptlrpc_server_post_idle_rqbds() frees the extra buffers */
+		spin_lock(&svcpt->scp_lock);
+		if (svcpt->scp_rqbd_grow > svc->srv_nbuf_per_group) {
+			svcpt->scp_rqbd_grow = max(svcpt->scp_rqbd_grow / 2,
+						   svc->srv_nbuf_per_group);
+			svcpt->scp_rqbd_grow_time = cfs_time_current();
+		}
+		spin_unlock(&svcpt->scp_lock);
+	}
 
-	if (svcpt->scp_service->srv_stats) {
-		lprocfs_counter_add(svcpt->scp_service->srv_stats,
+	if (svc->srv_stats) {
+		lprocfs_counter_add(svc->srv_stats,
 				    PTLRPC_REQBUF_AVAIL_CNTR, avail);
 	}
 }
@@ -2393,6 +2567,163 @@ ptlrpc_threads_need_create(struct ptlrpc_service_part *svcpt)
 		ptlrpc_threads_increasable(svcpt);
 }
 
+/**
+ * Sample threads load of \a svcpt once per PTLRPC_THRS_SCALE_INTERVAL and
+ * adjust the number of threads: start one more thread if requests waited
+ * longer than the service target on average, which also covers a queue
+ * building up while ptlrpc_threads_enough() still holds; ask idle threads
+ * to exit if requests hardly waited and threads were mostly idle.
+ */
+static void
+ptlrpc_threads_autoscale(struct ptlrpc_service_part *svcpt)
+{
+	struct ptlrpc_service		*svc = svcpt->scp_service;
+	struct ptlrpc_thread		*thread;
+	struct ptlrpc_thread_load	load;
+	struct timeval			now;
+	__u64				nreqs;
+	__u64				wait;
+	__u64				busy;
+	long				elapsed;
+	int				target = svc->srv_thrs_wait_target;
+	int				running;
+	int				want;
+	int				nstop = 0;
+
+	if (target == 0)
+		return;
+
+	do_gettimeofday(&now);
+	elapsed = cfs_timeval_sub(&now, &svcpt->scp_load_time, NULL);
+	if (elapsed < PTLRPC_THRS_SCALE_INTERVAL * ONE_MILLION)
+		return;
+
+	spin_lock(&svcpt->scp_lock);
+	/* re-check, another thread may have sampled in the meantime */
+	elapsed = cfs_timeval_sub(&now, &svcpt->scp_load_time, NULL);
+	running = svcpt->scp_nthrs_running;
+	if (elapsed < PTLRPC_THRS_SCALE_INTERVAL * ONE_MILLION ||
+	    running == 0) {
+		spin_unlock(&svcpt->scp_lock);
+		return;
+	}
+	svcpt->scp_load_time = now;
+
+	load = svcpt->scp_load_exited;
+	list_for_each_entry(thread, &svcpt->scp_threads, t_link) {
+		load.tl_nreqs += thread->t_load.tl_nreqs;
+		load.tl_wait += thread->t_load.tl_wait;
+		load.tl_busy += thread->t_load.tl_busy;
+	}
+	nreqs = load.tl_nreqs - svcpt->scp_load_last.tl_nreqs;
+	wait = load.tl_wait - svcpt->scp_load_last.tl_wait;
+	busy = load.tl_busy - svcpt->scp_load_last.tl_busy;
+	svcpt->scp_load_last = load;
+
+	if (nreqs != 0)
+		do_div(wait, nreqs);
+	/* msec, so that 32-bit divisors don't overflow */
+	do_div(busy, 1000);
+	busy *= 100;
+	do_div(busy, running);
+	do_div(busy, max(elapsed / 1000, 1L));
+
+	svcpt->scp_load_wait = wait;
+	svcpt->scp_load_util = min_t(__u64, busy, 100);
+
+	if (svcpt->scp_load_wait > target) {
+		svcpt->scp_nthrs_stopping = 0;
+	} else if (svcpt->scp_load_wait < target / 4 &&
+		   svcpt->scp_load_util < PTLRPC_THRS_UTIL_LOW) {
+		/* enough threads to keep them PTLRPC_THRS_UTIL_LOW busy,
+		 * shrink gradually in case load comes back */
+		want = max(svc->srv_nthrs_cpt_init,
+			   (running * svcpt->scp_load_util +
+			    PTLRPC_THRS_UTIL_LOW - 1) / PTLRPC_THRS_UTIL_LOW);
+		if (want < running)
+			nstop = min(running - want, running / 4 + 1);
+		svcpt->scp_nthrs_stopping = nstop;
+	}
+	spin_unlock(&svcpt->scp_lock);
+
+	CDEBUG(D_RPCTRACE, "%s[%d]: %d threads, wait %ldus, busy %d%%, "
+	       "stopping %d\n", svc->srv_name, svcpt->scp_cpt, running,
+	       svcpt->scp_load_wait, svcpt->scp_load_util, nstop);
+
+	if (svcpt->scp_load_wait > target)
+		ptlrpc_start_thread(svcpt, 0);
+	else if (nstop > 0)
+		wake_up_nr(&svcpt->scp_waitq, nstop);
+}
+
+/**
+ * Idle threads wake up periodically so that the controller can run and
+ * shrink the pool, see ptlrpc_threads_autoscale()
+ */
+static inline int
+ptlrpc_threads_shrinkable(struct ptlrpc_service_part *svcpt)
+{
+	return svcpt->scp_service->srv_thrs_wait_target != 0 &&
+	       svcpt->scp_nthrs_running >
+	       svcpt->scp_service->srv_nthrs_cpt_init;
+}
+
+static inline int
+ptlrpc_threads_shrinking(struct ptlrpc_service_part *svcpt)
+{
+	return svcpt->scp_nthrs_stopping > 0;
+}
+
+/**
+ * Take one of the exits asked by ptlrpc_threads_autoscale(), and free the
+ * reply state this thread added to the pool when it started.
+ *
+ * \retval 1 if \a thread should exit
+ */
+static int
+ptlrpc_thread_shrink(struct ptlrpc_service_part *svcpt,
+		     struct ptlrpc_thread *thread)
+{
+	struct ptlrpc_service		*svc = svcpt->scp_service;
+	struct ptlrpc_reply_state	*rs = NULL;
+
+	if (likely(!ptlrpc_threads_shrinking(svcpt)))
+		return 0;
+
+	spin_lock(&svcpt->scp_lock);
+	if (!ptlrpc_threads_shrinking(svcpt) || thread_is_stopping(thread)) {
+		spin_unlock(&svcpt->scp_lock);
+		return 0;
+	}
+
+	if (svcpt->scp_nthrs_running <= svc->srv_nthrs_cpt_init) {
+		svcpt->scp_nthrs_stopping = 0;
+		spin_unlock(&svcpt->scp_lock);
+		return 0;
+	}
+
+	svcpt->scp_nthrs_stopping--;
+	svcpt->scp_nthrs_running--;
+	thread_clear_flags(thread, SVC_RUNNING);
+	thread_add_flags(thread, SVC_SHRINKING);
+	spin_unlock(&svcpt->scp_lock);
+
+	spin_lock(&svcpt->scp_rep_lock);
+	if (!cfs_list_empty(&svcpt->scp_rep_idle)) {
+		rs = cfs_list_entry(svcpt->scp_rep_idle.next,
+				    struct ptlrpc_reply_state, rs_list);
+		cfs_list_del(&rs->rs_list);
+	}
+	spin_unlock(&svcpt->scp_rep_lock);
+
+	if (rs != NULL)
+		OBD_FREE_LARGE(rs, svc->srv_max_reply_size);
+
+	CDEBUG(D_RPCTRACE, "%s: shrinking thread %s, %d running\n",
+	       svc->srv_name, thread->t_name, svcpt->scp_nthrs_running);
+	return 1;
+}
+
 static inline int
 ptlrpc_thread_stopping(struct ptlrpc_thread *thread)
 {
@@ -2432,12 +2763,17 @@ ptlrpc_wait_event(struct ptlrpc_service_part *svcpt,
 	struct l_wait_info lwi = LWI_TIMEOUT(svcpt->scp_rqbd_timeout,
 					     ptlrpc_retry_rqbds, svcpt);
 
+	if (svcpt->scp_rqbd_timeout == 0 && ptlrpc_threads_shrinkable(svcpt))
+		lwi = LWI_TIMEOUT(cfs_time_seconds(PTLRPC_THRS_SCALE_INTERVAL),
+				  NULL, NULL);
+
 	lc_watchdog_disable(thread->t_watchdog);
 
 	cond_resched();
 
 	l_wait_event_exclusive_head(svcpt->scp_waitq,
 				ptlrpc_thread_stopping(thread) ||
+				ptlrpc_threads_shrinking(svcpt) ||
 				ptlrpc_server_request_incoming(svcpt) ||
 				ptlrpc_server_request_pending(svcpt, false) ||
 				ptlrpc_rqbd_pending(svcpt) ||
@@ -2566,7 +2902,11 @@ static int ptlrpc_main(void *arg)
 		if (ptlrpc_wait_event(svcpt, thread))
 			break;
 
+		if (ptlrpc_thread_shrink(svcpt, thread))
+			break;
+
 		ptlrpc_check_rqbd_pool(svcpt);
+		ptlrpc_threads_autoscale(svcpt);
 
 		if (ptlrpc_threads_need_create(svcpt)) {
 			/* Ignore return code - we tried... */
@@ -2633,6 +2973,20 @@ out:
 		svcpt->scp_nthrs_running--;
 	}
 
+	if ((thread->t_flags & SVC_SHRINKING) && !thread_is_stopping(thread)) {
+		/* nobody else knows about this thread once it is unlinked,
+		 * ptlrpc_svcpt_stop_threads() marks threads SVC_STOPPING
+		 * under scp_lock before waiting for them */
+		svcpt->scp_load_exited.tl_nreqs += thread->t_load.tl_nreqs;
+		svcpt->scp_load_exited.tl_wait += thread->t_load.tl_wait;
+		svcpt->scp_load_exited.tl_busy += thread->t_load.tl_busy;
+		cfs_list_del(&thread->t_link);
+		spin_unlock(&svcpt->scp_lock);
+
+		OBD_FREE_PTR(thread);
+		return rc;
+	}
+
 	thread->t_id = rc;
 	thread_add_flags(thread, SVC_STOPPED);
 
@@ -2650,12 +3004,38 @@ static int hrt_dont_sleep(struct ptlrpc_hr_thread *hrt,
 	spin_lock(&hrt->hrt_lock);
 
 	cfs_list_splice_init(&hrt->hrt_queue, replies);
-	result = ptlrpc_hr.hr_stopping || !cfs_list_empty(replies);
+	result = ptlrpc_hr.hr_stopping || !cfs_list_empty(replies) ||
+		 !cfs_list_empty(&hrt->hrt_exports);
 
 	spin_unlock(&hrt->hrt_lock);
 	return result;
 }
 
+/**
+ * Release committed replies of the exports queued on \a hrt by
+ * ptlrpc_schedule_commit_replies().
+ */
+static void ptlrpc_hr_commit_exports(struct ptlrpc_hr_thread *hrt)
+{
+	struct obd_export *exp;
+
+	spin_lock(&hrt->hrt_lock);
+	while (!cfs_list_empty(&hrt->hrt_exports)) {
+		exp = cfs_list_entry(hrt->hrt_exports.next,
+				     struct obd_export, exp_commit_list);
+		/* a commit from now on queues the export again */
+		cfs_list_del_init(&exp->exp_commit_list);
+		spin_unlock(&hrt->hrt_lock);
+
+		if (!ptlrpc_hr.hr_stopping)
+			ptlrpc_commit_replies(exp);
+		class_export_put(exp);
+
+		spin_lock(&hrt->hrt_lock);
+	}
+	spin_unlock(&hrt->hrt_lock);
+}
+
 /**
  * Main body of "handle reply" function.
  * It processes acked reply states
@@ -2684,6 +3064,8 @@ static int ptlrpc_hr_main(void *arg)
 	while (!ptlrpc_hr.hr_stopping) {
 		l_wait_condition(hrt->hrt_waitq, hrt_dont_sleep(hrt, &replies));
 
+		ptlrpc_hr_commit_exports(hrt);
+
                 while (!cfs_list_empty(&replies)) {
                         struct ptlrpc_reply_state *rs;
 
@@ -2695,6 +3077,9 @@ static int ptlrpc_hr_main(void *arg)
                 }
         }
 
+	/* drop references of exports queued while stopping */
+	ptlrpc_hr_commit_exports(hrt);
+
 	cfs_atomic_inc(&hrp->hrp_nstopped);
 	wake_up(&ptlrpc_hr.hr_waitq);
 
@@ -3012,6 +3397,7 @@ int ptlrpc_hr_init(void)
 			init_waitqueue_head(&hrt->hrt_waitq);
 			spin_lock_init(&hrt->hrt_lock);
 			CFS_INIT_LIST_HEAD(&hrt->hrt_queue);
+			CFS_INIT_LIST_HEAD(&hrt->hrt_exports);
 		}
 	}
 
@@ -3228,6 +3614,8 @@ ptlrpc_service_free(struct ptlrpc_service *svc)
 				 sizeof(__u32) * array->paa_size);
 			array->paa_reqs_count = NULL;
 		}
+
+		at_set_percentile(&svcpt->scp_at_estimate, 0);
 	}
 
 	ptlrpc_service_for_each_part(svcpt, i, svc)
@@ -180,7 +180,11 @@ void lustre_assert_wire_constants(void)
 		 (long long)MDS_HSM_CT_UNREGISTER);
 	LASSERTF(MDS_SWAP_LAYOUTS == 61, "found %lld\n",
 		 (long long)MDS_SWAP_LAYOUTS);
-	LASSERTF(MDS_LAST_OPC == 62, "found %lld\n",
+	LASSERTF(MDS_RMFID == 62, "found %lld\n",
+		 (long long)MDS_RMFID);
+	LASSERTF(MDS_BATCH == 63, "found %lld\n",
+		 (long long)MDS_BATCH);
+	LASSERTF(MDS_LAST_OPC == 64, "found %lld\n",
 		 (long long)MDS_LAST_OPC);
 	LASSERTF(REINT_SETATTR == 1, "found %lld\n",
 		 (long long)REINT_SETATTR);
@@ -996,10 +1000,10 @@ void lustre_assert_wire_constants(void)
 		 (long long)(int)offsetof(struct obd_connect_data, ocd_maxbytes));
 	LASSERTF((int)sizeof(((struct obd_connect_data *)0)->ocd_maxbytes) == 8, "found %lld\n",
 		 (long long)(int)sizeof(((struct obd_connect_data *)0)->ocd_maxbytes));
-	LASSERTF((int)offsetof(struct obd_connect_data, padding1) == 72, "found %lld\n",
-		 (long long)(int)offsetof(struct obd_connect_data, padding1));
-	LASSERTF((int)sizeof(((struct obd_connect_data *)0)->padding1) == 8, "found %lld\n",
-		 (long long)(int)sizeof(((struct obd_connect_data *)0)->padding1));
+	LASSERTF((int)offsetof(struct obd_connect_data, ocd_connect_flags2) == 72, "found %lld\n",
+		 (long long)(int)offsetof(struct obd_connect_data, ocd_connect_flags2));
+	LASSERTF((int)sizeof(((struct obd_connect_data *)0)->ocd_connect_flags2) == 8, "found %lld\n",
+		 (long long)(int)sizeof(((struct obd_connect_data *)0)->ocd_connect_flags2));
 	LASSERTF((int)offsetof(struct obd_connect_data, padding2) == 80, "found %lld\n",
 		 (long long)(int)offsetof(struct obd_connect_data, padding2));
 	LASSERTF((int)sizeof(((struct obd_connect_data *)0)->padding2) == 8, "found %lld\n",
@@ -1160,6 +1164,16 @@ void lustre_assert_wire_constants(void)
 		 OBD_CONNECT_PINGLESS);
 	LASSERTF(OBD_CONNECT_FLOCK_DEAD == 0x8000000000000ULL, "found 0x%.16llxULL\n",
 	         OBD_CONNECT_FLOCK_DEAD);
+	LASSERTF(OBD_CONNECT_OPEN_BY_FID == 0x20000000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT_OPEN_BY_FID);
+	LASSERTF(OBD_CONNECT_LFSCK == 0x40000000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT_LFSCK);
+	LASSERTF(OBD_CONNECT_AST_ALIVE == 0x80000000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT_AST_ALIVE);
+	LASSERTF(OBD_CONNECT_FLAGS2 == 0x8000000000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT_FLAGS2);
+	LASSERTF(OBD_CONNECT2_BATCH_RPCS == 0x8000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_BATCH_RPCS);
 	LASSERTF(OBD_CKSUM_CRC32 == 0x00000001UL, "found 0x%.8xUL\n",
 		(unsigned)OBD_CKSUM_CRC32);
 	LASSERTF(OBD_CKSUM_ADLER == 0x00000002UL, "found 0x%.8xUL\n",
@@ -4528,5 +4542,21 @@ void lustre_assert_wire_constants(void)
 		 (long long)(int)offsetof(struct update, u_bufs));
 	LASSERTF((int)sizeof(((struct update *)0)->u_bufs) == 0, "found %lld\n",
 		 (long long)(int)sizeof(((struct update *)0)->u_bufs));
+
+	/* Checks for struct batch_buf */
+	LASSERTF((int)sizeof(struct batch_buf) == 8, "found %lld\n",
+		 (long long)(int)sizeof(struct batch_buf));
+	LASSERTF((int)offsetof(struct batch_buf, bb_magic) == 0, "found %lld\n",
+		 (long long)(int)offsetof(struct batch_buf, bb_magic));
+	LASSERTF((int)sizeof(((struct batch_buf *)0)->bb_magic) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct batch_buf *)0)->bb_magic));
+	LASSERTF((int)offsetof(struct batch_buf, bb_count) == 4, "found %lld\n",
+		 (long long)(int)offsetof(struct batch_buf, bb_count));
+	LASSERTF((int)sizeof(((struct batch_buf *)0)->bb_count) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct batch_buf *)0)->bb_count));
+	LASSERTF((int)offsetof(struct batch_buf, bb_lens) == 8, "found %lld\n",
+		 (long long)(int)offsetof(struct batch_buf, bb_lens));
+	LASSERTF((int)sizeof(((struct batch_buf *)0)->bb_lens) == 0, "found %lld\n",
+		 (long long)(int)sizeof(((struct batch_buf *)0)->bb_lens));
 }
 
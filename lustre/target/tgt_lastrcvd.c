@@ -423,7 +423,7 @@ void tgt_cb_last_committed(struct lu_env *env, struct thandle *th,
 	if (ccb->llcc_transno > ccb->llcc_exp->exp_last_committed) {
 		ccb->llcc_exp->exp_last_committed = ccb->llcc_transno;
 		spin_unlock(&ccb->llcc_tgt->lut_translock);
-		ptlrpc_commit_replies(ccb->llcc_exp);
+		ptlrpc_schedule_commit_replies(ccb->llcc_exp);
 	} else {
 		spin_unlock(&ccb->llcc_tgt->lut_translock);
 	}
@@ -0,0 +1,151 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.txt
+ *
+ * GPL HEADER END
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/tests/at_sim.c
+ *
+ * Replay recorded service times through the adaptive timeout estimators.
+ *
+ * Input lines are "<time> <service_time>" in seconds, e.g. collected from
+ * the "Handled RPC" debug messages of a server.  Each sample is checked
+ * against the current estimate before it is accounted, a sample above the
+ * estimate would have been an early reply or a timeout on a real system.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* includes libcfs.h with DEBUG_SUBSYSTEM set */
+#include "../ptlrpc/at_estimate.c"
+
+unsigned int at_history = 600;
+
+struct at_sim {
+	char			 as_name[8];
+	struct adaptive_timeout	 as_at;
+	struct at_pct		 as_pct;
+	unsigned long		 as_missed;
+	unsigned long long	 as_sum;
+};
+
+static void at_sim_init(struct at_sim *as, int pct)
+{
+	memset(as, 0, sizeof(*as));
+	strcpy(as->as_name, "max");
+	if (pct != 0) {
+		snprintf(as->as_name, sizeof(as->as_name), "p%d", pct);
+		as->as_pct.ap_pct = pct;
+		as->as_at.at_pct = &as->as_pct;
+	}
+}
+
+static void at_sim_account(struct at_sim *as, unsigned int val, time_t now)
+{
+	if (as->as_at.at_binstart != 0 && val > as->as_at.at_current)
+		as->as_missed++;
+
+	at_update(&as->as_at, val, now);
+	as->as_sum += as->as_at.at_current;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-h history] [-p percentile] [-v] [file]\n",
+		prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct at_sim	 sims[2];
+	FILE		*f = stdin;
+	unsigned long	 samples = 0;
+	unsigned long	 when;
+	unsigned int	 val;
+	int		 verbose = 0;
+	int		 pct = 99;
+	int		 c;
+	int		 i;
+
+	while ((c = getopt(argc, argv, "h:p:v")) != -1) {
+		switch (c) {
+		case 'h':
+			at_history = atoi(optarg);
+			break;
+		case 'p':
+			pct = atoi(optarg);
+			if (pct <= 0 || pct >= 100)
+				usage(argv[0]);
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (optind < argc) {
+		f = fopen(argv[optind], "r");
+		if (f == NULL) {
+			perror(argv[optind]);
+			return 1;
+		}
+	}
+
+	at_sim_init(&sims[0], 0);
+	at_sim_init(&sims[1], pct);
+
+	while (fscanf(f, "%lu %u", &when, &val) == 2) {
+		samples++;
+		for (i = 0; i < 2; i++)
+			at_sim_account(&sims[i], val, when);
+
+		if (verbose)
+			printf("%lu %u %u %u\n", when, val,
+			       sims[0].as_at.at_current,
+			       sims[1].as_at.at_current);
+	}
+
+	if (f != stdin)
+		fclose(f);
+
+	if (samples == 0) {
+		fprintf(stderr, "no samples\n");
+		return 1;
+	}
+
+	printf("%lu samples, history %u seconds\n", samples, at_history);
+	for (i = 0; i < 2; i++) {
+		struct at_sim *as = &sims[i];
+
+		printf("%s: mean estimate %.2f, worst %u, above estimate "
+		       "%lu (%.2f%%)\n", as->as_name,
+		       (double)as->as_sum / samples, as->as_at.at_worst_ever,
+		       as->as_missed, 100.0 * as->as_missed / samples);
+	}
+
+	return 0;
+}
@@ -3431,6 +3431,39 @@ test_53b() {
 }
 run_test 53b "check MDS thread count params"
 
+test_53c() {
+	setup
+	local paramp=$(do_facet ost1 \
+		"lctl get_param -N ost.OSS.ost_io.threads_wait_target" \
+		2>/dev/null)
+	if [ -z "$paramp" ]; then
+		skip "no service thread autoscaling on ost1"
+		cleanup
+		return 0
+	fi
+	paramp=${paramp%.threads_wait_target}
+
+	local tmin=$(do_facet ost1 "lctl get_param -n $paramp.threads_min")
+	local i
+
+	# parallel IO starts more service threads
+	for i in $(seq 16); do
+		dd if=/dev/zero of=$DIR/$tfile-$i bs=1M count=64 \
+			oflag=direct 2>/dev/null &
+	done
+	wait
+	echo "threads started under load:" \
+	     $(do_facet ost1 "lctl get_param -n $paramp.threads_started") \
+	     "min $tmin"
+	rm -f $DIR/$tfile-*
+
+	# and the threads of an idle service exit down to threads_min
+	wait_update_facet ost1 "lctl get_param -n $paramp.threads_started" \
+		$tmin 60 || error "idle ost_io threads were not stopped"
+	cleanup
+}
+run_test 53c "idle service threads are stopped"
+
 test_54a() {
 	if [ $(facet_fstype $SINGLEMDS) != ldiskfs ]; then
 		skip "Only applicable to ldiskfs-based MDTs"
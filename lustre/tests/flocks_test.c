@@ -42,6 +42,7 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <sys/file.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 #include <stdarg.h>
 
@@ -438,6 +439,160 @@ out:
 	return rc;
 }
 
+/** ==============================================================
+ * test number 5
+ *
+ * POSIX lock contention stress: every process repeatedly takes write locks
+ * on two random records of a shared file in random order, so lock requests
+ * wait on each other and deadlocks are common. A request failing with
+ * EDEADLK is counted and the process backs off, any other error fails the
+ * test. Reports the lock rate and the number of deadlocks detected.
+ */
+struct t5_stats {
+	long	ts_locks;
+	long	ts_deadlocks;
+};
+
+static int t5_lock(int fd, short type, off_t rec)
+{
+	struct flock lock = {
+		.l_type = type,
+		.l_whence = SEEK_SET,
+		.l_start = rec,
+		.l_len = 1,
+	};
+
+	return fcntl(fd, type == F_UNLCK ? F_SETLK : F_SETLKW, &lock);
+}
+
+static int t5_child(const char *file, int nrecs, int iters,
+		    struct t5_stats *st)
+{
+	off_t rec1;
+	off_t rec2;
+	int fd;
+	int i;
+
+	fd = open(file, O_RDWR);
+	if (fd < 0) {
+		fprintf(stderr, "%d: couldn't open file %s: %s\n",
+			getpid(), file, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	srandom(getpid());
+	for (i = 0; i < iters; i++) {
+		rec1 = random() % nrecs;
+		do {
+			rec2 = random() % nrecs;
+		} while (rec2 == rec1);
+
+		if (t5_lock(fd, F_WRLCK, rec1) < 0)
+			goto fail;
+		if (t5_lock(fd, F_WRLCK, rec2) < 0) {
+			if (errno != EDEADLK)
+				goto fail;
+			st->ts_deadlocks++;
+		} else {
+			st->ts_locks++;
+			t5_lock(fd, F_UNLCK, rec2);
+		}
+		st->ts_locks++;
+		t5_lock(fd, F_UNLCK, rec1);
+	}
+	close(fd);
+	return EXIT_SUCCESS;
+
+fail:
+	fprintf(stderr, "%d: lock failed: %s\n", getpid(), strerror(errno));
+	close(fd);
+	return EXIT_FAILURE;
+}
+
+int t5(int argc, char *argv[])
+{
+	struct t5_stats total = { 0 };
+	struct t5_stats st;
+	struct timeval start;
+	struct timeval end;
+	double elapsed;
+	int nprocs;
+	int nrecs;
+	int iters;
+	int pfd[2];
+	int status;
+	int rc = EXIT_SUCCESS;
+	int fd;
+	int i;
+
+	if (argc != 6) {
+		fprintf(stderr, "Usage: ./flocks_test 5 file nprocs nrecs "
+			"iterations\n");
+		return EXIT_FAILURE;
+	}
+	nprocs = atoi(argv[3]);
+	nrecs = atoi(argv[4]);
+	iters = atoi(argv[5]);
+	if (nprocs < 1 || nrecs < 2 || iters < 1) {
+		fprintf(stderr, "need nprocs >= 1, nrecs >= 2, "
+			"iterations >= 1\n");
+		return EXIT_FAILURE;
+	}
+
+	fd = open(argv[2], O_RDWR | O_CREAT, (mode_t)0666);
+	if (fd < 0) {
+		fprintf(stderr, "Couldn't open file: %s\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+	close(fd);
+
+	if (pipe(pfd) < 0) {
+		perror("pipe");
+		return EXIT_FAILURE;
+	}
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < nprocs; i++) {
+		pid_t pid = fork();
+
+		if (pid == -1) {
+			perror("fork");
+			rc = EXIT_FAILURE;
+			break;
+		}
+		if (pid == 0) {
+			memset(&st, 0, sizeof(st));
+			close(pfd[0]);
+			rc = t5_child(argv[2], nrecs, iters, &st);
+			if (write(pfd[1], &st, sizeof(st)) != sizeof(st))
+				rc = EXIT_FAILURE;
+			exit(rc);
+		}
+	}
+	close(pfd[1]);
+
+	while (wait(&status) > 0) {
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			rc = EXIT_FAILURE;
+	}
+	gettimeofday(&end, NULL);
+
+	while (read(pfd[0], &st, sizeof(st)) == sizeof(st)) {
+		total.ts_locks += st.ts_locks;
+		total.ts_deadlocks += st.ts_deadlocks;
+	}
+	close(pfd[0]);
+
+	elapsed = (end.tv_sec - start.tv_sec) +
+		  (end.tv_usec - start.tv_usec) / 1000000.0;
+	printf("%d procs, %d records: %ld locks, %ld deadlocks in %.2fs, "
+	       "%.0f locks/s\n", nprocs, nrecs, total.ts_locks,
+	       total.ts_deadlocks, elapsed,
+	       elapsed > 0 ? total.ts_locks / elapsed : 0);
+
+	return rc;
+}
+
 /** ==============================================================
  * program entry
  */
@@ -470,6 +625,9 @@ int main(int argc, char* argv[])
 	case 4:
 		rc = t4(argc, argv);
 		break;
+	case 5:
+		rc = t5(argc, argv);
+		break;
         default:
                 fprintf(stderr, "unknow test number %s\n", argv[1]);
                 break;
@@ -157,6 +157,190 @@ test_smoke () {
 }
 run_test smoke "lst regression test"
 
+test_multirail_sub () {
+    local servers=$1
+    local client=$2
+
+    echo '#!/bin/bash'
+    echo 'set -e'
+
+    echo "$LST new_session --timeo 100000 mr"
+    echo "$LST add_group c $client"
+    echo "$LST add_group s $(nids_list $servers)"
+    echo "$LST add_batch b"
+    echo "$LST add_test --batch b --loop $lst_LOOP --concurrency 8" \
+         "--from c --to s brw write check=none size=1M"
+    echo "$LST run b"
+    echo sleep 1
+    echo "$LST stat --delay 10 --count 3 c"
+}
+
+test_multirail () {
+    # peers listed in lnet "peer_rails", except this node
+    local peers=$(awk 'NR > 1 && $3 != "self" { print $1 }' \
+                  /proc/sys/lnet/rails | sort -u)
+    [ -n "$peers" ] ||
+        { skip_env "no multi-rail peer in lnet peer_rails" && return 0; }
+
+    lst_prepare
+
+    local runlst=$TMP/multirail.sh
+    local log=$TMP/$tfile.log
+    local rc
+
+    echo 0 > /proc/sys/lnet/ni_stats
+    test_multirail_sub $(comma_list $peers) $(lctl list_nids | head -1) \
+        > $runlst
+    cat $runlst
+
+    run_lst $runlst | tee $log
+    rc=${PIPESTATUS[0]}
+    [ $rc = 0 ] || error "$runlst failed: $rc"
+
+    lst_end_session --verbose | tee -a $log
+    check_lst_err $log
+    lst_cleanup_all
+
+    cat /proc/sys/lnet/ni_stats /proc/sys/lnet/rails
+    echo "aggregate write bandwidth:" \
+        $(awk '/^\[W\] Avg:.*MB\/s/ { bw = $3 } END { print bw }' $log) MB/s
+
+    # bulk must have been striped over every rail of the peers reachable
+    # on a local net
+    local idle=$(awk 'NR > 1 && $3 != "self" && $3 != "-" && $7 == 0 {
+                      print $2 }' \
+                 /proc/sys/lnet/rails)
+    [ -z "$idle" ] || error "rails not used: $idle"
+}
+run_test multirail "lst bandwidth over multi-rail peers"
+
+test_multirail_resend () {
+    # a multi-rail peer with local NIs on two of its rails, and the index
+    # of the second of these rails in its rail set
+    local peer
+    local rail
+    read peer rail <<< $(awk 'NR > 1 && $3 != "self" {
+                                  if ($1 != p) { p = $1; i = 0; n = 0 }
+                                  if ($3 != "-" && ++n == 2) {
+                                      print $1, i; exit
+                                  }
+                                  i++ }' /proc/sys/lnet/rails)
+    [ -n "$peer" ] ||
+        { skip_env "no multi-rail peer with two local rails" && return 0; }
+
+    local count=100
+    local sent=$(awk '$1 == "'$peer'" { n += $7 } END { print n + 0 }' \
+                 /proc/sys/lnet/rails)
+    local errors=$(awk '$1 == "'$peer'" { n += $9 } END { print n + 0 }' \
+                   /proc/sys/lnet/rails)
+    local drops=$(awk '{ print $7 }' /proc/sys/lnet/stats)
+    local rc=0
+    local i
+
+    # LND sends on that rail fail before anything goes on the wire, each
+    # of them must be resent on another rail and reach the peer once
+    #define CFS_FAIL_LNET_SEND_RAIL          0xe001
+    $LCTL set_param fail_val=$rail fail_loc=0xe001
+    for i in $(seq $count); do
+        $LCTL ping $peer > /dev/null || { rc=$?; break; }
+    done
+    $LCTL set_param fail_loc=0 fail_val=0
+    [ $rc -eq 0 ] || error "ping $i of $peer failed: $rc"
+
+    cat /proc/sys/lnet/rails
+    local failed=$(($(awk '$1 == "'$peer'" { n += $9 } END { print n + 0 }' \
+                    /proc/sys/lnet/rails) - errors))
+    [ $failed -gt 0 ] || error "no send failed on rail $rail of $peer"
+    # every ping GET went out once, and no second REPLY came back for it
+    sent=$(($(awk '$1 == "'$peer'" { n += $7 } END { print n + 0 }' \
+              /proc/sys/lnet/rails) - sent))
+    [ $sent -eq $count ] ||
+        error "$count pings to $peer made $sent successful sends"
+    [ $(awk '{ print $7 }' /proc/sys/lnet/stats) -eq $drops ] ||
+        error "duplicate messages dropped"
+}
+run_test multirail_resend "local send failures are resent once on another rail"
+
+test_ping_rate_sub () {
+    local servers=$1
+    local clients=$2
+    local concr=$3
+
+    echo '#!/bin/bash'
+    echo 'set -e'
+
+    echo "$LST new_session --timeo 100000 pr"
+    echo "$LST add_group c $(nids_list $clients)"
+    echo "$LST add_group s $(nids_list $servers)"
+    echo "$LST add_batch b"
+    echo "$LST add_test --batch b --loop $lst_LOOP --concurrency $concr" \
+         "--distribute 1:1 --from c --to s ping"
+    echo "$LST run b"
+    echo sleep 1
+    echo "$LST stat --delay 5 --count 2 c"
+}
+
+test_ping_rate () {
+    local servers=$lst_SERVERS
+    local clients=$lst_CLIENTS
+    local ncpus=$(grep -c ^processor /proc/cpuinfo)
+    local runlst=$TMP/ping_rate.sh
+    local log=$TMP/$tfile.log
+    local concr=1
+    local rc
+
+    # small message rate stresses the peer lookup on every send/receive,
+    # it should keep scaling with concurrency up to the number of cores
+    while [ $concr -le $ncpus ]; do
+        lst_prepare
+
+        test_ping_rate_sub $servers $clients $concr > $runlst
+        run_lst $runlst | tee $log
+        rc=${PIPESTATUS[0]}
+        [ $rc = 0 ] || error "$runlst failed: $rc"
+
+        lst_end_session --verbose | tee -a $log
+        check_lst_err $log
+        lst_cleanup_all
+
+        echo "concurrency $concr:" \
+            $(awk '/^\[R\] Avg:.*RPC\/s/ { r = $3 } END { print r }' $log) \
+            RPC/s
+        concr=$((concr * 2))
+    done
+}
+run_test ping_rate "lst ping rate against concurrency"
+
+test_lat_hist () {
+    local runlst=$TMP/lat_hist.sh
+    local log=$TMP/$tfile.log
+    local rc
+
+    lst_prepare
+
+    test_ping_rate_sub $lst_SERVERS $lst_CLIENTS 8 |
+        sed -e "s/stat --delay 5 --count 2 c/stat --lat --csv --delay 5 --count 2 c/" \
+        > $runlst
+    run_lst $runlst | tee $log
+    rc=${PIPESTATUS[0]}
+    [ $rc = 0 ] || error "$runlst failed: $rc"
+
+    lst_end_session --verbose | tee -a $log
+    check_lst_err $log
+    lst_cleanup_all
+
+    # one line per client and one for the group, with RPCs counted
+    local nclients=$(echo ${lst_CLIENTS//,/ } | wc -w)
+    local nlines=$(grep -c "^lat,c,.*@" $log)
+    [ $nlines -ge $nclients ] ||
+        error "expect $nclients per-node latency lines, got $nlines"
+    awk -F, '$1 == "lat" && $3 == "total" && $4 > 0 { found = 1 }
+             END { exit !found }' $log ||
+        error "no RPC accounted in latency histograms"
+    grep "^lat,c,total" $log
+}
+run_test lat_hist "lst latency histograms"
+
 complete $SECONDS
 if [ "$RESTORE_MOUNT" = yes ]; then
     setupall
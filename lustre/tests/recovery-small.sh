@@ -1873,6 +1873,37 @@ test_113() {
 }
 run_test 113 "ldlm enqueue dropped reply should not cause deadlocks"
 
+test_114() {
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local expected
+	local listed
+
+	$LCTL get_param -n mdc.$FSNAME-MDT0000-mdc-*.connect_flags |
+		grep -q batch_rpc || { skip "MDS does not batch RPCs"; return 0; }
+
+	mkdir -p $DIR/$tdir || error "mkdir failed"
+	setfattr -n user.a -v 1 $DIR/$tdir || error "setfattr failed"
+	expected=$(getfattr -d -m - $DIR/$tdir | sort)
+
+	save_lustre_params client "llite.*.xattr_cache" > $p
+	$LCTL set_param llite.*.xattr_cache=0
+	cancel_lru_locks mdc
+
+	# a compound request is never resent, the client falls back to
+	# sending its sub-requests one by one
+	#define OBD_FAIL_MDS_BATCH_NET		0x153
+	do_facet $SINGLEMDS "$LCTL set_param fail_loc=0x80000153"
+	listed=$(getfattr -d -m - $DIR/$tdir | sort)
+	do_facet $SINGLEMDS "$LCTL set_param fail_loc=0"
+	restore_lustre_params < $p
+	rm -f $p
+
+	[ "$expected" == "$listed" ] ||
+		error "xattrs differ: '$expected' != '$listed'"
+	rm -rf $DIR/$tdir
+}
+run_test 114 "dropped MDS_BATCH falls back to single RPCs"
+
 complete $SECONDS
 check_and_cleanup_lustre
 exit_status
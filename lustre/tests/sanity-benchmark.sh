@@ -203,6 +203,217 @@ test_fsx() {
 }
 run_test fsx "fsx"
 
+# Many processes hitting the same few files keep looking up the same LDLM
+# resources on the MDS, while a chmod loop keeps conflicting locks cancelled.
+LDLM_CONT_FILES=${LDLM_CONT_FILES:-16}
+LDLM_CONT_ITER=${LDLM_CONT_ITER:-20000}
+[ "$SLOW" = "no" ] && LDLM_CONT_ITER=5000
+
+test_ldlm_contention() {
+	local dir=$DIR/d0.ldlm_contention
+	local nfiles=$LDLM_CONT_FILES
+	local start
+	local elapsed
+	local total
+	local pids=""
+	local rc=0
+	local i
+
+	rm -rf $dir
+	mkdir -p $dir || error "mkdir $dir failed"
+	createmany -o $dir/f $nfiles || error "createmany failed"
+	cancel_lru_locks mdc
+
+	$DEBUG_OFF
+	( while [ -d $dir ]; do
+		chmod -f 0644 $dir/f* ; chmod -f 0600 $dir/f*
+	  done ) &
+	local chmod_pid=$!
+
+	start=$(date +%s.%N)
+	for i in $(seq $THREADS); do
+		statmany -s $dir/f $nfiles $LDLM_CONT_ITER > /dev/null &
+		pids="$pids $!"
+	done
+	for i in $pids; do
+		wait $i || rc=$?
+	done
+	elapsed=$(echo $start $(date +%s.%N) | awk '{ print $2 - $1 }')
+	$DEBUG_ON
+
+	kill $chmod_pid 2> /dev/null
+	wait $chmod_pid 2> /dev/null
+	[ $rc -eq 0 ] || error "statmany failed: rc = $rc"
+
+	total=$((THREADS * LDLM_CONT_ITER))
+	echo "$THREADS threads, $total stats on $nfiles files in $elapsed s:" \
+	     "$(awk "BEGIN { printf \"%d\", $total / $elapsed }") stat/s"
+	do_facet $SINGLEMDS $LCTL get_param -n \
+		"ldlm.namespaces.mdt-*.resource_count" \
+		"ldlm.namespaces.mdt-*.lock_count" || true
+	rm -rf $dir
+}
+run_test ldlm_contention "LDLM resource lookup contention"
+
+LDLM_MEM_FILES=${LDLM_MEM_FILES:-20000}
+[ "$SLOW" = "no" ] && LDLM_MEM_FILES=5000
+
+# print "active_objs objsize" of the ldlm_locks slab on the given facet
+ldlm_lock_slab() {
+	do_facet $1 "awk '/^ldlm_locks / { print \$2, \$4 }' /proc/slabinfo"
+}
+
+test_ldlm_lock_mem() {
+	local dir=$DIR/d0.ldlm_lock_mem
+	local nfiles=$LDLM_MEM_FILES
+	local before
+	local after
+	local size
+	local nlocks
+
+	[ -r /proc/slabinfo ] || { skip "no /proc/slabinfo" && return; }
+
+	rm -rf $dir
+	mkdir -p $dir || error "mkdir $dir failed"
+	createmany -o $dir/f $nfiles || error "createmany failed"
+	cancel_lru_locks mdc
+	cancel_lru_locks osc
+
+	before=($(ldlm_lock_slab client))
+	ls -l $dir > /dev/null || error "ls -l $dir failed"
+	after=($(ldlm_lock_slab client))
+
+	size=${after[1]}
+	nlocks=$((after[0] - before[0]))
+	echo "ldlm_locks object size $size bytes, $nlocks new locks for" \
+	     "$nfiles files: $((nlocks * size / 1024)) KiB"
+	echo "MDS ldlm_locks (objs, size): $(ldlm_lock_slab $SINGLEMDS)"
+
+	cancel_lru_locks mdc
+	cancel_lru_locks osc
+	rm -rf $dir
+}
+run_test ldlm_lock_mem "LDLM lock memory footprint"
+
+PTLRPCD_RATE_FILES=${PTLRPCD_RATE_FILES:-50000}
+[ "$SLOW" = "no" ] && PTLRPCD_RATE_FILES=10000
+
+# Statahead keeps up to statahead_max async getattr RPCs in the ptlrpcd sets,
+# the rate of "ls -l" tells how completion handling scales with the set size.
+test_ptlrpcd_rate() {
+	local dir=$DIR/d0.ptlrpcd_rate
+	local nfiles=$PTLRPCD_RATE_FILES
+	local sa_max=$($LCTL get_param -n llite.*.statahead_max | head -1)
+	local start
+	local elapsed
+	local max
+
+	rm -rf $dir
+	mkdir -p $dir || error "mkdir $dir failed"
+	createmany -o $dir/f $nfiles || error "createmany failed"
+
+	for max in 32 128 512 2048 8192; do
+		$LCTL set_param -n llite.*.statahead_max=$max
+		cancel_lru_locks mdc
+		cancel_lru_locks osc
+
+		start=$(date +%s.%N)
+		ls -l $dir > /dev/null || error "ls -l $dir failed"
+		elapsed=$(echo $start $(date +%s.%N) |
+			  awk '{ print $2 - $1 }')
+		echo "statahead_max $max: $nfiles files in $elapsed s:" \
+		     "$(awk "BEGIN { printf \"%d\", $nfiles / $elapsed }")" \
+		     "stat/s"
+	done
+	$LCTL set_param -n llite.*.statahead_max=$sa_max
+
+	rm -rf $dir
+}
+run_test ptlrpcd_rate "ptlrpcd RPC completion rate against set size"
+
+PTLRPCD_STEAL_MB=${PTLRPCD_STEAL_MB:-1024}
+[ "$SLOW" = "no" ] && PTLRPCD_STEAL_MB=256
+
+# sum of the $2 counts in the stats files $1 on nodes $3, locally if empty
+ptlrpcd_steal_count() {
+	local cmd="$LCTL get_param -n $1"
+
+	if [ -z "$3" ]; then
+		$cmd
+	else
+		do_nodes $3 $cmd
+	fi | awk '$1 == "'$2'" { n += $2 } END { print n + 0 }'
+}
+
+# Writeback of one file per OST, each file half the size of the previous
+# one, queues uneven numbers of async BRW RPCs on the ptlrpcd threads of
+# the OSCs.  Idle threads taking RPCs from busy ones should finish sooner.
+test_ptlrpcd_steal() {
+	local param=/sys/module/ptlrpc/parameters/ptlrpcd_steal
+	local dir=$DIR/d0.ptlrpcd_steal
+	local osts=$(comma_list $(osts_nodes))
+	local old
+	local steal
+	local start
+	local elapsed
+	local sent
+	local handled
+	local size
+	local i
+
+	[ -f $param ] || { skip "no ptlrpcd_steal parameter" && return; }
+	[ $OSTCOUNT -ge 2 ] || { skip "needs >= 2 OSTs" && return; }
+	old=$(cat $param)
+
+	for steal in 0 1; do
+		echo $steal > $param
+		rm -rf $dir
+		mkdir -p $dir || { echo $old > $param; error "mkdir failed"; }
+		for i in $(seq 0 $((OSTCOUNT - 1))); do
+			$LFS setstripe -c 1 -i $i $dir/f$i || {
+				echo $old > $param
+				error "setstripe $dir/f$i failed"
+			}
+		done
+		cancel_lru_locks osc
+		$LCTL set_param -n osc.*.stats=0
+		do_nodes $osts $LCTL set_param -n ost.OSS.ost_io.stats=0
+
+		start=$(date +%s.%N)
+		for i in $(seq 0 $((OSTCOUNT - 1))); do
+			dd if=/dev/zero of=$dir/f$i bs=1M \
+			   count=$((PTLRPCD_STEAL_MB >> i)) 2> /dev/null &
+		done
+		wait
+		sync
+		elapsed=$(echo $start $(date +%s.%N) |
+			  awk '{ print $2 - $1 }')
+		echo "ptlrpcd_steal $steal: $OSTCOUNT OSTs written in" \
+		     "$elapsed s"
+
+		# a lost RPC leaves data unwritten, an RPC run twice is
+		# counted twice by the client, once by the OST
+		for i in $(seq 0 $((OSTCOUNT - 1))); do
+			size=$(stat -c %s $dir/f$i)
+			[ $size -eq $(((PTLRPCD_STEAL_MB >> i) << 20)) ] || {
+				echo $old > $param
+				error "$dir/f$i has $size bytes"
+			}
+		done
+		sent=$(ptlrpcd_steal_count "osc.*.stats" ost_write)
+		handled=$(ptlrpcd_steal_count "ost.OSS.ost_io.stats" \
+			  ost_write $osts)
+		[ $sent -eq $handled ] || {
+			echo $old > $param
+			error "$sent write RPCs completed, $handled handled"
+		}
+	done
+	echo $old > $param
+
+	rm -rf $dir
+}
+run_test ptlrpcd_steal "uneven async load with ptlrpcd_steal 0 and 1"
+
 
 ############################################################
 # PIOS
@@ -6777,6 +6777,20 @@ test_105e() { # bug 22660 && 22040
 }
 run_test 105e "Two conflicting flocks from same process ======="
 
+test_105f() {
+	[ -z "$(mount | grep "$MOUNT.*flock" | grep -v noflock)" ] &&
+		skip "mount w/o flock enabled" && return
+	local nprocs=${FLOCK_PROCS:-32}
+	local iters=${FLOCK_ITER:-500}
+
+	[ "$SLOW" = "no" ] && iters=100
+	touch $DIR/$tfile
+	flocks_test 5 $DIR/$tfile $nprocs $((nprocs / 2 + 2)) $iters ||
+		error "flock contention stress failed"
+	rm -f $DIR/$tfile
+}
+run_test 105f "POSIX lock contention with deadlock detection"
+
 test_106() { #bug 10921
 	test_mkdir -p $DIR/$tdir
 	$DIR/$tdir && error "exec $DIR/$tdir succeeded"
@@ -7688,6 +7702,49 @@ test_120g() {
 }
 run_test 120g "Early Lock Cancel: performance test"
 
+test_120h() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	[ -z "$($LCTL get_param -n mdc.*.connect_flags |
+		grep early_lock_cancel)" ] &&
+		skip "no early lock cancel on server" && return 0
+	local count=100
+	local batch
+	local queued
+	local can1
+	local can2
+
+	test_mkdir -p $DIR/$tdir
+	$SETSTRIPE -c 1 $DIR/$tdir || error "setstripe failed"
+	createmany -o $DIR/$tdir/f $count || error "createmany failed"
+	for i in $(seq 0 $((count - 1))); do
+		echo data > $DIR/$tdir/f$i || error "write f$i failed"
+	done
+	cancel_lru_locks osc
+	cat $DIR/$tdir/f* > /dev/null || error "read failed"
+
+	batch=$($LCTL get_param -n ldlm.namespaces.*osc*.cancel_batch |
+		head -n1)
+	$LCTL set_param -n ldlm.namespaces.*osc*.cancel_batch=$((count * 2))
+	can1=$($LCTL get_param -n ldlm.services.ldlm_canceld.stats |
+	       awk '/ldlm_cancel/ { n = $2 } END { print n + 0 }')
+	rm -f $DIR/$tdir/f*
+	queued=$($LCTL get_param -n ldlm.namespaces.*osc*.cancel_batch_count |
+		 calc_total)
+	echo "$queued deferred cancels after unlink of $count files"
+	# the pool thread sends batches older than a second
+	sleep 3
+	can2=$($LCTL get_param -n ldlm.services.ldlm_canceld.stats |
+	       awk '/ldlm_cancel/ { n = $2 } END { print n + 0 }')
+	$LCTL set_param -n ldlm.namespaces.*osc*.cancel_batch=$batch
+
+	[ $queued -ge $count ] ||
+		error "only $queued of $count cancels deferred"
+	[ $((can2 - can1)) -lt $((count / 4)) ] ||
+		error "$((can2 - can1)) cancel RPCs for $count files"
+	rm -rf $DIR/$tdir
+}
+run_test 120h "Early Lock Cancel: batched OST cancels on unlink"
+
 test_121() { #bug #10589
 	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
 	rm -rf $DIR/$tfile
@@ -7973,6 +8030,65 @@ test_124b() {
 }
 run_test 124b "lru resize (performance test) ======================="
 
+test_124c() {
+	[ -z "$($LCTL get_param -n mdc.*.connect_flags | grep lru_resize)" ] &&
+		skip "no lru resize on server" && return 0
+
+	local pool=ldlm.namespaces.mdt-$FSNAME-MDT0000_UUID.pool
+	local target=$(do_facet $SINGLEMDS $LCTL get_param -n \
+		       $pool.slv_target 2> /dev/null)
+	[ -z "$target" ] && skip "no SLV controller on server" && return 0
+
+	local NR=2000
+	test_mkdir -p $DIR/$tdir || error "failed to create $DIR/$tdir"
+	createmany -o $DIR/$tdir/f $NR ||
+		error "failed to create $NR files in $DIR/$tdir"
+	cancel_lru_locks mdc
+	ls -l $DIR/$tdir > /dev/null
+
+	# out of range tunables have to be rejected
+	local param
+	for param in slv_target=0 slv_target=101 slv_kp=-1 slv_max_step=-1; do
+		do_facet $SINGLEMDS $LCTL set_param -n $pool.$param &&
+			error "$pool.$param was accepted"
+	done
+	[ $(do_facet $SINGLEMDS $LCTL get_param -n $pool.slv_target) -eq \
+	  $target ] || error "slv_target changed by rejected write"
+
+	# goal below the granted locks, SLV has to go down steadily
+	local limit=$(do_facet $SINGLEMDS $LCTL get_param -n $pool.limit)
+	local granted=$(do_facet $SINGLEMDS $LCTL get_param -n $pool.granted)
+	[ $granted -gt $((limit / 100)) ] || {
+		unlinkmany $DIR/$tdir/f $NR
+		skip "granted $granted locks below 1% of limit $limit"
+		return 0
+	}
+	do_facet $SINGLEMDS $LCTL set_param -n $pool.slv_target=1
+	local first=$(do_facet $SINGLEMDS $LCTL get_param -n \
+		      $pool.server_lock_volume)
+	local prev=$first
+	local slv
+	local i
+	for i in $(seq 10); do
+		sleep 1
+		slv=$(do_facet $SINGLEMDS $LCTL get_param -n \
+		      $pool.server_lock_volume)
+		echo "SLV: $slv"
+		[ $slv -le $prev ] || {
+			do_facet $SINGLEMDS $LCTL set_param -n \
+				$pool.slv_target=$target
+			error "SLV grew from $prev to $slv"
+		}
+		prev=$slv
+	done
+	do_facet $SINGLEMDS $LCTL get_param -n $pool.state
+	do_facet $SINGLEMDS $LCTL set_param -n $pool.slv_target=$target
+
+	[ $slv -lt $first ] || error "SLV did not drop: $first -> $slv"
+	unlinkmany $DIR/$tdir/f $NR
+}
+run_test 124c "SLV controller follows target of granted locks"
+
 test_125() { # 13358
 	[ -z "$(lctl get_param -n llite.*.client_type | grep local)" ] && skip "must run as local client" && return
 	[ -z "$(lctl get_param -n mdc.*-mdc-*.connect_flags | grep acl)" ] && skip "must have acl enabled" && return
@@ -11354,10 +11470,11 @@ test_215() { # for bugs 18102, 21079, 21517
 	remove_lnet_proc_files "peers"
 
 	# /proc/sys/lnet/buffers  should look like this:
-	# pages count credits min
-	# where pages >=0, count >=0, credits and min are numeric (0 or >0 or <0)
-	L1="^pages +count +credits +min$"
-	BR="^ +$N +$N +$I +$I$"
+	# pages count credits min waits
+	# where pages >=0, count >=0, credits and min are numeric (0 or >0 or <0),
+	# waits >=0
+	L1="^pages +count +credits +min +waits$"
+	BR="^ +$N +$N +$I +$I +$N$"
 	create_lnet_proc_files "buffers"
 	check_lnet_proc_entry "buffers.out" "/proc/sys/lnet/buffers" "$BR" "$L1"
 	check_lnet_proc_entry "buffers.sys" "lnet.buffers" "$BR" "$L1"
@@ -11375,9 +11492,33 @@ test_215() { # for bugs 18102, 21079, 21517
 	check_lnet_proc_entry "nis.sys" "lnet.nis" "$BR" "$L1"
 	remove_lnet_proc_files "nis"
 
+	# /proc/sys/lnet/ni_stats should look like this:
+	# nid health send_count send_length recv_count recv_length errors
+	# where nid is a string like 192.168.1.1@tcp2, the rest are >= 0
+	L1="^nid +health +send_count +send_length +recv_count +recv_length +errors$"
+	BR="^$NID +$N +$N +$N +$N +$N +$N$"
+	create_lnet_proc_files "ni_stats"
+	check_lnet_proc_entry "ni_stats.out" "/proc/sys/lnet/ni_stats" "$BR" "$L1"
+	check_lnet_proc_entry "ni_stats.sys" "lnet.ni_stats" "$BR" "$L1"
+	remove_lnet_proc_files "ni_stats"
+
+	# /proc/sys/lnet/rails should look like this:
+	# peer rail local health inflight inflt_nob send_count send_length errors
+	# where peer and rail are strings like 192.168.1.1@tcp2, local is
+	# such a string, "self", or "-" if no local NI is on the rail net,
+	# the rest are >= 0
+	L1="^peer +rail +local +health +inflight +inflt_nob +send_count +send_length +errors$"
+	BR="^$NID +$NID +($NID|self|-) +$N +$N +$N +$N +$N +$N$"
+	create_lnet_proc_files "rails"
+	check_lnet_proc_entry "rails.out" "/proc/sys/lnet/rails" "$BR" "$L1"
+	check_lnet_proc_entry "rails.sys" "lnet.rails" "$BR" "$L1"
+	remove_lnet_proc_files "rails"
+
 	# can we successfully write to /proc/sys/lnet/stats?
 	echo "0" >/proc/sys/lnet/stats || error "cannot write to /proc/sys/lnet/stats"
 	sysctl -w lnet.stats=0 || error "cannot write to lnet.stats"
+	echo "0" >/proc/sys/lnet/ni_stats ||
+		error "cannot write to /proc/sys/lnet/ni_stats"
 }
 run_test 215 "/proc/sys/lnet exists and has proper content - bugs 18102, 21079, 21517"
 
@@ -12163,6 +12304,189 @@ test_238() {
 	rm -f $DIR/$tfile*
 }
 run_test 238 "Verify linkea consistency"
+
+# sum of the hits of the sptlrpc message buffer pools
+msg_pool_hits() {
+	$LCTL get_param -n sptlrpc.msg_buf_pools |
+		awk 'NR > 1 { hits += $4 } END { print hits + 0 }'
+}
+
+test_239() {
+	$LCTL get_param -n sptlrpc.msg_buf_pools > /dev/null 2>&1 ||
+		{ skip "no message buffer pools" && return; }
+
+	mkdir -p $DIR/$tdir
+	createmany -o $DIR/$tdir/f 100 || error "createmany failed"
+	cancel_lru_locks mdc
+
+	local before=$(msg_pool_hits)
+	ls -l $DIR/$tdir > /dev/null || error "ls -l $DIR/$tdir failed"
+	local after=$(msg_pool_hits)
+
+	$LCTL get_param sptlrpc.msg_buf_pools
+	[ $after -gt $before ] ||
+		error "no RPC buffer taken from the pools: $before -> $after"
+	rm -rf $DIR/$tdir
+}
+run_test 239 "RPC message buffers are reused from the pools"
+
+test_241() {
+	local osc=$(get_osc_import_name client ost1)
+	local param=osc.$osc.idle_timeout
+	local old=$($LCTL get_param -n $param 2>/dev/null)
+
+	[ -n "$old" ] || { skip "no idle disconnect" && return; }
+
+	$SETSTRIPE -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	$LCTL set_param $param=5
+
+	cancel_lru_locks osc
+	wait_osc_import_state client ost1 IDLE || {
+		$LCTL set_param $param=$old
+		error "$osc did not disconnect"
+	}
+
+	# the next request connects the import again
+	dd if=/dev/zero of=$DIR/$tfile bs=4k count=1 conv=fsync || {
+		$LCTL set_param $param=$old
+		error "write after idle disconnect failed"
+	}
+	wait_osc_import_state client ost1 FULL || {
+		$LCTL set_param $param=$old
+		error "$osc did not reconnect"
+	}
+	$LCTL set_param $param=$old
+
+	cmp -n 4096 $DIR/$tfile /dev/zero || error "data mismatch"
+	rm -f $DIR/$tfile
+}
+run_test 241 "idle imports disconnect and reconnect on use"
+
+# field $1 of the request buffer pool of the MDT service
+mdt_req_buffers() {
+	do_facet $SINGLEMDS $LCTL get_param -n mds.MDS.mdt.req_buffers |
+		awk '$1 == "'$1':" { print $2 }'
+}
+
+test_242() {
+	[ -n "$(mdt_req_buffers total)" ] ||
+		{ skip "no request buffer statistics" && return; }
+
+	local count=1000
+	local rif=$($LCTL get_param -n mdc.*-mdc-*.max_rpcs_in_flight |
+		    head -n1)
+	local i
+
+	test_mkdir -p $DIR/$tdir
+	createmany -o $DIR/$tdir/f $count || error "createmany failed"
+	local before=$(mdt_req_buffers total)
+
+	# burst of uncached getattrs, enough in flight to drain the pool
+	$LCTL set_param -n mdc.*-mdc-*.max_rpcs_in_flight=256
+	cancel_lru_locks mdc
+	for i in $(seq 0 $((count - 1))); do
+		stat $DIR/$tdir/f$i > /dev/null &
+	done
+	wait
+	$LCTL set_param -n mdc.*-mdc-*.max_rpcs_in_flight=$rif
+
+	local peak=$(mdt_req_buffers total)
+	echo "request buffers: $before before the burst, $peak after"
+	if [ $peak -le $before ]; then
+		rm -rf $DIR/$tdir
+		skip "burst did not grow the request buffer pool"
+		return 0
+	fi
+
+	# under light load the pool has to give the extra buffers back
+	local total=$peak
+	local end=$((SECONDS + 60))
+	while [ $SECONDS -lt $end ]; do
+		cancel_lru_locks mdc
+		ls -l $DIR/$tdir > /dev/null || error "ls -l $DIR/$tdir failed"
+		total=$(mdt_req_buffers total)
+		[ $total -lt $peak ] && break
+		sleep 1
+	done
+	do_facet $SINGLEMDS $LCTL get_param mds.MDS.mdt.req_buffers
+
+	[ $total -lt $peak ] ||
+		error "request buffers did not shrink: $before, $peak, $total"
+	rm -rf $DIR/$tdir
+}
+run_test 242 "request buffer pool shrinks after a burst"
+
+test_243() {
+	local param=mds.MDS.mdt.difficult_replies
+
+	[ -n "$(do_facet $SINGLEMDS $LCTL get_param -n $param 2>/dev/null)" ] ||
+		{ skip "no difficult reply count" && return; }
+
+	# replies of the creates wait for the commit, which hr threads act
+	# on once per export
+	test_mkdir -p $DIR/$tdir
+	createmany -o $DIR/$tdir/f 2000 || error "createmany failed"
+	echo "difficult replies: $(do_facet $SINGLEMDS $LCTL get_param -n $param)"
+	do_facet $SINGLEMDS "$LCTL set_param -n osd*.*MDT*.force_sync 1"
+	wait_update_facet $SINGLEMDS "$LCTL get_param -n $param" 0 60 ||
+		error "replies not released after the commit"
+
+	# the export may still be queued for a commit when it is destroyed
+	createmany -o $DIR/$tdir/g 2000 || error "createmany failed"
+	do_facet $SINGLEMDS "$LCTL set_param -n osd*.*MDT*.force_sync 1"
+	umount_client $MOUNT || error "umount failed"
+	mount_client $MOUNT || error "mount failed"
+	check_catastrophe || error "LBUG after export destruction"
+	wait_update_facet $SINGLEMDS "$LCTL get_param -n $param" 0 60 ||
+		error "replies not released after the unmount"
+
+	rm -rf $DIR/$tdir
+}
+run_test 243 "committed replies are released from hr threads"
+
+test_244() {
+	local p="$TMP/sanity-$TESTNAME.parameters"
+	local with_cache
+	local no_cache
+	local before
+	local after
+
+	$LCTL get_param -n mdc.$FSNAME-MDT0000-mdc-*.connect_flags |
+		grep -q batch_rpc || { skip "MDS does not batch RPCs"; return 0; }
+
+	test_mkdir -p $DIR/$tdir
+	$SETSTRIPE -c 1 -S 2097152 $DIR/$tdir || error "setstripe failed"
+	setfattr -n user.a -v 1 $DIR/$tdir || error "setfattr user.a failed"
+	setfattr -n user.b -v 2 $DIR/$tdir || error "setfattr user.b failed"
+
+	save_lustre_params client "llite.*.xattr_cache" > $p
+	$LCTL set_param llite.*.xattr_cache=1
+	cancel_lru_locks mdc
+	with_cache=$(getfattr -d -m - $DIR/$tdir | sort)
+
+	# without the xattr cache listxattr of a directory sends its getxattr
+	# and the getattr for the default stripe in one MDS_BATCH RPC
+	$LCTL set_param llite.*.xattr_cache=0
+	cancel_lru_locks mdc
+	before=$($LCTL get_param -n mdc.$FSNAME-MDT0000-mdc-*.stats |
+		 awk '/mds_batch/ { print $2 }')
+	no_cache=$(getfattr -d -m - $DIR/$tdir | sort)
+	after=$($LCTL get_param -n mdc.$FSNAME-MDT0000-mdc-*.stats |
+		awk '/mds_batch/ { print $2 }')
+	restore_lustre_params < $p
+	rm -f $p
+
+	echo "$no_cache"
+	[ "$with_cache" == "$no_cache" ] ||
+		error "xattrs differ: '$with_cache' != '$no_cache'"
+	echo "$no_cache" | grep -q "lustre.lov" ||
+		error "default stripe is not listed"
+	[ ${after:-0} -gt ${before:-0} ] ||
+		error "no MDS_BATCH RPC sent (${before:-0} -> ${after:-0})"
+
+	rm -rf $DIR/$tdir
+}
+run_test 244 "listxattr of a directory in one MDS_BATCH RPC"
 #
 # tests that do cleanup/setup should be run at the end
 #
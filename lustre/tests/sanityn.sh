@@ -2664,6 +2664,47 @@ test_76() { #LU-946
 }
 run_test 76 "Verify open file for 2048 files"
 
+# number of $2 requests counted in the stats file $1
+stats_count() {
+	$LCTL get_param -n $1 |
+		awk '$1 == "'$2'" { n = $2 } END { print n + 0 }'
+}
+
+test_77() {
+	local inst=$($LFS getname $MOUNT1 | cut -d' ' -f1)
+	local osc=osc.$FSNAME-OST0000-osc-${inst#$FSNAME-}
+
+	$LCTL get_param -n $osc.connect_flags | grep -q ast_alive ||
+		{ skip "OST does not count AST replies as pings" && return; }
+
+	local interval=$(($($LCTL get_param -n timeout) / 4))
+	[ $interval -ge 3 ] || { skip "ping interval too short" && return; }
+
+	# $MOUNT1 keeps a PW lock on the object and then stays idle, the OST
+	# glimpses that lock for every stat through $MOUNT2.  A blocking AST
+	# would not do, the cancel sent after it puts off the ping as well.
+	$LFS setstripe -c 1 -i 0 $DIR1/$tfile || error "setstripe failed"
+	dd if=/dev/zero of=$DIR1/$tfile bs=4k count=1 conv=fsync ||
+		error "write failed"
+
+	local cbd=ldlm.services.ldlm_cbd.stats
+	local pings=$(stats_count $osc.stats obd_ping)
+	local glimpses=$(stats_count $cbd ldlm_gl_callback)
+	local end=$((SECONDS + 3 * interval))
+
+	while [ $SECONDS -lt $end ]; do
+		stat $DIR2/$tfile > /dev/null || error "stat $DIR2/$tfile failed"
+		sleep 1
+	done
+
+	[ $(stats_count $cbd ldlm_gl_callback) -gt $glimpses ] ||
+		error "no glimpse AST sent to $MOUNT1"
+	local sent=$(($(stats_count $osc.stats obd_ping) - pings))
+	[ $sent -eq 0 ] || error "$sent pings sent while answering glimpses"
+	rm -f $DIR1/$tfile
+}
+run_test 77 "imports answering ASTs are not pinged"
+
 log "cleanup: ======================================================"
 
 [ "$(mount | grep $MOUNT2)" ] && umount $MOUNT2
@@ -455,7 +455,7 @@ check_obd_connect_data(void)
 	CHECK_MEMBER(obd_connect_data, ocd_max_easize);
 	CHECK_MEMBER(obd_connect_data, ocd_instance);
 	CHECK_MEMBER(obd_connect_data, ocd_maxbytes);
-	CHECK_MEMBER(obd_connect_data, padding1);
+	CHECK_MEMBER(obd_connect_data, ocd_connect_flags2);
 	CHECK_MEMBER(obd_connect_data, padding2);
 	CHECK_MEMBER(obd_connect_data, padding3);
 	CHECK_MEMBER(obd_connect_data, padding4);
@@ -523,6 +523,11 @@ check_obd_connect_data(void)
 	CHECK_DEFINE_64X(OBD_CONNECT_SHORTIO);
 	CHECK_DEFINE_64X(OBD_CONNECT_PINGLESS);
 	CHECK_DEFINE_64X(OBD_CONNECT_FLOCK_DEAD);
+	CHECK_DEFINE_64X(OBD_CONNECT_OPEN_BY_FID);
+	CHECK_DEFINE_64X(OBD_CONNECT_LFSCK);
+	CHECK_DEFINE_64X(OBD_CONNECT_AST_ALIVE);
+	CHECK_DEFINE_64X(OBD_CONNECT_FLAGS2);
+	CHECK_DEFINE_64X(OBD_CONNECT2_BATCH_RPCS);
 
 	CHECK_VALUE_X(OBD_CKSUM_CRC32);
 	CHECK_VALUE_X(OBD_CKSUM_ADLER);
@@ -2026,6 +2031,15 @@ static void check_update_reply(void)
 	CHECK_MEMBER(update_reply, ur_lens);
 }
 
+static void check_batch_buf(void)
+{
+	BLANK_LINE();
+	CHECK_STRUCT(batch_buf);
+	CHECK_MEMBER(batch_buf, bb_magic);
+	CHECK_MEMBER(batch_buf, bb_count);
+	CHECK_MEMBER(batch_buf, bb_lens);
+}
+
 static void check_update(void)
 {
 	BLANK_LINE();
@@ -2176,6 +2190,8 @@ main(int argc, char **argv)
 	CHECK_VALUE(MDS_HSM_CT_REGISTER);
 	CHECK_VALUE(MDS_HSM_CT_UNREGISTER);
 	CHECK_VALUE(MDS_SWAP_LAYOUTS);
+	CHECK_VALUE(MDS_RMFID);
+	CHECK_VALUE(MDS_BATCH);
 	CHECK_VALUE(MDS_LAST_OPC);
 
 	CHECK_VALUE(REINT_SETATTR);
@@ -2430,6 +2446,7 @@ main(int argc, char **argv)
 	check_update_buf();
 	check_update_reply();
 	check_update();
+	check_batch_buf();
 
 	printf("}\n\n");
 